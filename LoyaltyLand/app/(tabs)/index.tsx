@@ -1,5 +1,7 @@
 import { View, StyleSheet } from 'react-native';
-import BusinessDashboard from '../BusinessDashboard';
+import { lazyScreen } from '@/components/lazy-screen';
+
+const BusinessDashboard = lazyScreen(() => import('@/components/BusinessDashboard'));
 
 export default function Page() {
   return (
@@ -12,4 +14,4 @@ export default function Page() {
 
 const styles = StyleSheet.create({
   container: { flex: 1, backgroundColor: '#fff' },
-});
\ No newline at end of file
+});
@@ -1,50 +1,56 @@
-import { doc, onSnapshot } from 'firebase/firestore';
-import { db, auth } from '../constants/firebaseConfig';
-import * as Location from 'expo-location';
+import React, { useState, useEffect } from 'react';
+import { View, Text, Button, StyleSheet } from 'react-native';
+import { getDb, auth } from '../constants/firebaseConfig';
 
+const WALLET_PAGE = 20;
+
+// Points live in users/{uid}/points/{bizId}. The listener only covers the
+// businesses on screen, most recently scanned first, and a scan sends
+// just the one document that changed. Every file under app/ is a route
+// and loads at startup, so the Firestore SDK is only imported once the
+// wallet mounts.
 export const UserWallet = ({ userId }) => {
-  const [points, setPoints] = useState({});
+  const [points, setPoints] = useState([]);
+  const [shown, setShown] = useState(WALLET_PAGE);
 
   useEffect(() => {
-    const unsub = onSnapshot(doc(db, "users", userId), (doc) => {
-      if (doc.exists()) {
-        setPoints(doc.data().points || {});
-      }
+    let unsub = null;
+    let cancelled = false;
+    import('firebase/firestore').then(({ collection, query, orderBy, limit, onSnapshot }) => {
+      if (cancelled) return;
+      const visible = query(
+        collection(getDb(), "users", userId, "points"),
+        orderBy("updatedAt", "desc"),
+        limit(shown)
+      );
+      unsub = onSnapshot(visible, (snapshot) => {
+        setPoints(snapshot.docs.map((d) => ({ bizId: d.id, points: d.data().points || 0 })));
+      });
     });
-    return unsub;
-  }, [userId]);
+    return () => {
+      cancelled = true;
+      if (unsub) unsub();
+    };
+  }, [userId, shown]);
 
   return (
     <View>
       <Text style={styles.title}>Your Local Impact</Text>
-      {Object.entries(points).map(([bizId, val]) => (
+      {points.map(({ bizId, points: val }) => (
         <View key={bizId} style={styles.card}>
           <Text>{bizId}</Text>
           <Text style={styles.bold}>{val} Points</Text>
         </View>
       ))}
+      {points.length === shown && (
+        <Button title="Show more" onPress={() => setShown(shown + WALLET_PAGE)} />
+      )}
     </View>
   );
 };
 
-const startOrbMonitoring = async () => {
-  //Request Permissions
-  const { status } = await Location.requestForegroundPermissionsAsync();
-  if (status !== 'granted') {
-    alert('Permission to access location was denied');
-    return;
-  }
-
-  await Location.startGeofencingAsync(GEOFENCE_TASK_NAME, [
-    {
-      identifier: 'Jacob_Alejandro_Troy', //example loc
-      latitude: 42.7314, 
-      longitude: -73.6908,
-      radius: 50, // 50 meters (roughly half a block on River St)
-      notifyOnEnter: true,
-      notifyOnExit: true,
-    }
-  ]);
-
-  console.log("Orb Monitoring Active for River Street!");
-};
\ No newline at end of file
+const styles = StyleSheet.create({
+  title: { fontSize: 20, fontWeight: 'bold', marginBottom: 10 },
+  card: { flexDirection: 'row', justifyContent: 'space-between', padding: 12, marginBottom: 8, borderRadius: 8, backgroundColor: '#f2f2f2' },
+  bold: { fontWeight: 'bold' },
+});
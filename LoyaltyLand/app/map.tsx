@@ -0,0 +1,8 @@
+import { lazyScreen } from '@/components/lazy-screen';
+
+// Maps SDK + Firestore only load once someone opens the map
+const OrbMapScreen = lazyScreen(() => import('@/components/orb-map'));
+
+export default function MapPage() {
+  return <OrbMapScreen />;
+}
@@ -0,0 +1,10 @@
+import { useRouter } from 'expo-router';
+import { lazyScreen } from '@/components/lazy-screen';
+
+// Camera + Firestore only load once someone opens the scanner
+const ScannerScreen = lazyScreen(() => import('@/components/QRScanner'));
+
+export default function ScanPage() {
+  const router = useRouter();
+  return <ScannerScreen navigation={{ goBack: router.back }} />;
+}
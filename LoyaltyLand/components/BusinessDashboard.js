@@ -1,7 +1,11 @@
 import React, { useState } from 'react';
 import { ScrollView, StyleSheet, Text, View, TextInput, Button } from 'react-native';
-import { doc, setDoc, updateDoc, arrayUnion } from 'firebase/firestore';
-import { db } from '../constants/firebaseConfig';
+import { getDb } from '../constants/firebaseConfig';
+
+// Kept out of app/, where every file is a route that a release build
+// loads at startup; app/(tabs)/index.tsx loads it through lazyScreen. The
+// Firestore and location SDKs are imported when a button needs them
+// rather than up here.
 
 // --- SUB-COMPONENT 1: Profile & Wares ---
 export const BusinessProfile = ({ orgId, orgData }) => {
@@ -9,7 +13,8 @@ export const BusinessProfile = ({ orgId, orgData }) => {
   const [newPrice, setNewPrice] = useState('');
 
   const addWare = async () => {
-    const orgRef = doc(db, "organizations", orgId);
+    const { doc, setDoc, arrayUnion } = await import('firebase/firestore');
+    const orgRef = doc(getDb(), "organizations", orgId);
     
     // Changing updateDoc to setDoc with merge: true
     try {
@@ -44,39 +49,86 @@ export const BusinessProfile = ({ orgId, orgData }) => {
 };
 
 // --- SUB-COMPONENT 2: Create Event ---
-import { collection, addDoc, GeoPoint, Timestamp } from 'firebase/firestore';
-import * as Location from 'expo-location';
+import { ORB_MODES } from 'orb-preview';
+import { OrbPreview } from './orb-preview';
+import { ringCentre, validRing } from '../services/eventBoundary';
+
+// Corners a dashboard user can mark before launching. Only this form
+// limits it; a boundary written some other way can have more.
+const MAX_BOUNDARY_CORNERS = 64;
 
 export const CreateEvent = ({ orgId }) => {
   const [eventName, setEventName] = useState('');
   const [points, setPoints] = useState('50');
   const [eventDate, setEventDate] = useState('');
+  const [orbColor, setOrbColor] = useState('G');
+  const [pulseSpeed, setPulseSpeed] = useState('20');
+  // Boundary corners as [latitude, longitude], marked by walking round the
+  // venue (services/eventBoundary.js). None means a circle at the launch spot.
+  const [corners, setCorners] = useState([]);
+
+  const currentPosition = async () => {
+    const Location = await import('expo-location');
+    let { status } = await Location.requestForegroundPermissionsAsync();
+    if (status !== 'granted') {
+      alert('Permission to access location was denied');
+      return null;
+    }
+    return Location.getCurrentPositionAsync({ accuracy: Location.Accuracy.High });
+  };
+
+  const markCorner = async () => {
+    if (corners.length >= MAX_BOUNDARY_CORNERS) {
+      return alert(`A boundary can have at most ${MAX_BOUNDARY_CORNERS} corners.`);
+    }
+    try {
+      const location = await currentPosition();
+      if (!location) return;
+      const { latitude, longitude } = location.coords;
+      setCorners((c) => [...c, [latitude, longitude]]);
+    } catch (e) {
+      console.error(e);
+      alert("Couldn't get your location.");
+    }
+  };
 
   const launchEvent = async () => {
     if (!eventName) return alert("Please name your event!");
+    if (corners.length > 0 && corners.length < 3) {
+      return alert("A boundary needs at least 3 corners. Mark more, or clear them.");
+    }
+    if (corners.length > 0 && !validRing(corners)) {
+      return alert("Those corners don't enclose any area. Clear them and mark the venue again.");
+    }
 
     try {
-      //Get current GPS Location
-      let { status } = await Location.requestForegroundPermissionsAsync();
-      if (status !== 'granted') {
-        alert('Permission to access location was denied');
-        return;
+      //Get current GPS Location, or the middle of the boundary
+      let centre = corners.length > 0 ? ringCentre(corners) : null;
+      if (!centre) {
+        const location = await currentPosition();
+        if (!location) return;
+        centre = location.coords;
       }
-
-      let location = await Location.getCurrentPositionAsync({});
       
       //Save to "events" collection
-      await addDoc(collection(db, "events"), {
+      const { collection, addDoc, GeoPoint, Timestamp } = await import('firebase/firestore');
+      const boundary = corners.map(([lat, lon]) => new GeoPoint(lat, lon));
+      await addDoc(collection(getDb(), "events"), {
         orgId: orgId,
         name: eventName,
         points: parseInt(points),
         dateString: eventDate, // Storing as string for easy display
+        orbColor: orbColor,
+        pulseSpeed: parseInt(pulseSpeed) || 20,
         createdAt: Timestamp.now(),
-        coordinates: new GeoPoint(location.coords.latitude, location.coords.longitude)
+        coordinates: new GeoPoint(centre.latitude, centre.longitude),
+        ...(boundary.length > 0 && { boundary })
       });
 
       setEventName('');
-      alert(`Orb Launched! Your teammate's map can now see "${eventName}" at your current location.`);
+      setCorners([]);
+      const where = boundary.length > 0 ? "inside your boundary" : "at your current location";
+      alert(`Orb Launched! Your teammate's map can now see "${eventName}" ${where}.`);
     } catch (e) {
       console.error(e);
       alert("Error launching event.");
@@ -110,7 +162,37 @@ export const CreateEvent = ({ orgId }) => {
         />
       </View>
 
-      <Text style={styles.subtext}>This will drop an Orb at your current GPS coordinates.</Text>
+      <Text style={styles.label}>Orb Look</Text>
+      <View style={{ flexDirection: 'row', gap: 10 }}>
+        {ORB_MODES.map((mode) => (
+          <Button key={mode} title={mode} onPress={() => setOrbColor(mode)} color={mode === orbColor ? '#1c1e21' : '#999'}/>
+        ))}
+        <TextInput 
+          value={pulseSpeed} 
+          onChangeText={setPulseSpeed} 
+          placeholder="Pulse (ms)" 
+          keyboardType="numeric" 
+          style={[styles.input, { flex: 1 }]}
+        />
+      </View>
+      <OrbPreview mode={orbColor} pulseSpeed={parseInt(pulseSpeed) || 20} />
+
+      <Text style={styles.label}>Boundary</Text>
+      <View style={{ flexDirection: 'row', gap: 10 }}>
+        <Button title="Mark corner here" onPress={markCorner}/>
+        <Button
+          title="Clear"
+          onPress={() => setCorners([])}
+          color="#999"
+          disabled={corners.length === 0}
+        />
+      </View>
+      <Text style={styles.subtext}>
+        {corners.length > 0
+          ? `${corners.length} corner(s) marked. The Orb covers the area inside them.`
+          : "This will drop an Orb at your current GPS coordinates. To cover a whole venue, "
+            + "walk its edge and mark each corner."}
+      </Text>
       <Button title="Launch Event" onPress={launchEvent} color="#F5A623"/>
     </View>
   );
@@ -1,12 +1,58 @@
-import React, { useState, useEffect } from "react";
+import React, { useState, useRef } from "react";
 import { Text, View, StyleSheet, Button } from "react-native";
 import { CameraView, useCameraPermissions } from "expo-camera";
-import { doc, updateDoc, increment } from "firebase/firestore";
-import { db, auth } from "../firebaseConfig";
+import { doc, writeBatch, increment, serverTimestamp } from "firebase/firestore";
+import { getDb, auth } from "../constants/firebaseConfig";
+import {
+  createScanPipeline,
+  createPointsWriter,
+  POINTS_PER_SCAN,
+} from "../services/scanPipeline";
+
+// One batch for everything scanned while the last write was in flight.
+// Each business has its own document, users/{uid}/points/{bizId}, so
+// scans at different businesses don't queue up behind one another.
+function writePoints(counts) {
+  const db = getDb();
+  const batch = writeBatch(db);
+  for (const [code, n] of counts) {
+    batch.set(
+      doc(db, "users", auth.currentUser.uid, "points", code),
+      { points: increment(POINTS_PER_SCAN * n), updatedAt: serverTimestamp() },
+      { merge: true }
+    );
+  }
+  return batch.commit();
+}
+
+// Codes accepted within the repeat window (services/scanPipeline.js).
+// Module-level so closing and reopening the scanner doesn't reset it.
+const recentScans = new Map();
 
 export default function ScannerScreen({ navigation }) {
   const [permission, requestPermission] = useCameraPermissions();
-  const [scanned, setScanned] = useState(false);
+  const [status, setStatus] = useState(null);
+
+  // Built once: the camera callback stays the same function, so the
+  // scanner is never torn down and re-armed between scans
+  const pipeline = useRef(null);
+  if (!pipeline.current) {
+    const writer = createPointsWriter({
+      write: writePoints,
+      onResult: (codes, error) => {
+        if (!error) return;
+        for (const code of codes) pipeline.current.forget(code);
+        setStatus(`Couldn't add points for ${codes.join(", ")}`);
+      },
+    });
+    pipeline.current = createScanPipeline({
+      recent: recentScans,
+      onAccept: (code) => {
+        writer.add(code);
+        setStatus(`Points added for ${code}!`);
+      },
+    });
+  }
 
   if (!permission) return <View />;
   if (!permission.granted) {
@@ -18,34 +64,36 @@ export default function ScannerScreen({ navigation }) {
     );
   }
 
-  const handleBarCodeScanned = async ({ data }) => {
-    setScanned(true);
-    
-    //QR code 'data' would be the BusinessID or EventID
-    try {
-      const userRef = doc(db, "users", auth.currentUser.uid);
-      await updateDoc(userRef, {
-        [`points.${data}`]: increment(10) // Award 10 points for scanning
-      });
-      alert(`Points added for ${data}!`);
-      navigation.goBack();
-    } catch (e) {
-      alert("Error adding points");
-    }
-  };
+  //QR code 'data' would be the BusinessID or EventID
+  const handleBarCodeScanned = ({ data }) => pipeline.current.offer(data);
 
   return (
     <View style={styles.container}>
       <CameraView
-        onBarcodeScanned={scanned ? undefined : handleBarCodeScanned}
+        onBarcodeScanned={handleBarCodeScanned}
         barcodeScannerSettings={{ barcodeTypes: ["qr"] }}
         style={StyleSheet.absoluteFillObject}
       />
-      {scanned && <Button title="Tap to Scan Again" onPress={() => setScanned(false)} />}
+      {status && (
+        <View style={styles.banner}>
+          <Text style={styles.bannerText}>{status}</Text>
+          <Button title="Done" onPress={() => navigation.goBack()} />
+        </View>
+      )}
     </View>
   );
 }
 
 const styles = StyleSheet.create({
-  container: { flex: 1, justifyContent: "center" }
-});
\ No newline at end of file
+  container: { flex: 1, justifyContent: "center" },
+  banner: {
+    position: "absolute",
+    bottom: 40,
+    left: 20,
+    right: 20,
+    padding: 12,
+    borderRadius: 8,
+    backgroundColor: "rgba(0,0,0,0.7)",
+  },
+  bannerText: { color: "#fff", textAlign: "center", marginBottom: 8 },
+});
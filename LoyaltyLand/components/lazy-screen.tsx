@@ -0,0 +1,27 @@
+import { ComponentType, lazy, Suspense } from 'react';
+import { ActivityIndicator, StyleSheet, View } from 'react-native';
+
+// Heavy screens (Firestore, camera, maps) are kept out of the startup bundle
+// and only loaded the first time their route renders.
+export function lazyScreen<P extends object>(
+  load: () => Promise<{ default: ComponentType<P> }>
+) {
+  const Screen = lazy(load);
+
+  return function LazyScreen(props: P) {
+    return (
+      <Suspense
+        fallback={
+          <View style={styles.loading}>
+            <ActivityIndicator size="large" color="#2563eb" />
+          </View>
+        }>
+        <Screen {...props} />
+      </Suspense>
+    );
+  };
+}
+
+const styles = StyleSheet.create({
+  loading: { flex: 1, justifyContent: 'center', alignItems: 'center' },
+});
@@ -0,0 +1,97 @@
+import { createContext, ReactNode, useContext, useEffect, useMemo, useRef } from 'react';
+import { SharedValue, useFrameCallback, useSharedValue } from 'react-native-reanimated';
+
+type OrbClock = {
+  // ms since the clock started, advanced once per frame on the UI thread
+  time: SharedValue<number>;
+  // mode -> one pulse period as ready-made colour strings
+  colours: SharedValue<Record<string, string[]>>;
+  // mode -> its brightest step, for places that can only show a still
+  peaks: SharedValue<Record<string, string>>;
+  retain: () => () => void;
+};
+
+const OrbClockContext = createContext<OrbClock | null>(null);
+
+// One period per mode from the firmware's C++ core (OrbCore.h). The native
+// module is only loaded the first time an orb is shown.
+function buildColours() {
+  const { ORB_MODES, renderPeriod } = require('orb-preview');
+  const colours: Record<string, string[]> = {};
+  const peaks: Record<string, string> = {};
+  for (const mode of ORB_MODES as readonly string[]) {
+    const levels: number[] = renderPeriod(mode);
+    const steps: string[] = [];
+    let peak = 0;
+    // Pin levels are common anode: 0 is full on
+    for (let i = 0; i < levels.length; i += 3) {
+      steps.push(`rgb(${255 - levels[i]}, ${255 - levels[i + 1]}, ${255 - levels[i + 2]})`);
+      const sum = levels[i] + levels[i + 1] + levels[i + 2];
+      if (sum < levels[peak * 3] + levels[peak * 3 + 1] + levels[peak * 3 + 2]) peak = i / 3;
+    }
+    colours[mode] = steps;
+    peaks[mode] = steps[peak];
+  }
+  return { colours, peaks };
+}
+
+// Every pulsing orb on screen (previews, map markers) reads this one clock
+// instead of running its own frame callback. It only ticks while at least
+// one orb is mounted.
+export function OrbClockProvider({ children }: { children: ReactNode }) {
+  const time = useSharedValue(0);
+  const colours = useSharedValue<Record<string, string[]>>({});
+  const peaks = useSharedValue<Record<string, string>>({});
+  const users = useRef(0);
+  const frames = useFrameCallback((frame) => {
+    time.value = frame.timeSinceFirstFrame;
+  }, false);
+
+  const clock = useMemo<OrbClock>(
+    () => ({
+      time,
+      colours,
+      peaks,
+      retain() {
+        if (users.current++ === 0) {
+          if (Object.keys(colours.value).length === 0) {
+            const built = buildColours();
+            colours.value = built.colours;
+            peaks.value = built.peaks;
+          }
+          frames.setActive(true);
+        }
+        return () => {
+          if (--users.current === 0) frames.setActive(false);
+        };
+      },
+    }),
+    // eslint-disable-next-line react-hooks/exhaustive-deps
+    []
+  );
+
+  return <OrbClockContext.Provider value={clock}>{children}</OrbClockContext.Provider>;
+}
+
+export function useOrbClock() {
+  const clock = useContext(OrbClockContext);
+  if (!clock) throw new Error('useOrbClock needs an OrbClockProvider above it');
+  useEffect(() => clock.retain(), [clock]);
+  return clock;
+}
+
+// Colour of an orb at the clock's current time. phase (ms) offsets orbs
+// that started at different moments, as the real ones do.
+export function orbColour(clock: OrbClock, mode: string, pulseSpeed: number, phase: number) {
+  'worklet';
+  const steps = clock.colours.value[mode];
+  if (!steps) return 'transparent';
+  const i = Math.floor((clock.time.value + phase) / Math.max(1, pulseSpeed)) % steps.length;
+  return steps[i];
+}
+
+// The mode's brightest colour, for an orb that can't animate
+export function orbPeakColour(clock: OrbClock, mode: string) {
+  'worklet';
+  return clock.peaks.value[mode] ?? 'transparent';
+}
@@ -0,0 +1,133 @@
+import { memo, useEffect, useMemo, useState } from 'react';
+import { Platform, StyleSheet, View } from 'react-native';
+import MapView, { Marker, Region } from 'react-native-maps';
+import Animated, { useAnimatedStyle } from 'react-native-reanimated';
+import { collection, onSnapshot } from 'firebase/firestore';
+import { getDb } from '@/constants/firebaseConfig';
+import { orbColour, orbPeakColour, useOrbClock } from './orb-clock';
+
+export type MapOrb = {
+  id: string;
+  latitude: number;
+  longitude: number;
+  mode: string;
+  pulseSpeed: number;
+};
+
+type Clock = ReturnType<typeof useOrbClock>;
+
+const RIVER_STREET: Region = {
+  latitude: 42.7314,
+  longitude: -73.6908,
+  latitudeDelta: 0.02,
+  longitudeDelta: 0.02,
+};
+
+// Kept past each edge, as a share of the span, so a short pan doesn't
+// show empty map before the region settles
+const CULL_MARGIN = 0.25;
+
+// Only orbs inside the region (plus margin) get a marker at all
+export function visibleOrbs(orbs: MapOrb[], region: Region) {
+  const lat = region.latitudeDelta * (0.5 + CULL_MARGIN);
+  const lng = region.longitudeDelta * (0.5 + CULL_MARGIN);
+  return orbs.filter(
+    (o) =>
+      Math.abs(o.latitude - region.latitude) <= lat &&
+      Math.abs(o.longitude - region.longitude) <= lng
+  );
+}
+
+// Real orbs were switched on at different times; a stable offset per orb
+// keeps the map from pulsing in lockstep
+function phaseOf(id: string) {
+  let h = 0;
+  for (let i = 0; i < id.length; i++) h = (h * 31 + id.charCodeAt(i)) | 0;
+  return Math.abs(h) % 10000;
+}
+
+// Android draws a custom marker as a bitmap, and while tracksViewChanges
+// is on it redraws that bitmap every frame, for every marker
+const STILL_MARKERS = Platform.OS === 'android';
+
+// No frame callback of its own: the colour is worked out from the shared
+// clock in a worklet, so a frame costs one table read per marker.
+// tracksViewChanges is only on until the dot has been drawn once (and
+// again when its mode or speed changes). On iOS the view stays live and
+// keeps pulsing; on Android the marker is a still of its brightest colour.
+const OrbMarker = memo(function OrbMarker({ orb, clock }: { orb: MapOrb; clock: Clock }) {
+  const { mode, pulseSpeed } = orb;
+  const phase = phaseOf(orb.id);
+  const style = useAnimatedStyle(() => ({
+    backgroundColor: STILL_MARKERS
+      ? orbPeakColour(clock, mode)
+      : orbColour(clock, mode, pulseSpeed, phase),
+  }));
+
+  const [tracking, setTracking] = useState(true);
+  useEffect(() => setTracking(true), [mode, pulseSpeed]);
+  useEffect(() => {
+    if (!tracking) return;
+    // One frame after layout, so the colour is in the snapshot
+    const frame = requestAnimationFrame(() => setTracking(false));
+    return () => cancelAnimationFrame(frame);
+  }, [tracking, mode, pulseSpeed]);
+
+  return (
+    <Marker
+      coordinate={{ latitude: orb.latitude, longitude: orb.longitude }}
+      anchor={{ x: 0.5, y: 0.5 }}
+      tracksViewChanges={tracking}>
+      <Animated.View style={[styles.dot, style]} />
+    </Marker>
+  );
+});
+
+export function OrbMap({ orbs }: { orbs: MapOrb[] }) {
+  const clock = useOrbClock();
+  const [region, setRegion] = useState(RIVER_STREET);
+  const visible = useMemo(() => visibleOrbs(orbs, region), [orbs, region]);
+
+  return (
+    <MapView style={styles.map} initialRegion={RIVER_STREET} onRegionChangeComplete={setRegion}>
+      {visible.map((orb) => (
+        <OrbMarker key={orb.id} orb={orb} clock={clock} />
+      ))}
+    </MapView>
+  );
+}
+
+// Every event with a location, pulsing the way its orb does
+export default function OrbMapScreen() {
+  const [orbs, setOrbs] = useState<MapOrb[]>([]);
+
+  useEffect(() => {
+    return onSnapshot(collection(getDb(), 'events'), (snapshot) => {
+      const next: MapOrb[] = [];
+      snapshot.forEach((doc) => {
+        const event = doc.data();
+        if (!event.coordinates) return;
+        next.push({
+          id: doc.id,
+          latitude: event.coordinates.latitude,
+          longitude: event.coordinates.longitude,
+          mode: event.orbColor || 'G',
+          pulseSpeed: event.pulseSpeed || 20,
+        });
+      });
+      setOrbs(next);
+    });
+  }, []);
+
+  return (
+    <View style={styles.container}>
+      <OrbMap orbs={orbs} />
+    </View>
+  );
+}
+
+const styles = StyleSheet.create({
+  container: { flex: 1 },
+  map: { flex: 1 },
+  dot: { width: 18, height: 18, borderRadius: 9, borderWidth: 2, borderColor: '#1c1e21' },
+});
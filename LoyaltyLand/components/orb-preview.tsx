@@ -0,0 +1,30 @@
+import { StyleSheet } from 'react-native';
+import Animated, { useAnimatedStyle } from 'react-native-reanimated';
+import { orbColour, useOrbClock } from './orb-clock';
+
+type OrbPreviewProps = {
+  mode: string;
+  pulseSpeed: number;
+  size?: number;
+};
+
+// Shows what the physical orb will do. Pulse periods come from the
+// firmware's C++ core (see orb-clock.tsx); each frame the UI thread just
+// indexes into them, so nothing crosses to JS while it animates.
+export function OrbPreview({ mode, pulseSpeed, size = 96 }: OrbPreviewProps) {
+  const clock = useOrbClock();
+
+  const animatedStyle = useAnimatedStyle(() => ({
+    backgroundColor: orbColour(clock, mode, pulseSpeed, 0),
+  }));
+
+  return (
+    <Animated.View
+      style={[styles.orb, { width: size, height: size, borderRadius: size / 2 }, animatedStyle]}
+    />
+  );
+}
+
+const styles = StyleSheet.create({
+  orb: { alignSelf: 'center', borderWidth: 2, borderColor: '#1c1e21', marginVertical: 10 },
+});
@@ -0,0 +1,72 @@
+import { useEffect, useRef } from 'react';
+import { StyleSheet, View } from 'react-native';
+// Not the package root: that loads the TurboModule, which the web lacks
+import { WASM_URL, loadOrbSim } from 'orb-preview/src/orbSim';
+
+type OrbPreviewProps = {
+  mode: string;
+  pulseSpeed: number;
+  size?: number;
+};
+
+// Web build of OrbPreview. The orb's sketch runs in the page (WebAssembly;
+// in development, its JS port if that isn't built; see
+// modules/orb-preview/src/orbSim.js)
+// and is sent the same Serial1 commands the orb would get. Each animation
+// frame runs it up to now and paints its pins straight onto the element,
+// without a React render.
+export function OrbPreview({ mode, pulseSpeed, size = 96 }: OrbPreviewProps) {
+  const view = useRef<View>(null);
+  const orb = useRef<Awaited<ReturnType<typeof createOrb>> | null>(null);
+  const command = `${pulseSpeed}${mode}`;
+  const latest = useRef(command);
+  latest.current = command;
+
+  useEffect(() => {
+    let frame = 0;
+    let stopped = false;
+    createOrb().then(
+      (created) => {
+        if (stopped) return;
+        orb.current = created;
+        created.write(latest.current);
+        const paint = (now: number) => {
+          created.run(now);
+          const [r, g, b] = created.pins;
+          // Pin levels are common anode: 0 is full on
+          const element = view.current as unknown as HTMLElement | null;
+          if (element) element.style.backgroundColor = `rgb(${255 - r}, ${255 - g}, ${255 - b})`;
+          frame = requestAnimationFrame(paint);
+        };
+        frame = requestAnimationFrame(paint);
+      },
+      // No sketch to run: the orb stays blank rather than showing a copy
+      (e) => console.error(e)
+    );
+    return () => {
+      stopped = true;
+      cancelAnimationFrame(frame);
+      orb.current = null;
+    };
+  }, []);
+
+  useEffect(() => {
+    orb.current?.write(command);
+  }, [command]);
+
+  return (
+    <View
+      ref={view}
+      style={[styles.orb, { width: size, height: size, borderRadius: size / 2 }]}
+    />
+  );
+}
+
+async function createOrb() {
+  const sim = await loadOrbSim(WASM_URL, { fallback: __DEV__ });
+  return sim.create(Math.floor(Math.random() * 0x10000));
+}
+
+const styles = StyleSheet.create({
+  orb: { alignSelf: 'center', borderWidth: 2, borderColor: '#1c1e21', marginVertical: 10 },
+});
@@ -1,6 +1,5 @@
 import { initializeApp } from "firebase/app";
 import { getAuth } from "firebase/auth";
-import { getFirestore } from "firebase/firestore";
 
 // Your web app's Firebase configuration
 // For Firebase JS SDK v7.20.0 and later, measurementId is optional
@@ -17,6 +16,16 @@ const firebaseConfig = {
 // Initialize Firebase
 const app = initializeApp(firebaseConfig);
 
-// Initialize Services
+// Auth gates the first screen, so it starts right away
 export const auth = getAuth(app);
-export const db = getFirestore(app);
\ No newline at end of file
+
+// Firestore is only loaded and set up the first time something needs it,
+// which keeps its SDK off the cold-start path
+let db = null;
+export function getDb() {
+  if (!db) {
+    const { getFirestore } = require("firebase/firestore");
+    db = getFirestore(app);
+  }
+  return db;
+}
\ No newline at end of file
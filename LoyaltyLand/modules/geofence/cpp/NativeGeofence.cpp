@@ -0,0 +1,27 @@
+#include "NativeGeofence.h"
+
+namespace facebook::react {
+
+NativeGeofence::NativeGeofence(std::shared_ptr<CallInvoker> jsInvoker)
+    : NativeGeofenceCxxSpec(std::move(jsInvoker)) {}
+
+int NativeGeofence::setFences(jsi::Runtime &, std::vector<std::vector<double>> rings) {
+  fences_ = FenceIndex();
+  int rejected = 0;
+  for (const std::vector<double> &flat : rings) {
+    std::vector<FencePoint> ring;
+    ring.reserve(flat.size() / 2);
+    for (size_t i = 0; i + 1 < flat.size(); i += 2) ring.push_back({flat[i], flat[i + 1]});
+    if (!fences_.add(std::move(ring))) rejected++;
+  }
+  fences_.build();
+  return rejected;
+}
+
+std::vector<int> NativeGeofence::fencesAt(jsi::Runtime &, double latitude, double longitude) {
+  hits_.clear();
+  fences_.at(longitude, latitude, hits_);
+  return std::vector<int>(hits_.begin(), hits_.end());
+}
+
+} // namespace facebook::react
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <GeofenceSpecJSI.h>
+
+#include "PolygonFences.h"
+
+#include <memory>
+#include <vector>
+
+namespace facebook::react {
+
+// C++ TurboModule over PolygonFences.h, so a fix is tested against every
+// polygon event boundary in one call
+class NativeGeofence : public NativeGeofenceCxxSpec<NativeGeofence> {
+ public:
+  explicit NativeGeofence(std::shared_ptr<CallInvoker> jsInvoker);
+
+  int setFences(jsi::Runtime &rt, std::vector<std::vector<double>> rings);
+  std::vector<int> fencesAt(jsi::Runtime &rt, double latitude, double longitude);
+
+ private:
+  FenceIndex fences_;
+  std::vector<uint32_t> hits_;
+};
+
+} // namespace facebook::react
@@ -0,0 +1,358 @@
+#pragma once
+
+// Point-in-polygon for events whose boundary is drawn as a polygon (a
+// storefront, a stadium section) rather than a circle round a GeoPoint.
+//
+// Each polygon gets a uniform grid over its bounding box, worked out once.
+// A cell no edge touches is wholly inside or wholly outside, so a point
+// there costs one read. A point in a cell an edge passes through runs the
+// ray cast, but only over the edges that can cross its ray: those in the
+// cell's row that reach the cell's column. Either way the answer is the
+// plain ray cast's (rayCastContains), points on an edge included.
+//
+// A ring with fewer than 3 corners, no area, or a coordinate that isn't a
+// finite number is rejected: it contains nothing and stays out of
+// FenceIndex's bounds.
+//
+// FenceIndex keeps many polygons behind a coarse grid of their bounding
+// boxes, for "which fences is this point in". Coordinates are longitude
+// and latitude used as a plane, which over a venue is as straight as the
+// edges were drawn. PhysicalOrbComponent/host/polygon_fence_bench.cpp
+// checks and times it against the plain ray cast. The app reaches it
+// through this module's TurboModule (NativeGeofence), and
+// services/eventBoundary.js applies the same rules to rings in JS.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct FencePoint {
+  double x, y; // longitude, latitude
+};
+
+// W. R. Franklin's pnpoly: a ray to the right, counting the edges it
+// crosses. Each edge is (ring[i], ring[i - 1]).
+inline bool fenceEdgeCrosses(const FencePoint &a, const FencePoint &b, double x, double y) {
+  return (a.y > y) != (b.y > y) && x < (b.x - a.x) * (y - a.y) / (b.y - a.y) + a.x;
+}
+
+inline bool rayCastContains(const FencePoint *ring, size_t n, double x, double y) {
+  bool inside = false;
+  for (size_t i = 0, j = n - 1; i < n; j = i++) {
+    if (fenceEdgeCrosses(ring[i], ring[j], x, y)) inside = !inside;
+  }
+  return inside;
+}
+
+class PolygonFence {
+ public:
+  enum Cell : uint8_t { outside, inside, boundary };
+
+  // cellsPerSide 0 picks one from the vertex count. The ring may or may
+  // not repeat its first vertex at the end.
+  explicit PolygonFence(std::vector<FencePoint> ring, int cellsPerSide = 0) {
+    if (ring.size() > 1 && ring.front().x == ring.back().x && ring.front().y == ring.back().y) {
+      ring.pop_back();
+    }
+    build(ring, cellsPerSide);
+  }
+
+  // False for a rejected ring
+  bool valid() const { return pad >= 0; }
+
+  bool contains(double x, double y) const {
+    if (!(x >= minX - pad && x <= maxX + pad && y >= minY - pad && y <= maxY + pad)) return false;
+    int r = rowOf(y), c = colOf(x);
+    size_t cell = (size_t)r * cols + c;
+    if (cells[cell] != boundary) return cells[cell] == inside;
+    return crossesOdd(r, reach[cell], x, y);
+  }
+
+  // Which kind of cell the point falls in; outside beyond the grid
+  Cell cellAt(double x, double y) const {
+    if (!(x >= minX - pad && x <= maxX + pad && y >= minY - pad && y <= maxY + pad)) return outside;
+    return (Cell)cells[(size_t)rowOf(y) * cols + colOf(x)];
+  }
+
+  double left() const { return minX; }
+  double right() const { return maxX; }
+  double bottom() const { return minY; }
+  double top() const { return maxY; }
+  size_t vertices() const { return edges.size(); }
+  int gridSide() const { return cols; }
+
+  // Share of the grid's cells an edge passes through
+  double boundaryShare() const {
+    size_t n = 0;
+    for (uint8_t cell : cells) n += cell == boundary;
+    return cells.empty() ? 0 : (double)n / cells.size();
+  }
+
+  size_t bytes() const {
+    return edges.capacity() * sizeof(Edge) + rowEdges.capacity() * sizeof(uint32_t) +
+           rowStart.capacity() * sizeof(uint32_t) + cells.capacity() +
+           reach.capacity() * sizeof(uint16_t) + sizeof(*this);
+  }
+
+ private:
+  struct Edge {
+    FencePoint a, b;
+    int lastCol; // rightmost column the edge can cross a ray in
+  };
+
+  // Tests in boundary cells only visit edges up to the cell's reach, so
+  // each row keeps its edges rightmost first
+  bool crossesOdd(int r, uint16_t count, double x, double y) const {
+    bool odd = false;
+    const uint32_t *edge = &rowEdges[rowStart[r]];
+    for (uint16_t i = 0; i < count; i++) {
+      const Edge &e = edges[edge[i]];
+      if (fenceEdgeCrosses(e.a, e.b, x, y)) odd = !odd;
+    }
+    return odd;
+  }
+
+  // Monotonic in x and y, and clamped to the grid, which is what lets an
+  // edge's rows and columns be worked out once from its extremes
+  int colOf(double x) const { return clampIndex((x - minX) * invW, cols); }
+  int rowOf(double y) const { return clampIndex((y - minY) * invH, rows); }
+
+  static int clampIndex(double v, int n) {
+    if (!(v > 0)) return 0;
+    return v >= n ? n - 1 : (int)v;
+  }
+
+  // Twice the signed area (shoelace), taken about the first corner's
+  // latitude so a straight line's rounding stays near zero
+  static double twiceArea(const std::vector<FencePoint> &ring) {
+    double sum = 0, y0 = ring[0].y;
+    for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+      sum += (ring[j].x - ring[i].x) * (ring[j].y + ring[i].y - 2 * y0);
+    }
+    return sum;
+  }
+
+  // Fewer than 3 corners, a coordinate that isn't finite, or an area
+  // that's rounding next to its bounding box's (a line, a repeated point)
+  bool rejected(const std::vector<FencePoint> &ring) const {
+    if (ring.size() < 3) return true;
+    for (const FencePoint &p : ring) {
+      if (!std::isfinite(p.x) || !std::isfinite(p.y)) return true;
+    }
+    double box = (maxX - minX) * (maxY - minY);
+    return !(std::fabs(twiceArea(ring)) > box * 1e-9);
+  }
+
+  void build(const std::vector<FencePoint> &ring, int cellsPerSide) {
+    // reach counts edges in 16 bits; no venue is drawn that finely
+    size_t n = ring.size();
+    if (n > 0) {
+      minX = maxX = ring[0].x;
+      minY = maxY = ring[0].y;
+    }
+    for (const FencePoint &p : ring) {
+      minX = std::min(minX, p.x);
+      maxX = std::max(maxX, p.x);
+      minY = std::min(minY, p.y);
+      maxY = std::max(maxY, p.y);
+    }
+    if (n > 65535 || rejected(ring)) {
+      minX = maxX = minY = maxY = 0;
+      pad = -1; // contains() is false everywhere
+      return;
+    }
+
+    // About two cells per vertex along each side keeps the boundary cells
+    // to a small share without the grid outgrowing the polygon
+    int side = cellsPerSide > 0 ? cellsPerSide : (int)std::ceil(2 * std::sqrt((double)n));
+    cols = rows = std::max(1, std::min(side, 64));
+    double w = std::max(maxX - minX, 1e-12) / cols;
+    double h = std::max(maxY - minY, 1e-12) / rows;
+    invW = 1 / w;
+    invH = 1 / h;
+    // Far wider than any rounding in a crossing or a cell index, far
+    // narrower than a cell: a cell within pad of an edge counts as touched
+    pad = std::max(w, h) * 1e-6;
+
+    edges.resize(n);
+    for (size_t i = 0, j = n - 1; i < n; j = i++) {
+      edges[i].a = ring[i];
+      edges[i].b = ring[j];
+      edges[i].lastCol = colOf(std::max(ring[i].x, ring[j].x) + pad);
+    }
+
+    // An edge can only cross the ray of a point whose y is in its span,
+    // so it's listed in the rows its span covers
+    rowStart.assign(rows + 1, 0);
+    for (const Edge &e : edges) {
+      int r0 = rowOf(std::min(e.a.y, e.b.y) - pad), r1 = rowOf(std::max(e.a.y, e.b.y) + pad);
+      for (int r = r0; r <= r1; r++) rowStart[r + 1]++;
+    }
+    for (int r = 0; r < rows; r++) rowStart[r + 1] += rowStart[r];
+    rowEdges.resize(rowStart[rows]);
+    std::vector<uint32_t> fill(rowStart.begin(), rowStart.end() - 1);
+    for (uint32_t i = 0; i < edges.size(); i++) {
+      const Edge &e = edges[i];
+      int r0 = rowOf(std::min(e.a.y, e.b.y) - pad), r1 = rowOf(std::max(e.a.y, e.b.y) + pad);
+      for (int r = r0; r <= r1; r++) rowEdges[fill[r]++] = i;
+    }
+    for (int r = 0; r < rows; r++) {
+      std::sort(rowEdges.begin() + rowStart[r], rowEdges.begin() + rowStart[r + 1],
+                [&](uint32_t p, uint32_t q) { return edges[p].lastCol > edges[q].lastCol; });
+    }
+
+    cells.assign((size_t)rows * cols, outside);
+    for (const Edge &e : edges) markTouched(e, w, h);
+
+    // A cell's reach: how many of its row's edges reach its column. A
+    // cell nothing touches takes its centre's answer for all of it.
+    reach.assign(cells.size(), 0);
+    for (int r = 0; r < rows; r++) {
+      uint32_t inRow = rowStart[r + 1] - rowStart[r];
+      const uint32_t *edge = &rowEdges[rowStart[r]];
+      uint32_t k = inRow;
+      for (int c = 0; c < cols; c++) {
+        while (k > 0 && edges[edge[k - 1]].lastCol < c) k--;
+        size_t cell = (size_t)r * cols + c;
+        reach[cell] = (uint16_t)k;
+        if (cells[cell] == boundary) continue;
+        double cx = minX + (c + 0.5) * w, cy = minY + (r + 0.5) * h;
+        cells[cell] = crossesOdd(r, (uint16_t)k, cx, cy) ? inside : outside;
+      }
+    }
+  }
+
+  // Every cell the edge passes within pad of, by the segment-box test: the
+  // boxes overlap and the box's corners aren't all on one side of the line
+  void markTouched(const Edge &e, double w, double h) {
+    double ex0 = std::min(e.a.x, e.b.x), ex1 = std::max(e.a.x, e.b.x);
+    double ey0 = std::min(e.a.y, e.b.y), ey1 = std::max(e.a.y, e.b.y);
+    int c0 = colOf(ex0 - pad), c1 = colOf(ex1 + pad);
+    int r0 = rowOf(ey0 - pad), r1 = rowOf(ey1 + pad);
+    double dx = e.b.x - e.a.x, dy = e.b.y - e.a.y;
+    for (int r = r0; r <= r1; r++) {
+      double y0 = minY + r * h - pad, y1 = minY + (r + 1) * h + pad;
+      for (int c = c0; c <= c1; c++) {
+        size_t cell = (size_t)r * cols + c;
+        if (cells[cell] == boundary) continue;
+        double x0 = minX + c * w - pad, x1 = minX + (c + 1) * w + pad;
+        double s0 = dx * (y0 - e.a.y) - dy * (x0 - e.a.x);
+        double s1 = dx * (y0 - e.a.y) - dy * (x1 - e.a.x);
+        double s2 = dx * (y1 - e.a.y) - dy * (x0 - e.a.x);
+        double s3 = dx * (y1 - e.a.y) - dy * (x1 - e.a.x);
+        bool allAbove = s0 > 0 && s1 > 0 && s2 > 0 && s3 > 0;
+        bool allBelow = s0 < 0 && s1 < 0 && s2 < 0 && s3 < 0;
+        if (!allAbove && !allBelow) cells[cell] = boundary;
+      }
+    }
+  }
+
+  double minX = 0, maxX = 0, minY = 0, maxY = 0;
+  double invW = 0, invH = 0, pad = 0;
+  int cols = 1, rows = 1;
+  std::vector<Edge> edges;
+  std::vector<uint32_t> rowStart; // rowEdges[rowStart[r] .. rowStart[r + 1]) is row r
+  std::vector<uint32_t> rowEdges;
+  std::vector<uint8_t> cells;
+  std::vector<uint16_t> reach;
+};
+
+// Many fences behind a uniform grid of their bounding boxes. at() appends
+// the index (in add() order) of every fence containing the point. A
+// rejected ring still takes an index, so they stay in step with the
+// caller's list, but it's in no cell.
+class FenceIndex {
+ public:
+  // False if the ring was rejected
+  bool add(std::vector<FencePoint> ring, int cellsPerSide = 0) {
+    fences.emplace_back(std::move(ring), cellsPerSide);
+    built = false;
+    return fences.back().valid();
+  }
+
+  size_t size() const { return fences.size(); }
+  const PolygonFence &fence(size_t i) const { return fences[i]; }
+
+  // The valid fences' bounds once built; infinite if there are none
+  double left() const { return minX; }
+  double right() const { return maxX; }
+  double bottom() const { return minY; }
+  double top() const { return maxY; }
+
+  // Cells about the size of an average fence, so a point usually has a
+  // handful of candidates
+  void build() {
+    built = true;
+    start.clear();
+    members.clear();
+    minX = minY = INFINITY;
+    maxX = maxY = -INFINITY;
+    double area = 0;
+    size_t valid = 0;
+    for (const PolygonFence &f : fences) {
+      if (!f.valid()) continue;
+      valid++;
+      minX = std::min(minX, f.left());
+      minY = std::min(minY, f.bottom());
+      maxX = std::max(maxX, f.right());
+      maxY = std::max(maxY, f.top());
+      area += (f.right() - f.left()) * (f.top() - f.bottom());
+    }
+    if (valid == 0) return;
+    double cell = std::sqrt(std::max(area / valid, 1e-14)) * 2;
+    cols = std::max(1, std::min(4096, (int)std::ceil((maxX - minX) / cell)));
+    rows = std::max(1, std::min(4096, (int)std::ceil((maxY - minY) / cell)));
+    invW = cols / std::max(maxX - minX, 1e-12);
+    invH = rows / std::max(maxY - minY, 1e-12);
+
+    start.assign((size_t)rows * cols + 1, 0);
+    forEachCell([&](size_t cell, uint32_t) { start[cell + 1]++; });
+    for (size_t i = 0; i + 1 < start.size(); i++) start[i + 1] += start[i];
+    members.resize(start.back());
+    std::vector<uint32_t> fill(start.begin(), start.end() - 1);
+    forEachCell([&](size_t cell, uint32_t i) { members[fill[cell]++] = i; });
+  }
+
+  // Fences whose bounding box the point's cell overlaps
+  template <typename Visit>
+  void candidates(double x, double y, Visit visit) const {
+    if (!built || start.empty()) return;
+    size_t cell = (size_t)index(y - minY, invH, rows) * cols + index(x - minX, invW, cols);
+    for (uint32_t i = start[cell]; i < start[cell + 1]; i++) visit(members[i]);
+  }
+
+  void at(double x, double y, std::vector<uint32_t> &out) const {
+    candidates(x, y, [&](uint32_t i) {
+      if (fences[i].contains(x, y)) out.push_back(i);
+    });
+  }
+
+ private:
+  static int index(double v, double inv, int n) {
+    double f = v * inv;
+    if (!(f > 0)) return 0;
+    return f >= n ? n - 1 : (int)f;
+  }
+
+  template <typename Visit>
+  void forEachCell(Visit visit) const {
+    for (uint32_t i = 0; i < fences.size(); i++) {
+      const PolygonFence &f = fences[i];
+      if (!f.valid()) continue;
+      int c0 = index(f.left() - minX, invW, cols), c1 = index(f.right() - minX, invW, cols);
+      int r0 = index(f.bottom() - minY, invH, rows), r1 = index(f.top() - minY, invH, rows);
+      for (int r = r0; r <= r1; r++) {
+        for (int c = c0; c <= c1; c++) visit((size_t)r * cols + c, i);
+      }
+    }
+  }
+
+  std::vector<PolygonFence> fences;
+  bool built = false;
+  double minX = 0, minY = 0, maxX = 0, maxY = 0, invW = 0, invH = 0;
+  int cols = 1, rows = 1;
+  std::vector<uint32_t> start;
+  std::vector<uint32_t> members;
+};
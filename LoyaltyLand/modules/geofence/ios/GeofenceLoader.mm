@@ -0,0 +1,23 @@
+#import <Foundation/Foundation.h>
+
+#import <ReactCommon/CxxTurboModuleUtils.h>
+
+#import "NativeGeofence.h"
+
+// iOS has no autolinking for pure C++ modules, so register with the global
+// module map when the class loads (kept by CocoaPods' -ObjC linker flag)
+@interface GeofenceLoader : NSObject
+@end
+
+@implementation GeofenceLoader
+
++ (void)load
+{
+  facebook::react::registerCxxModuleToGlobalModuleMap(
+      std::string(facebook::react::NativeGeofence::kModuleName),
+      [](std::shared_ptr<facebook::react::CallInvoker> jsInvoker) {
+        return std::make_shared<facebook::react::NativeGeofence>(jsInvoker);
+      });
+}
+
+@end
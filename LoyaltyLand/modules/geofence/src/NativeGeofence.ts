@@ -0,0 +1,14 @@
+import type { TurboModule } from 'react-native';
+import { TurboModuleRegistry } from 'react-native';
+
+export interface Spec extends TurboModule {
+  // Polygon event boundaries, each ring flat as [lon, lat, lon, lat, ...];
+  // replaces any set before. Returns how many rings were rejected as
+  // degenerate (fewer than 3 corners, no area, or a coordinate that isn't
+  // finite); they keep their index but never contain anything.
+  setFences(rings: ReadonlyArray<ReadonlyArray<number>>): number;
+  // Indexes into the last setFences of the rings containing the point
+  fencesAt(latitude: number, longitude: number): ReadonlyArray<number>;
+}
+
+export default TurboModuleRegistry.getEnforcing<Spec>('NativeGeofence');
@@ -0,0 +1,13 @@
+import NativeGeofence from './NativeGeofence';
+
+// Polygon event boundaries (cpp/PolygonFences.h). Each ring is its corners
+// in order as [latitude, longitude]; fencesAt returns the indexes of the
+// rings the point is inside. Set them once per events snapshot. Returns
+// how many rings were rejected as degenerate.
+export function setFences(rings: ReadonlyArray<ReadonlyArray<readonly [number, number]>>): number {
+  return NativeGeofence.setFences(rings.map((ring) => ring.flatMap(([lat, lon]) => [lon, lat])));
+}
+
+export function fencesAt(latitude: number, longitude: number): number[] {
+  return NativeGeofence.fencesAt(latitude, longitude) as number[];
+}
@@ -0,0 +1,25 @@
+#include "NativeOrbPreview.h"
+
+// PhysicalOrbComponent/src is on the header search path (podspec / CMakeLists)
+#include "OrbCore.h"
+
+namespace facebook::react {
+
+NativeOrbPreview::NativeOrbPreview(std::shared_ptr<CallInvoker> jsInvoker)
+    : NativeOrbPreviewCxxSpec(std::move(jsInvoker)) {}
+
+std::vector<int> NativeOrbPreview::renderPeriod(jsi::Runtime &, std::string mode) {
+  OrbFrame frames[pulseSteps];
+  renderOrbPeriod(mode.empty() ? 'W' : mode[0], frames);
+
+  std::vector<int> levels;
+  levels.reserve(pulseSteps * 3);
+  for (const OrbFrame &frame : frames) {
+    levels.push_back(frame.red);
+    levels.push_back(frame.green);
+    levels.push_back(frame.blue);
+  }
+  return levels;
+}
+
+} // namespace facebook::react
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <OrbPreviewSpecJSI.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace facebook::react {
+
+// C++ TurboModule over the firmware's effect core, so the app preview
+// runs the same colour and pulse code as the orb itself
+class NativeOrbPreview : public NativeOrbPreviewCxxSpec<NativeOrbPreview> {
+ public:
+  explicit NativeOrbPreview(std::shared_ptr<CallInvoker> jsInvoker);
+
+  std::vector<int> renderPeriod(jsi::Runtime &rt, std::string mode);
+};
+
+} // namespace facebook::react
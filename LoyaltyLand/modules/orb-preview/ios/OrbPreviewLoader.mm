@@ -0,0 +1,23 @@
+#import <Foundation/Foundation.h>
+
+#import <ReactCommon/CxxTurboModuleUtils.h>
+
+#import "NativeOrbPreview.h"
+
+// iOS has no autolinking for pure C++ modules, so register with the global
+// module map when the class loads (kept by CocoaPods' -ObjC linker flag)
+@interface OrbPreviewLoader : NSObject
+@end
+
+@implementation OrbPreviewLoader
+
++ (void)load
+{
+  facebook::react::registerCxxModuleToGlobalModuleMap(
+      std::string(facebook::react::NativeOrbPreview::kModuleName),
+      [](std::shared_ptr<facebook::react::CallInvoker> jsInvoker) {
+        return std::make_shared<facebook::react::NativeOrbPreview>(jsInvoker);
+      });
+}
+
+@end
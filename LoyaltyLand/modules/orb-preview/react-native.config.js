@@ -0,0 +1,12 @@
+// Android autolinking registers the pure C++ module from these
+module.exports = {
+  dependency: {
+    platforms: {
+      android: {
+        cxxModuleCMakeListsModuleName: 'OrbPreview',
+        cxxModuleCMakeListsPath: 'CMakeLists.txt',
+        cxxModuleHeaderName: 'NativeOrbPreview',
+      },
+    },
+  },
+};
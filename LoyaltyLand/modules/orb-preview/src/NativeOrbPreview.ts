@@ -0,0 +1,9 @@
+import type { TurboModule } from 'react-native';
+import { TurboModuleRegistry } from 'react-native';
+
+export interface Spec extends TurboModule {
+  // One full pulse for a colour mode as pin levels: [r, g, b] per tick
+  renderPeriod(mode: string): ReadonlyArray<number>;
+}
+
+export default TurboModuleRegistry.getEnforcing<Spec>('NativeOrbPreview');
@@ -0,0 +1,9 @@
+import NativeOrbPreview from './NativeOrbPreview';
+
+export const ORB_MODES = ['O', 'G', 'R', 'W', 'C'] as const;
+
+// Runs the firmware's own pulse code (PhysicalOrbComponent/src/OrbCore.h)
+// through JSI. Call once per mode change, not per frame.
+export function renderPeriod(mode: string): number[] {
+  return NativeOrbPreview.renderPeriod(mode) as number[];
+}
@@ -0,0 +1,340 @@
+// Orbs for the web dashboard's preview, simulated in the page a frame at a
+// time with no server in the loop. The native app gets the firmware's C++
+// core through the TurboModule; the web has no TurboModules, so
+// loadOrbSim() runs the sketch itself built to WebAssembly
+// (wasm/orb_sim.cpp, served as /orb_sim.wasm; `npm run export-web` builds
+// it first, and `npm run web` does when clang can). createJsOrb is a JS
+// port of the same sketch. loadOrbSim only falls back to it when asked to
+// (the preview does in development), so a deployed page without the .wasm
+// fails rather than quietly showing the port. scripts/orb-sim-bench.mjs
+// checks one against the other and times both.
+// Nothing here imports react-native, so the bench runs it under node.
+//
+//   const sim = await loadOrbSim(WASM_URL, { fallback: __DEV__ });
+//   const orb = await sim.create(seed);
+//   orb.write("25G");             // Serial1 bytes, as a controller sends them
+//   orb.run(performance.now());   // once per requestAnimationFrame
+//   orb.pins;                     // [r, g, b] pin levels, 0 is full on
+//
+// Either kind runs the sketch's loop() once per queued byte and once more
+// per millisecond, as the orb does, so a fast pulse steps as often in the
+// preview as on the orb whatever the frame rate.
+
+export const WASM_URL = "/orb_sim.wasm";
+
+// Bytes an orb holds between frames, as HardwareSerial in wasm/Arduino.h
+const RX_CAPACITY = 256;
+
+// A burst ending in a digit would leave the sketch waiting a second for
+// the rest of the number; a separator ends it, as host tools send it
+export function bytesOf(data) {
+  const bytes = typeof data === "string" ? Array.from(data, (c) => c.charCodeAt(0) & 0xff) : [...data];
+  const last = bytes[bytes.length - 1];
+  if (last >= 48 && last <= 57) bytes.push(32);
+  return bytes;
+}
+
+// The wasm build: one instance per orb, all from one compiled module
+export async function loadWasmOrbs(source) {
+  const module =
+    source instanceof WebAssembly.Module ? source : await WebAssembly.compile(source);
+  return {
+    kind: "wasm",
+    async create(seed = 0) {
+      const { exports } = await WebAssembly.instantiate(module, {});
+      exports.__wasm_call_ctors?.();
+      exports.orb_setup(seed);
+      // The memory never grows, so this view stays valid
+      const pins = new Uint8Array(exports.memory.buffer, exports.orb_pins(), 3);
+      return {
+        pins,
+        write(data) {
+          for (const c of bytesOf(data)) exports.orb_write(c);
+        },
+        run(nowMs) {
+          exports.orb_run(nowMs >>> 0);
+        },
+      };
+    },
+  };
+}
+
+const jsOrbs = {
+  kind: "js",
+  async create(seed = 0) {
+    return createJsOrb(seed);
+  },
+};
+
+let loading = null;
+
+// The wasm build, loaded and compiled once however many orbs are shown.
+// If the page can't fetch it, the JS port with a warning when fallback is
+// set, otherwise a rejection.
+export function loadOrbSim(url = WASM_URL, { fallback = false } = {}) {
+  loading ||= fetch(url)
+    .then((res) => {
+      if (!res.ok) throw new Error(`${url}: ${res.status}`);
+      return res.arrayBuffer();
+    })
+    .then(loadWasmOrbs)
+    .catch((e) => {
+      const missing = `orb preview: ${e.message}; npm run orb-wasm builds it`;
+      if (!fallback) throw new Error(missing);
+      console.warn(`${missing}. Using the JS port.`);
+      return jsOrbs;
+    });
+  return loading;
+}
+
+// ---- JS port of hackathon_LEDS.ino and src/OrbCore.h ----
+//
+// Kept to the same integer maths, so its pins match the wasm build's on
+// every frame (the bench counts any that don't).
+
+const PULSE_STEPS = 510;
+const HEARTBEAT_LAPSE_MS = 250 * 4; // orbHeartbeatMs * orbMissedBeats
+const SAFE_MODE = 87; // 'W'
+const SAFE_SPEED = 40;
+const CANDLE = 67; // 'C'
+
+// 256 * (3t^2 - 2t^3), capped at 255: OrbNoise.h's orbSmoothstep
+const SMOOTHSTEP = Uint8Array.from({ length: 256 }, (_, i) => {
+  const t = i / 256;
+  return Math.min(255, Math.round(256 * (3 * t * t - 2 * t * t * t)));
+});
+const OCTAVE_WEIGHTS = [146, 73, 37]; // three octaves, as OrbCandle uses
+
+function targetsFor(mode) {
+  switch (mode) {
+    case 79: return [0, 150, 255]; // O
+    case 71: return [255, 0, 255]; // G
+    case 82: return [0, 255, 255]; // R
+    case 67: return [0, 110, 230]; // C
+    default: return [0, 0, 0]; // W
+  }
+}
+
+function div255(x) {
+  return ((x + 1 + (x >> 8)) & 0xffff) >> 8;
+}
+
+function scale8(x, scale) {
+  return div255(x * scale);
+}
+
+function lerp8(a, b, t) {
+  return b >= a ? a + scale8(b - a, t) : a - scale8(a - b, t);
+}
+
+function mapLevel(brightness, target) {
+  return 255 - scale8(255 - target, brightness);
+}
+
+export function createJsOrb(seed = 0) {
+  const rx = new Uint8Array(RX_CAPACITY);
+  let head = 0;
+  let count = 0;
+  const pins = new Uint8Array(3);
+  const frame = new Uint8Array(3);
+
+  // OrbRenderState
+  let mode = 87;
+  let brightness = 0;
+  let direction = 1;
+  let speed = 20;
+  let locked = false;
+  let phase = 0;
+  let wavePos = 0;
+  let waveDueMs = 0;
+  let clockMs = 0;
+
+  // OrbCandle over OrbNoise
+  const mixedSeed = (Math.imul(seed & 0xffff, 0x9e37) + 0x79b9) & 0xffff;
+  let candleX = 0;
+  let candleY = 0;
+
+  // OrbPeriodCache<384>: every other level, the middle one of each pair
+  const cache = new Uint8Array(128 * 3);
+  let cachedMode = 0;
+
+  // The sketch's globals, and millis()
+  let lastUpdate = 0;
+  let streaming = false;
+  let lastBeatMs = 0;
+  let armed = false;
+  let safe = false;
+  let pageMs = 0;
+  let running = false;
+
+  const periodMs = () => (speed > 0 ? speed : 1);
+
+  function lattice(x, y) {
+    let h = (Math.imul(x, 0xa3b5) + Math.imul(y, 0x6c8d) + mixedSeed) & 0xffff;
+    h ^= h >> 7;
+    h = Math.imul(h, 0x2c1b) & 0xffff;
+    h ^= h >> 9;
+    return (h >> 8) & 0xff;
+  }
+
+  function noiseAt(x, y) {
+    const cx = x >> 8, cy = y >> 8;
+    const nx = (cx + 1) & 0xff, ny = (cy + 1) & 0xff;
+    const tx = SMOOTHSTEP[x & 0xff], ty = SMOOTHSTEP[y & 0xff];
+    const top = lerp8(lattice(cx, cy), lattice(nx, cy), tx);
+    const bottom = lerp8(lattice(cx, ny), lattice(nx, ny), tx);
+    return lerp8(top, bottom, ty);
+  }
+
+  function candleNext() {
+    candleX = (candleX + 48) & 0xffff;
+    candleY = (candleY + 7) & 0xffff;
+    let sum = 0;
+    for (let o = 0; o < OCTAVE_WEIGHTS.length; o++) {
+      const offset = (o * 0x3a7f) & 0xffff;
+      const level = noiseAt(((candleX << o) + offset) & 0xffff, ((candleY << o) + offset) & 0xffff);
+      sum = (sum + level * OCTAVE_WEIGHTS[o]) & 0xffff;
+    }
+    return 96 + scale8(sum >> 8, 255 - 96);
+  }
+
+  function buildCache() {
+    const [r, g, b] = targetsFor(mode);
+    for (let i = 0; i < 128; i++) {
+      const level = (i << 1) | 1;
+      cache[i * 3] = mapLevel(level, r);
+      cache[i * 3 + 1] = mapLevel(level, g);
+      cache[i * 3 + 2] = mapLevel(level, b);
+    }
+    cachedMode = mode;
+  }
+
+  function advance() {
+    if (mode === CANDLE) {
+      brightness = candleNext();
+      return;
+    }
+    if (locked) {
+      while (((clockMs - waveDueMs) | 0) >= 0) {
+        waveDueMs = (waveDueMs + periodMs()) >>> 0;
+        if (++wavePos === PULSE_STEPS) wavePos = 0;
+      }
+      brightness = wavePos <= 255 ? wavePos : PULSE_STEPS - wavePos;
+      return;
+    }
+    brightness = Math.min(255, Math.max(0, brightness + direction));
+    if (brightness === 255 || brightness === 0) direction = -direction;
+  }
+
+  function sync(atMs) {
+    locked = true;
+    wavePos = phase;
+    waveDueMs = (atMs + periodMs()) >>> 0;
+  }
+
+  function setPhase(steps) {
+    const next = (steps % PULSE_STEPS) & 0xffff;
+    if (locked) wavePos = (wavePos + PULSE_STEPS - phase + next) % PULSE_STEPS;
+    phase = next;
+  }
+
+  function read() {
+    if (count === 0) return -1;
+    const c = rx[head];
+    head = (head + 1) % RX_CAPACITY;
+    count--;
+    return c;
+  }
+
+  const isDigit = (c) => c >= 48 && c <= 57;
+
+  function readDigits(value) {
+    while (count > 0 && isDigit(rx[head])) value = (Math.imul(value, 10) + read() - 48) | 0;
+    return value;
+  }
+
+  function showFrame() {
+    streaming = true;
+    pins.set(frame);
+  }
+
+  function dispatch(c) {
+    if (isDigit(c)) {
+      speed = readDigits(c - 48);
+    } else if (c === 79 || c === 71 || c === 82 || c === 87 || c === CANDLE) {
+      mode = c;
+      streaming = false;
+    } else if (c === 80) { // P
+      setPhase(readDigits(0));
+    } else if (c === 90) { // Z
+      sync(pageMs);
+      streaming = false;
+    } else if (c === 70) { // F
+      const pixels = count > 0 ? read() : 0;
+      for (let p = 0; p < pixels; p++) {
+        for (let i = 0; i < 3 && count > 0; i++) {
+          const level = read();
+          if (p < 1) frame[i] = level;
+        }
+      }
+      showFrame();
+    } else if (c === 68) { // D
+      const pixels = count > 0 ? read() : 0;
+      for (let p = 0; p < pixels; p++) {
+        const pixel = [0, 0, 0, 0];
+        for (let i = 0; i < 4 && count > 0; i++) pixel[i] = read();
+        if (pixel[0] < 1) frame.set(pixel.slice(1));
+      }
+      showFrame();
+    } else if (c === 72) { // H
+      lastBeatMs = pageMs;
+      armed = true;
+      safe = false;
+    }
+    // '?' and separators need nothing here; a status reply has nowhere to go
+  }
+
+  function loop() {
+    if (count > 0) dispatch(read());
+
+    if (armed && !safe && ((pageMs - lastBeatMs) >>> 0) >= HEARTBEAT_LAPSE_MS) {
+      safe = true;
+      mode = SAFE_MODE;
+      speed = SAFE_SPEED;
+      streaming = false;
+    }
+    if (streaming) return;
+
+    if (((pageMs - lastUpdate) >>> 0) >= periodMs()) {
+      lastUpdate = pageMs;
+      clockMs = lastUpdate;
+      if (cachedMode !== mode) buildCache();
+      advance();
+      const i = (brightness >> 1) * 3;
+      pins[0] = cache[i];
+      pins[1] = cache[i + 1];
+      pins[2] = cache[i + 2];
+    }
+  }
+
+  return {
+    pins,
+    write(data) {
+      for (const c of bytesOf(data)) {
+        if (count === RX_CAPACITY) break;
+        rx[(head + count) % RX_CAPACITY] = c;
+        count++;
+      }
+    },
+    run(nowMs) {
+      const now = nowMs >>> 0;
+      if (!running || ((now - pageMs) | 0) > 1000) pageMs = (now - 1) >>> 0;
+      running = true;
+      while (((now - pageMs) | 0) > 0) {
+        pageMs = (pageMs + 1) >>> 0;
+        do loop();
+        while (count > 0);
+      }
+    },
+  };
+}
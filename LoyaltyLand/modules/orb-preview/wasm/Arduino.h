@@ -0,0 +1,49 @@
+#pragma once
+
+// Just enough of the Arduino core for hackathon_LEDS.ino to build to
+// WebAssembly (see orb_sim.cpp). Serial1 reads from a queue the page
+// fills, millis() is the page's clock, and analogWrite() records the pin
+// levels for the page to draw. Everything else the sketch calls is a
+// no-op.
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint8_t byte;
+
+#define OUTPUT 1
+const int A0 = 14;
+
+unsigned long millis();
+void pinMode(int pin, int mode);
+void analogWrite(int pin, int value);
+int analogRead(int pin);
+
+inline bool isDigit(int c) { return c >= '0' && c <= '9'; }
+
+class HardwareSerial {
+public:
+  void begin(unsigned long) {}
+
+  int available();
+  int peek();
+  int read();
+  size_t readBytes(char *out, size_t length);
+
+  // Replies ('s' status, 'h' heartbeat) have nowhere to go in a preview
+  size_t write(uint8_t) { return 1; }
+  size_t write(const uint8_t *, size_t length) { return length; }
+
+  // What the page has sent; false once the queue is full
+  bool receive(uint8_t c);
+
+private:
+  // Comfortably more than a preview frame's worth of commands
+  static const unsigned capacity = 256;
+  uint8_t rx[capacity];
+  unsigned head = 0; // next to read
+  unsigned count = 0;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
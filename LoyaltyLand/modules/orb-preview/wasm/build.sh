@@ -0,0 +1,36 @@
+#!/bin/sh
+# Builds the orb sketch to public/orb_sim.wasm for the web preview (see
+# orb_sim.cpp). Run from LoyaltyLand: npm run orb-wasm. CLANG picks the
+# compiler; it needs the wasm32 target and wasm-ld.
+#
+# npm run export-web runs it first and fails without it: a deployed page
+# has no fallback. npm run web runs it with --optional, which only warns
+# when clang can't target wasm32, since the development preview falls
+# back to the sketch's JS port.
+set -e
+here=$(dirname "$0")
+clang="${CLANG:-clang}"
+# A clang without the target or wasm-ld would otherwise leave the preview
+# without its .wasm; try a one-line build first
+if ! echo 'int x;' | "$clang" --target=wasm32 -nostdlib -Wl,--no-entry -x c - \
+     -o /dev/null >/dev/null 2>&1; then
+  if [ "$1" = "--optional" ]; then
+    echo "orb-wasm: $clang can't build for wasm32; the dev preview will use the JS port" >&2
+    exit 0
+  fi
+  echo "orb-wasm: $clang can't build for wasm32 (set CLANG to one that can, with wasm-ld)" >&2
+  exit 1
+fi
+out="$here/../../../public/orb_sim.wasm"
+mkdir -p "$(dirname "$out")"
+
+# No libc, and one 64 KiB page per orb: the sketch's state is well under
+# 1 KiB, so the stack is cut to 8 KiB and the memory never grows
+"$clang" --target=wasm32 -std=c++17 -O2 \
+  -nostdlib -ffreestanding -fno-exceptions -fno-rtti \
+  -I "$here" -I "$here/../../../../PhysicalOrbComponent" \
+  -Wl,--no-entry -Wl,--export=__wasm_call_ctors -Wl,--strip-all \
+  -Wl,-z,stack-size=8192 -Wl,--initial-memory=65536 -Wl,--max-memory=65536 \
+  -o "$out" "$here/orb_sim.cpp"
+
+echo "$out: $(wc -c < "$out") bytes"
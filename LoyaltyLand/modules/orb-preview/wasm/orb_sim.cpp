@@ -0,0 +1,138 @@
+// The orb sketch itself (PhysicalOrbComponent/hackathon_LEDS.ino) built to
+// WebAssembly, so the web dashboard previews an orb by running its
+// firmware rather than a copy of it. One instance is one orb: the sketch
+// keeps its state in globals, so the page instantiates the module once per
+// orb on screen (modules/orb-preview/src/orbSim.js).
+//
+//   npm run orb-wasm          from LoyaltyLand; needs clang 15+ and wasm-ld
+//
+// That writes public/orb_sim.wasm, which expo serves with the web build.
+// No libc: the sketch and src/ only need <stdint.h>.
+//
+// The page queues bytes with orb_write(), then once per animation frame
+// calls orb_run(now) and reads three pin levels from orb_pins().
+
+#include "Arduino.h"
+
+// Found through -I PhysicalOrbComponent; it includes src/ itself
+#include "hackathon_LEDS.ino"
+
+#if defined(__wasm__)
+#define ORB_EXPORT(name) extern "C" __attribute__((export_name(name)))
+#else
+#define ORB_EXPORT(name) extern "C"
+#endif
+
+HardwareSerial Serial;
+HardwareSerial Serial1;
+
+namespace {
+
+uint32_t pageMs = 0;
+bool running = false;
+
+// readDigits() spins on millis() waiting for a digit that may never come.
+// From the second empty poll in one loop() call the sketch is waiting on
+// the line, so each poll lets a millisecond go by and the wait ends the
+// way the orb's would, a second later. orbSim.js ends every burst on a
+// non-digit, so in practice it never waits.
+uint32_t blockedMs = 0;
+unsigned emptyPolls = 0;
+
+// setup() builds the noise seed from 16 reads of A0
+uint16_t seedBits = 0;
+int seedReads = 0;
+
+uint8_t pins[3];
+
+} // namespace
+
+unsigned long millis() { return pageMs + blockedMs; }
+
+void pinMode(int, int) {}
+
+void analogWrite(int pin, int value) {
+  if (pin >= redPin && pin <= bluePin) pins[pin - redPin] = (uint8_t)value;
+}
+
+// Hands setup() the seed one bit per read, high bit first, so its
+// rotate-and-xor comes out as exactly seedBits
+int analogRead(int) {
+  return (seedBits >> (15 - (seedReads++ & 15))) & 1;
+}
+
+int HardwareSerial::available() {
+  if (count == 0) {
+    if (++emptyPolls > 1) blockedMs++;
+    return 0;
+  }
+  return (int)count;
+}
+
+int HardwareSerial::peek() { return count ? rx[head] : -1; }
+
+int HardwareSerial::read() {
+  if (count == 0) return -1;
+  uint8_t c = rx[head];
+  head = (head + 1) % capacity;
+  count--;
+  return c;
+}
+
+// Short when the page sent a partial frame; what arrived is kept
+size_t HardwareSerial::readBytes(char *out, size_t length) {
+  size_t n = 0;
+  while (n < length && count > 0) out[n++] = (char)read();
+  return n;
+}
+
+bool HardwareSerial::receive(uint8_t c) {
+  if (count == capacity) return false;
+  rx[(head + count) % capacity] = c;
+  count++;
+  return true;
+}
+
+ORB_EXPORT("orb_setup") void orb_setup(uint32_t seed) {
+  seedBits = (uint16_t)seed;
+  seedReads = 0;
+  setup();
+}
+
+ORB_EXPORT("orb_write") int orb_write(uint32_t c) { return Serial1.receive((uint8_t)c); }
+
+// Runs the sketch up to the page's nowMs a millisecond at a time, as often
+// as the orb's own loop() would come round: once per queued byte, then
+// once more for the pulse. A tab that was hidden doesn't replay what it
+// missed; a synced orb still lands in step, as it steps off the clock.
+ORB_EXPORT("orb_run") void orb_run(uint32_t nowMs) {
+  if (!running || (int32_t)(nowMs - pageMs) > 1000) pageMs = nowMs - 1;
+  running = true;
+  while ((int32_t)(nowMs - pageMs) > 0) {
+    pageMs++;
+    do {
+      emptyPolls = 0;
+      loop();
+    } while (Serial1.peek() >= 0);
+  }
+}
+
+// Pin levels as analogWrite() last left them: common anode, 0 is full on
+ORB_EXPORT("orb_pins") const uint8_t *orb_pins() { return pins; }
+
+#if defined(__wasm__)
+// With no libc, clang's struct copies and zeroing still call these. Kept
+// from being turned back into calls to themselves.
+extern "C" __attribute__((no_builtin)) void *memcpy(void *dst, const void *src, size_t n) {
+  uint8_t *d = (uint8_t *)dst;
+  const uint8_t *s = (const uint8_t *)src;
+  while (n--) *d++ = *s++;
+  return dst;
+}
+
+extern "C" __attribute__((no_builtin)) void *memset(void *dst, int c, size_t n) {
+  uint8_t *d = (uint8_t *)dst;
+  while (n--) *d++ = (uint8_t)c;
+  return dst;
+}
+#endif
@@ -0,0 +1,117 @@
+// orb_sim.cpp built for this machine instead of WebAssembly, replaying a
+// session from scripts/orb-sim-bench.mjs (--native). It's the same source
+// the .wasm is built from, so where clang can't target wasm32 the bench
+// can still check the JS port against the sketch, and time the sketch's
+// own work per frame: a floor under what the .wasm costs.
+//
+//   node scripts/orb-sim-bench.mjs --native       builds and runs it
+//   c++ -std=c++17 -O2 -I modules/orb-preview/wasm -I ../PhysicalOrbComponent
+//       modules/orb-preview/wasm/orb_sim_replay.cpp -o orb_sim_replay
+//
+// stdin, little-endian: u32 orbs, u32 frames, u32 seed, then per frame
+// f64 time, u32 writes, and per write u16 orb, u16 length, bytes (already
+// ended on a separator, as orbSim.js sends them). stdout: per orb, per
+// frame, the three pin levels and u32 ns spent in orb_write/orb_run.
+//
+// The sketch keeps its state in globals, so each orb runs in its own
+// child process, one after another.
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "orb_sim.cpp"
+
+namespace {
+
+struct Write {
+  uint16_t orb;
+  std::vector<uint8_t> bytes;
+};
+
+struct Frame {
+  double t;
+  std::vector<Write> writes;
+};
+
+template <typename T>
+bool readValue(T &value) {
+  return fread(&value, sizeof(value), 1, stdin) == 1;
+}
+
+bool readSession(uint32_t &orbs, uint32_t &seed, std::vector<Frame> &frames) {
+  uint32_t count;
+  if (!readValue(orbs) || !readValue(count) || !readValue(seed)) return false;
+  frames.resize(count);
+  for (Frame &f : frames) {
+    uint32_t writes;
+    if (!readValue(f.t) || !readValue(writes)) return false;
+    f.writes.resize(writes);
+    for (Write &w : f.writes) {
+      uint16_t length;
+      if (!readValue(w.orb) || !readValue(length)) return false;
+      w.bytes.resize(length);
+      if (length && fread(w.bytes.data(), 1, length, stdin) != length) return false;
+    }
+  }
+  return true;
+}
+
+// One orb through the whole session, as the page drives it
+void replay(uint32_t orb, uint32_t seed, const std::vector<Frame> &frames, int out) {
+  using Clock = std::chrono::steady_clock;
+  orb_setup(seed + orb);
+  std::vector<uint8_t> record(frames.size() * 7);
+  for (size_t f = 0; f < frames.size(); f++) {
+    Clock::time_point start = Clock::now();
+    for (const Write &w : frames[f].writes) {
+      if (w.orb != orb) continue;
+      for (uint8_t c : w.bytes) orb_write(c);
+    }
+    orb_run((uint32_t)frames[f].t);
+    uint32_t ns = (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      Clock::now() - start)
+                      .count();
+    uint8_t *r = &record[f * 7];
+    memcpy(r, orb_pins(), 3);
+    memcpy(r + 3, &ns, 4);
+  }
+  for (size_t done = 0; done < record.size();) {
+    ssize_t n = ::write(out, record.data() + done, record.size() - done);
+    if (n <= 0) _exit(1);
+    done += (size_t)n;
+  }
+}
+
+} // namespace
+
+int main() {
+  uint32_t orbs, seed;
+  std::vector<Frame> frames;
+  if (!readSession(orbs, seed, frames)) {
+    fprintf(stderr, "orb_sim_replay: short session on stdin\n");
+    return 1;
+  }
+  fflush(stdout);
+  for (uint32_t orb = 0; orb < orbs; orb++) {
+    pid_t pid = fork();
+    if (pid < 0) {
+      perror("fork");
+      return 1;
+    }
+    if (pid == 0) {
+      replay(orb, seed, frames, STDOUT_FILENO);
+      _exit(0);
+    }
+    int status = 0;
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      fprintf(stderr, "orb_sim_replay: orb %u failed\n", orb);
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,247 @@
+#!/usr/bin/env node
+
+/**
+ * Walks past a street of orbs with the OS watching the nearest ones as
+ * geofences, and compares two ways of keeping that set up to date:
+ * restarting one task with the full list whenever it changes, and the
+ * per-orb slots in services/geofenceRegions.js that change only what
+ * differs. Reports registration calls, regions the OS had to rebuild, and
+ * orb visits whose enter never came.
+ *
+ * Slots only help if the OS keeps each task's regions apart, as Android
+ * does. The third run is slots where every start or stop first drops all
+ * the app's regions, which is what expo-location's iOS consumer appears
+ * to do. That is why orbMonitoring uses the full list on iOS.
+ *
+ *   node scripts/geofence-bench.mjs [--orbs 200] [--seed 1]
+ *
+ * The walk is 1.4 m/s along a winding 5 km street with the orbs spread
+ * along it, most within a few tens of metres of the path. Fixes come
+ * every 10 s, 5 m off, and each one can re-choose the regions (every
+ * RECHOOSE_M). It runs in virtual time, one second at a time.
+ *
+ * The OS is modelled the way iOS behaves: a region it has just been
+ * given takes SETTLE_S to come up, starts in whatever state the phone is
+ * in without reporting it, and reports a crossing once the phone has been
+ * on the new side for DETECT_S. Dropping or rebuilding a region forgets a
+ * crossing it hadn't reported yet. A visit is the walk being inside an
+ * orb's radius for at least DETECT_S; it's missed if no enter for that
+ * orb came while the walk was inside it.
+ */
+
+import {
+  REGION_LIMIT,
+  RECHOOSE_M,
+  chooseRegions,
+  planList,
+  planSlots,
+} from "../services/geofenceRegions.js";
+import { ORB_RADIUS_M, distanceM } from "../services/locationSampling.js";
+
+const WALK_MS = 1.4;
+const FIX_EVERY_S = 10;
+const FIX_ERROR_M = 5;
+const SETTLE_S = 10;
+const DETECT_S = 5;
+// Where the OS counts the phone as out again; it doesn't exit on the line
+const EXIT_SLACK_M = 20;
+
+const START = [42.7314, -73.6908];
+
+const args = process.argv.slice(2);
+const argValue = (name) => {
+  const i = args.indexOf(name);
+  return i >= 0 ? args[i + 1] : undefined;
+};
+
+// mulberry32: a seeded stream, so runs compare like for like
+function rng(seed) {
+  let a = seed >>> 0;
+  return () => {
+    a = (a + 0x6d2b79f5) >>> 0;
+    let t = Math.imul(a ^ (a >>> 15), 1 | a);
+    t = (t + Math.imul(t ^ (t >>> 7), 61 | t)) ^ t;
+    return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+  };
+}
+
+function gaussian(random) {
+  return Math.sqrt(-2 * Math.log(1 - random())) * Math.cos(2 * Math.PI * random());
+}
+
+function offset([lat, lon], northM, eastM) {
+  const latStep = 1 / 111195;
+  return [lat + northM * latStep, lon + (eastM * latStep) / Math.cos(lat * (Math.PI / 180))];
+}
+
+// A winding street, a point per second of walking, and orbs along it
+function generateWalk(orbCount, random) {
+  const track = [];
+  let north = 0, east = 0, heading = random() * 2 * Math.PI;
+  const lengthM = 5000;
+  for (let s = 0; s * WALK_MS < lengthM; s++) {
+    heading += gaussian(random) * 0.02;
+    north += Math.cos(heading) * WALK_MS;
+    east += Math.sin(heading) * WALK_MS;
+    track.push({ north, east });
+  }
+  const orbs = [];
+  for (let i = 0; i < orbCount; i++) {
+    const at = track[Math.floor(random() * track.length)];
+    // Most on the street, some across it or down a side road
+    const aside = random() < 0.8 ? gaussian(random) * 25 : (random() < 0.5 ? -1 : 1) * 90;
+    const [lat, lon] = offset(START, at.north + gaussian(random) * 5, at.east + aside);
+    orbs.push({ id: `orb-${i}`, latitude: lat, longitude: lon });
+  }
+  return { track: track.map((p) => offset(START, p.north, p.east)), orbs };
+}
+
+// The OS's side: each watched region's state, as described up top
+function createOs() {
+  const regions = new Map(); // id -> { region, readyAt, inside, pending }
+  const enters = [];
+  let rebuilt = 0;
+  return {
+    enters,
+    rebuilt: () => rebuilt,
+    add(region, t) {
+      regions.set(region.identifier, { region, readyAt: t + SETTLE_S, inside: null, pending: null });
+      rebuilt++;
+    },
+    remove(id) {
+      regions.delete(id);
+    },
+    clear() {
+      regions.clear();
+    },
+    tick([lat, lon], t) {
+      for (const [id, r] of regions) {
+        if (t < r.readyAt) continue;
+        const d = distanceM(lat, lon, r.region.latitude, r.region.longitude);
+        const nowInside = r.inside ? d <= r.region.radius + EXIT_SLACK_M : d <= r.region.radius;
+        if (r.inside === null) {
+          r.inside = nowInside;
+          r.pending = null;
+          continue;
+        }
+        if (nowInside === r.inside) {
+          r.pending = null;
+        } else if (r.pending === null) {
+          r.pending = t;
+        } else if (t - r.pending >= DETECT_S) {
+          r.inside = nowInside;
+          r.pending = null;
+          if (nowInside) enters.push({ id, t });
+        }
+      }
+    },
+  };
+}
+
+// Restarts one task with every region whenever the chosen set changes
+function fullList(os) {
+  let registered = [];
+  let calls = 0;
+  return {
+    calls: () => calls,
+    watched: () => new Set(registered.map((r) => r.identifier)),
+    apply(wanted, t) {
+      if (!planList(registered, wanted)) return;
+      os.clear();
+      for (const region of wanted) os.add(region, t);
+      registered = wanted;
+      calls++;
+    },
+  };
+}
+
+// A task per region, changing only the slots that differ. shared: every
+// start or stop drops all the app's regions first, not just the slot's.
+function slotted(os, shared = false) {
+  const slots = new Array(REGION_LIMIT).fill(null);
+  let calls = 0;
+  return {
+    calls: () => calls,
+    watched: () => new Set(slots.filter(Boolean).map((r) => r.identifier)),
+    apply(wanted, t) {
+      for (const { slot, region } of planSlots(slots, wanted)) {
+        if (shared) os.clear();
+        else if (slots[slot]) os.remove(slots[slot].identifier);
+        if (region) os.add(region, t);
+        slots[slot] = region;
+        calls++;
+      }
+    },
+  };
+}
+
+function visitsOf(walk) {
+  const visits = [];
+  for (const orb of walk.orbs) {
+    let from = -1;
+    for (let t = 0; t <= walk.track.length; t++) {
+      const p = walk.track[t];
+      const inside = p && distanceM(p[0], p[1], orb.latitude, orb.longitude) <= ORB_RADIUS_M;
+      if (inside && from < 0) from = t;
+      if (!inside && from >= 0) {
+        if (t - from >= DETECT_S) visits.push({ id: orb.id, from, to: t });
+        from = -1;
+      }
+    }
+  }
+  return visits;
+}
+
+function simulate(walk, makeRegistry, random) {
+  const os = createOs();
+  const registry = makeRegistry(os);
+  let chosenAt = null;
+  for (let t = 0; t < walk.track.length; t++) {
+    const [lat, lon] = walk.track[t];
+    if (t % FIX_EVERY_S === 0) {
+      const errorN = gaussian(random) * FIX_ERROR_M;
+      const fix = offset([lat, lon], errorN, gaussian(random) * FIX_ERROR_M);
+      const moved = chosenAt ? distanceM(chosenAt[0], chosenAt[1], fix[0], fix[1]) : Infinity;
+      if (moved >= RECHOOSE_M) {
+        chosenAt = fix;
+        registry.apply(chooseRegions(walk.orbs, fix[0], fix[1], registry.watched()), t);
+      }
+    }
+    os.tick([lat, lon], t);
+  }
+
+  const visits = visitsOf(walk);
+  let missed = 0;
+  const lateS = [];
+  for (const v of visits) {
+    const enter = os.enters.find((e) => e.id === v.id && e.t >= v.from && e.t <= v.to);
+    if (enter) lateS.push(enter.t - v.from);
+    else missed++;
+  }
+  lateS.sort((a, b) => a - b);
+  return { calls: registry.calls(), rebuilt: os.rebuilt(), visits: visits.length, missed, lateS };
+}
+
+function report(label, r) {
+  const p50 = r.lateS.length ? r.lateS[Math.floor(r.lateS.length / 2)] : NaN;
+  console.log(label);
+  console.log(`  ${r.calls} registration calls, ${r.rebuilt} regions (re)built by the OS`);
+  console.log(
+    `  ${r.visits - r.missed}/${r.visits} visits entered, ${r.missed} missed,` +
+      ` enter p50 ${p50} s after arriving`
+  );
+  console.log();
+}
+
+const seed = parseInt(argValue("--seed") || "1");
+const walk = generateWalk(parseInt(argValue("--orbs") || "200"), rng(seed));
+console.log(
+  `${walk.orbs.length} orbs along a ${((walk.track.length * WALK_MS) / 1000).toFixed(1)} km walk,` +
+    ` ${REGION_LIMIT} watched at a time\n`
+);
+report("full list, restarted on every change", simulate(walk, fullList, rng(seed + 1)));
+report("per-orb slots, only what differs", simulate(walk, slotted, rng(seed + 1)));
+report(
+  "per-orb slots, if each call drops every region (iOS)",
+  simulate(walk, (os) => slotted(os, true), rng(seed + 1))
+);
@@ -0,0 +1,252 @@
+#!/usr/bin/env node
+
+/**
+ * Runs a simulated day of movement through the location sampler
+ * (services/locationSampling.js) and fixed-rate location updates, and
+ * reports fixes per hour, battery drain and how many orb visits each one
+ * noticed.
+ *
+ *   node scripts/location-bench.mjs [--seed 1] [--events 35]
+ *
+ * It also times the event index over 1000 events scattered across the
+ * US, since its cost should follow the number of events, not how far
+ * apart they are.
+ *
+ * The day: home 9 km out of town overnight, a drive in, a desk 1.8 km
+ * from River St, a walk along River St at lunch and another after work
+ * stopping at a few orbs, then the drive home. It runs in virtual time,
+ * one second at a time.
+ *
+ * The OS takes a reading every timeInterval and hands it over once the
+ * phone has also moved distanceInterval (Android's rule). Every reading
+ * costs power whether it is handed over or not, and so does waking the
+ * app. Readings are off by about the accuracy each mode claims. The
+ * current draw figures are rough ones for a typical phone; the relative
+ * costs matter more than the exact mAh.
+ *
+ * A stop counts as noticed if the app has the user at that orb before
+ * they walk on; "late" is how long after reaching it that happened.
+ */
+
+import {
+  SAMPLING_BANDS,
+  createEventIndex,
+  createLocationSampler,
+  distanceM,
+} from "../services/locationSampling.js";
+
+// mAs per reading, and the error it comes with
+const READING = {
+  high: { mAs: 30 * 6, errorM: 5 }, // GPS warm start, ~6 s at 30 mA
+  balanced: { mAs: 15 * 1.5, errorM: 30 }, // Wi-Fi scan
+  low: { mAs: 3, errorM: 250 }, // cell towers, now and then Wi-Fi
+  lowest: { mAs: 0.5, errorM: 1000 }, // passive cell changes
+};
+// Below this interval the GPS never gets to sleep between readings
+const GPS_ALWAYS_ON_BELOW_MS = 15_000;
+const GPS_ON_MA = 30;
+// Waking the app's JS for a fix
+const WAKE_MAS = 50 * 0.5;
+const BATTERY_MAH = 3000;
+
+const HOME = [42.7314, -73.5688];
+const WORK = [42.7476, -73.6908];
+const RIVER_ST = [42.7314, -73.6908];
+
+const args = process.argv.slice(2);
+const argValue = (name) => {
+  const i = args.indexOf(name);
+  return i >= 0 ? args[i + 1] : undefined;
+};
+
+// mulberry32: a seeded stream, so runs compare like for like
+function rng(seed) {
+  let a = seed >>> 0;
+  return () => {
+    a = (a + 0x6d2b79f5) >>> 0;
+    let t = Math.imul(a ^ (a >>> 15), 1 | a);
+    t = (t + Math.imul(t ^ (t >>> 7), 61 | t)) ^ t;
+    return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+  };
+}
+
+function gaussian(random) {
+  return Math.sqrt(-2 * Math.log(1 - random())) * Math.cos(2 * Math.PI * random());
+}
+
+function offset([lat, lon], northM, eastM) {
+  const latStep = 1 / 111195;
+  return [lat + northM * latStep, lon + (eastM * latStep) / Math.cos(lat * (Math.PI / 180))];
+}
+
+// Most events along River St, a few elsewhere in town
+function generateEvents(count, random) {
+  const events = [];
+  for (let i = 0; i < count; i++) {
+    const onRiverSt = i < count * 0.85;
+    const [lat, lon] = onRiverSt
+      ? offset(RIVER_ST, (random() - 0.5) * 1600, (random() - 0.5) * 120)
+      : offset(RIVER_ST, (random() - 0.5) * 6000, (random() - 0.5) * 6000);
+    events.push({ id: `event-${i}`, latitude: lat, longitude: lon });
+  }
+  return events;
+}
+
+// One position a second for the whole day, and when each orb stop began
+function generateDay(events, random) {
+  const track = [];
+  const visits = [];
+  let at = HOME;
+  const stay = (untilS) => {
+    while (track.length < untilS) track.push(at);
+  };
+  const go = (to, speed) => {
+    const d = distanceM(at[0], at[1], to[0], to[1]);
+    const steps = Math.max(1, Math.round(d / speed));
+    const from = at;
+    for (let s = 1; s <= steps; s++) {
+      at = [from[0] + ((to[0] - from[0]) * s) / steps, from[1] + ((to[1] - from[1]) * s) / steps];
+      track.push(at);
+    }
+  };
+  const walkRiverSt = (stops, dwellS) => {
+    const onStreet = events.filter((e) => distanceM(e.latitude, e.longitude, ...RIVER_ST) < 900);
+    for (let i = 0; i < stops; i++) {
+      const e = onStreet.splice(Math.floor(random() * onStreet.length), 1)[0];
+      go([e.latitude, e.longitude], 1.4);
+      visits.push({ event: e, t: track.length, dwellS });
+      stay(track.length + dwellS);
+    }
+  };
+
+  stay(7.75 * 3600);
+  go(WORK, 12);
+  stay(12 * 3600);
+  walkRiverSt(3, 600);
+  go(WORK, 1.4);
+  stay(17.5 * 3600);
+  walkRiverSt(4, 900);
+  stay(19.5 * 3600);
+  go(HOME, 12);
+  stay(24 * 3600);
+  return { track, visits };
+}
+
+function simulate(day, events, policy, random) {
+  const index = createEventIndex(events);
+  let options = policy.initial;
+  const crossings = []; // enters and exits, in order
+  const sampler = createLocationSampler({
+    index,
+    onBand: (band) => policy.adaptive && (options = SAMPLING_BANDS[band]),
+    onEnter: (event) => crossings.push({ id: event.id, t, enter: true }),
+    onExit: (event) => crossings.push({ id: event.id, t, enter: false }),
+  });
+  const bandSeconds = new Array(SAMPLING_BANDS.length).fill(0);
+
+  let t = 0;
+  let mAs = 0, readings = 0, fixes = 0;
+  let lastReading = -Infinity;
+  let lastFix = null;
+  for (t = 0; t < day.track.length; t++) {
+    if (policy.adaptive) bandSeconds[sampler.band()]++;
+    const reading = READING[options.accuracy];
+    const alwaysOn =
+      options.accuracy === "high" && options.timeIntervalMs < GPS_ALWAYS_ON_BELOW_MS;
+    if (alwaysOn) mAs += GPS_ON_MA;
+    if ((t - lastReading) * 1000 < options.timeIntervalMs) continue;
+    lastReading = t;
+    readings++;
+    if (!alwaysOn) mAs += reading.mAs;
+
+    const [lat, lon] = day.track[t];
+    const [fixLat, fixLon] = offset(
+      [lat, lon],
+      gaussian(random) * reading.errorM * 0.7,
+      gaussian(random) * reading.errorM * 0.7
+    );
+    if (lastFix && distanceM(lastFix[0], lastFix[1], fixLat, fixLon) < options.distanceIntervalM) {
+      continue;
+    }
+    lastFix = [fixLat, fixLon];
+    fixes++;
+    mAs += WAKE_MAS;
+    sampler.offer({ t: t * 1000, latitude: fixLat, longitude: fixLon, accuracy: reading.errorM });
+  }
+
+  // A stop is noticed if the app thinks the user is at that orb before
+  // they walk on: the last crossing for it by then is an enter. Walking
+  // past on the way can count, as it would for the user.
+  let noticed = 0;
+  const lateS = [];
+  for (const visit of day.visits) {
+    let last = null;
+    for (const c of crossings) {
+      if (c.id === visit.event.id && c.t <= visit.t + visit.dwellS) last = c;
+    }
+    if (last?.enter) {
+      noticed++;
+      lateS.push(Math.max(0, last.t - visit.t));
+    }
+  }
+  lateS.sort((a, b) => a - b);
+  const entered = crossings.filter((c) => c.enter).length;
+  return { mAs, readings, fixes, noticed, lateS, entered, bandSeconds };
+}
+
+function report(label, day, r) {
+  const hours = day.track.length / 3600;
+  const mAh = r.mAs / 3600;
+  const late = r.lateS;
+  const pct = (p) => (late.length ? late[Math.min(late.length - 1, Math.floor(p * late.length))] : NaN);
+  const perHour = (n) => (n / hours).toFixed(1);
+  console.log(label);
+  console.log(`  ${perHour(r.fixes)} fixes/h handed to the app, ${perHour(r.readings)} readings/h`);
+  const share = ((100 * mAh) / BATTERY_MAH).toFixed(1);
+  console.log(`  ${mAh.toFixed(0)} mAh/day, ${share}% of a ${BATTERY_MAH} mAh battery`);
+  console.log(
+    `  ${r.noticed}/${day.visits.length} orb stops noticed, ${r.entered} enters,` +
+      ` late p50 ${pct(0.5)} s, max ${pct(1)} s`
+  );
+  if (r.bandSeconds.some((s) => s > 0)) {
+    const bands = SAMPLING_BANDS.map(
+      (b, i) => `${b.name} ${((100 * r.bandSeconds[i]) / day.track.length).toFixed(1)}%`
+    );
+    console.log(`  time per band: ${bands.join(", ")}`);
+  }
+  console.log();
+}
+
+const seed = parseInt(argValue("--seed") || "1");
+const events = generateEvents(parseInt(argValue("--events") || "35"), rng(seed));
+const day = generateDay(events, rng(seed + 1));
+
+const started = performance.now();
+const index = createEventIndex(events);
+const built = performance.now() - started;
+console.log(
+  `${events.length} events, index of ${index.cellsBuilt} cells built in ${built.toFixed(1)} ms`
+);
+{
+  const random = rng(seed + 3);
+  const scattered = Array.from({ length: 1000 }, (_, i) => ({
+    id: `us-${i}`,
+    latitude: 25 + random() * 24,
+    longitude: -124 + random() * 57,
+  }));
+  const t0 = performance.now();
+  const wide = createEventIndex(scattered);
+  const ms = (performance.now() - t0).toFixed(0);
+  console.log(`1000 events across the US, index of ${wide.cellsBuilt} cells built in ${ms} ms`);
+}
+console.log(`${day.visits.length} orb stops in a ${(day.track.length / 3600).toFixed(0)} h day\n`);
+
+const fixed = (accuracy, timeIntervalMs, distanceIntervalM) => ({
+  adaptive: false,
+  initial: { accuracy, timeIntervalMs, distanceIntervalM },
+});
+const adaptive = { adaptive: true, initial: SAMPLING_BANDS[SAMPLING_BANDS.length - 1] };
+const run = (policy) => simulate(day, events, policy, rng(seed + 2));
+report("continuous GPS, every 5 s", day, run(fixed("high", 5000, 0)));
+report("balanced, every 60 s", day, run(fixed("balanced", 60_000, 0)));
+report("adaptive bands", day, run(adaptive));
@@ -0,0 +1,87 @@
+#!/usr/bin/env node
+
+/**
+ * Moves points from the old map in users/{uid} (users/{uid}.points.<bizId>)
+ * into users/{uid}/points/{bizId}, which is where QRScanner writes and
+ * UserWallet reads them now.
+ *
+ *   node scripts/migrate-points.mjs [--project ID]
+ *   FIRESTORE_EMULATOR_HOST=localhost:8080 node scripts/migrate-points.mjs
+ *
+ * Each batch adds a set of entries to their new documents and deletes the
+ * same entries from the map, so a run that stops halfway can be started
+ * again without counting anything twice. Scans made during the migration
+ * already go to the new documents and are added to, not overwritten.
+ */
+
+import { initializeApp } from "firebase/app";
+import {
+  getFirestore,
+  connectFirestoreEmulator,
+  collection,
+  doc,
+  getDocs,
+  writeBatch,
+  increment,
+  deleteField,
+  serverTimestamp,
+  FieldPath,
+} from "firebase/firestore";
+
+const BATCH_LIMIT = 500; // Firestore's cap on writes per batch
+
+const args = process.argv.slice(2);
+const argValue = (name) => {
+  const i = args.indexOf(name);
+  return i >= 0 ? args[i + 1] : undefined;
+};
+
+const app = initializeApp({ projectId: argValue("--project") || "nsch3-eb96c", apiKey: "migrate" });
+const db = getFirestore(app);
+if (process.env.FIRESTORE_EMULATOR_HOST) {
+  const [host, port] = process.env.FIRESTORE_EMULATOR_HOST.split(":");
+  connectFirestoreEmulator(db, host, parseInt(port));
+}
+
+let users = 0;
+let moved = 0;
+const snapshot = await getDocs(collection(db, "users"));
+for (const userDoc of snapshot.docs) {
+  const points = userDoc.data().points;
+  if (points === undefined) continue;
+  users++;
+
+  // signUp used to write points: 0 before there was a map
+  const entries = points && typeof points === "object" ? Object.entries(points) : [];
+  if (entries.length === 0) {
+    const batch = writeBatch(db);
+    batch.update(userDoc.ref, { points: deleteField() });
+    await batch.commit();
+    continue;
+  }
+
+  // One write per entry plus the user document's update
+  for (let i = 0; i < entries.length; i += BATCH_LIMIT - 1) {
+    const chunk = entries.slice(i, i + BATCH_LIMIT - 1);
+    const batch = writeBatch(db);
+    const removals = [];
+    for (const [bizId, value] of chunk) {
+      batch.set(
+        doc(db, "users", userDoc.id, "points", bizId),
+        { points: increment(Number(value) || 0), updatedAt: serverTimestamp() },
+        { merge: true }
+      );
+      removals.push(new FieldPath("points", bizId), deleteField());
+    }
+    batch.update(userDoc.ref, ...removals);
+    await batch.commit();
+    moved += chunk.length;
+  }
+  // The last entry's deletion leaves an empty map behind
+  const batch = writeBatch(db);
+  batch.update(userDoc.ref, { points: deleteField() });
+  await batch.commit();
+}
+
+console.log(`${moved} balances moved from ${users} users`);
+process.exit(0);
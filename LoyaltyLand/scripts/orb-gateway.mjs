@@ -0,0 +1,228 @@
+#!/usr/bin/env node
+
+/**
+ * Host-side gateway that drives the physical orbs from Firestore.
+ * It watches "events" (a new event sets its orb's colour) and users' points
+ * documents (a scan at a business flashes that business's orb) and writes
+ * the matching Serial1 commands to each orb, batched and rate-limited per orb.
+ *
+ *   FIRESTORE_EMULATOR_HOST=localhost:8080 node scripts/orb-gateway.mjs --orbs orbs.json
+ *   FIRESTORE_EMULATOR_HOST=localhost:8080 node scripts/orb-gateway.mjs --bench 200
+ *
+ *   node scripts/orb-gateway.mjs --bench 200 --offline
+ *
+ * orbs.json maps orbId -> serial device, e.g. { "jacob_alejandro_troy": "/dev/ttyUSB0" }.
+ * Configure the port first (stty -F /dev/ttyUSB0 9600 raw). Orbs without a
+ * device are logged instead. --bench writes test events and scans to the
+ * emulator and reports how long each change took to reach the orb: from
+ * the write to the last byte of its command leaving at 9600 baud.
+ * --offline skips Firestore and feeds the same handlers synthetic
+ * snapshots, which times the gateway's own share (batching, the per-orb
+ * rate limit and the serial line) without the emulator.
+ */
+
+import fs from "fs";
+
+const MIN_SEND_INTERVAL_MS = 100; // 9600 baud is ~960 bytes/s; stay well clear
+const FLASH_SPEED = 2; // ms per brightness step while flashing
+const FLASH_MS = 1500;
+const DEFAULT_SPEED = 20; // matches pulseSpeed in hackathon_LEDS.ino
+const ORB_MODES = ["O", "G", "R", "W"];
+const BAUD_BYTES_PER_MS = 0.96; // 9600 baud, 10 bits a byte
+
+const args = process.argv.slice(2);
+const argValue = (name) => {
+  const i = args.indexOf(name);
+  return i >= 0 ? args[i + 1] : undefined;
+};
+
+const offline = args.includes("--offline");
+const orbDevices = argValue("--orbs") ? JSON.parse(fs.readFileSync(argValue("--orbs"), "utf8")) : {};
+const latencies = [];
+
+// One per orb: holds the wanted state and sends at most one merged
+// command every MIN_SEND_INTERVAL_MS
+class OrbLink {
+  constructor(orbId) {
+    this.orbId = orbId;
+    this.mode = "W";
+    this.speed = DEFAULT_SPEED;
+    this.flashUntil = 0;
+    this.sent = { mode: null, speed: null };
+    this.lastSend = 0;
+    this.timer = null;
+    this.origins = []; // when each batched change started, for latency
+    const device = orbDevices[orbId];
+    this.fd = device ? fs.openSync(device, "w") : null;
+  }
+
+  setMode(mode, origin) {
+    this.mode = mode;
+    this.schedule(origin);
+  }
+
+  // Scans inside one flash window just extend it
+  flash(origin) {
+    this.flashUntil = Date.now() + FLASH_MS;
+    this.schedule(origin);
+    setTimeout(() => this.schedule(), FLASH_MS + 1);
+  }
+
+  schedule(origin) {
+    if (origin !== undefined) this.origins.push(origin);
+    if (this.timer) return;
+    const wait = Math.max(0, this.lastSend + MIN_SEND_INTERVAL_MS - Date.now());
+    this.timer = setTimeout(() => this.send(), wait);
+  }
+
+  send() {
+    this.timer = null;
+    const speed = Date.now() < this.flashUntil ? FLASH_SPEED : this.speed;
+    let command = "";
+    if (this.mode !== this.sent.mode) command += this.mode;
+    // Newline ends the number so the orb's parseInt() doesn't wait for its timeout
+    if (speed !== this.sent.speed) command += speed + "\n";
+    if (command) this.write(command);
+    this.sent = { mode: this.mode, speed };
+    this.lastSend = Date.now();
+
+    // Reaches the orb once its last byte is out on the wire
+    const arrives = Date.now() + command.length / BAUD_BYTES_PER_MS;
+    for (const origin of this.origins) latencies.push(arrives - origin);
+    this.origins = [];
+  }
+
+  write(command) {
+    if (this.fd !== null) {
+      fs.writeSync(this.fd, command);
+    } else if (!offline) {
+      console.log(`[${this.orbId}] ${JSON.stringify(command)}`);
+    }
+  }
+}
+
+const links = new Map();
+const linkFor = (orbId) => {
+  if (!links.has(orbId)) links.set(orbId, new OrbLink(orbId));
+  return links.get(orbId);
+};
+
+// New events colour their orb; the orb is the organization's. The first
+// snapshot is every event that already exists; replaying those would set
+// each orb to whichever old event happened to come last.
+let eventsLoaded = false;
+function onEvents(snapshot) {
+  const received = Date.now();
+  if (!eventsLoaded) {
+    eventsLoaded = true;
+    return;
+  }
+  snapshot.docChanges().forEach((change) => {
+    if (change.type !== "added") return;
+    const event = change.doc.data();
+    const orbId = event.orbId || event.orgId;
+    if (!orbId) return;
+    const mode = ORB_MODES.includes(event.orbColor) ? event.orbColor : "G";
+    const origin = event.createdAt ? event.createdAt.toMillis() : received;
+    linkFor(orbId).setMode(mode, origin);
+  });
+}
+
+// QRScanner bumps users/{uid}/points/{bizId}, so any change to one of
+// those documents is a scan at bizId. The first snapshot is just the
+// balances that already exist.
+let pointsLoaded = false;
+function onPoints(snapshot) {
+  const received = Date.now();
+  if (!pointsLoaded) {
+    pointsLoaded = true;
+    return;
+  }
+  snapshot.docChanges().forEach((change) => {
+    if (change.type !== "removed") linkFor(change.doc.id).flash(received);
+  });
+}
+
+let firestore, db;
+if (!offline) {
+  const { initializeApp } = await import("firebase/app");
+  firestore = await import("firebase/firestore");
+  const projectId = argValue("--project") || "nsch3-eb96c";
+  db = firestore.getFirestore(initializeApp({ projectId, apiKey: "gateway" }));
+  if (process.env.FIRESTORE_EMULATOR_HOST) {
+    const [host, port] = process.env.FIRESTORE_EMULATOR_HOST.split(":");
+    firestore.connectFirestoreEmulator(db, host, parseInt(port));
+  }
+  firestore.onSnapshot(firestore.collection(db, "events"), onEvents);
+  firestore.onSnapshot(firestore.collectionGroup(db, "points"), onPoints);
+}
+
+const benchCount = parseInt(argValue("--bench") || "0");
+if (benchCount > 0) {
+  if (offline) runOfflineBench(benchCount);
+  else runBench(benchCount);
+} else {
+  console.log("Orb gateway running" + (process.env.FIRESTORE_EMULATOR_HOST ? " (emulator)" : ""));
+}
+
+async function runBench(count) {
+  const { doc, setDoc, addDoc, collection, increment, serverTimestamp, Timestamp } = firestore;
+  const user = doc(db, "users", "gateway-bench-user");
+  await setDoc(user, { username: "bench" });
+  await new Promise((r) => setTimeout(r, 1000));
+  latencies.length = 0;
+
+  for (let i = 0; i < count; i++) {
+    const orbId = `bench-orb-${i % 20}`;
+    await addDoc(collection(db, "events"), {
+      orgId: orbId,
+      name: `Bench ${i}`,
+      orbColor: ORB_MODES[i % ORB_MODES.length],
+      createdAt: Timestamp.now(),
+    });
+    await setDoc(
+      doc(user, "points", orbId),
+      { points: increment(10), updatedAt: serverTimestamp() },
+      { merge: true }
+    );
+  }
+  await reportBench(count);
+}
+
+// The same pace as runBench against the emulator (an event and a scan
+// every few ms), delivered straight to the handlers as one-change
+// snapshots
+async function runOfflineBench(count) {
+  const snapshot = (type, id, data) => ({
+    docChanges: () => [{ type, doc: { id, data: () => data } }],
+  });
+  onEvents(snapshot("added", "existing", {}));
+  onPoints(snapshot("added", "existing", {}));
+
+  for (let i = 0; i < count; i++) {
+    const orbId = `bench-orb-${i % 20}`;
+    const createdAt = Date.now();
+    onEvents(
+      snapshot("added", `event-${i}`, {
+        orgId: orbId,
+        orbColor: ORB_MODES[i % ORB_MODES.length],
+        createdAt: { toMillis: () => createdAt },
+      })
+    );
+    onPoints(snapshot("modified", orbId, {}));
+    await new Promise((r) => setTimeout(r, 5));
+  }
+  await reportBench(count);
+}
+
+async function reportBench(count) {
+  await new Promise((r) => setTimeout(r, FLASH_MS + 500));
+  latencies.sort((a, b) => a - b);
+  const pick = (q) => latencies[Math.min(latencies.length - 1, Math.floor(latencies.length * q))];
+  console.log(
+    `${count} events + ${count} scans -> ${latencies.length} orb changes, ` +
+      `${offline ? "snapshot" : "firestore"}->orb p50=${pick(0.5)}ms p99=${pick(0.99)}ms` +
+      ` max=${latencies[latencies.length - 1]}ms`
+  );
+  process.exit(0);
+}
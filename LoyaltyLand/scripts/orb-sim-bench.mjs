@@ -0,0 +1,219 @@
+#!/usr/bin/env node
+
+/**
+ * Times the web preview's orb simulators (modules/orb-preview/src/orbSim.js)
+ * a frame at a time, the way the dashboard drives them from
+ * requestAnimationFrame: the sketch built to WebAssembly, and its JS port.
+ * It checks the JS port shows the same pins as the sketch on every frame.
+ *
+ *   npm run orb-wasm                               build public/orb_sim.wasm
+ *   node scripts/orb-sim-bench.mjs [--orbs 40] [--seconds 60] [--seed 1]
+ *                                  [--wasm public/orb_sim.wasm] [--native]
+ *
+ * --native also builds the same sketch for this machine with $CXX (or c++)
+ * and replays the session through it (wasm/orb_sim_replay.cpp). That
+ * checks the JS port where clang can't target wasm32, and its time per
+ * frame, spent in the sketch alone, is a floor under the .wasm's.
+ *
+ * The session is a busy dashboard at 60 fps: each orb gets a new mode and
+ * speed every few seconds, some as candles, heartbeats every 250 ms with
+ * the odd gap long enough to drop to the safe effect, a wave (a phase per
+ * orb then 'Z' to all) every ten seconds, and now and then a second of
+ * streamed 'F' frames. Frame times jitter by a millisecond either way.
+ *
+ * Each simulator runs the session once to warm up, then again on fresh
+ * orbs with the clock on every frame.
+ */
+
+import { execFileSync } from "child_process";
+import fs from "fs";
+import os from "os";
+import path from "path";
+import { fileURLToPath } from "url";
+import { bytesOf, createJsOrb, loadWasmOrbs } from "../modules/orb-preview/src/orbSim.js";
+
+const FRAME_MS = 1000 / 60;
+
+const args = process.argv.slice(2);
+const argValue = (name) => {
+  const i = args.indexOf(name);
+  return i >= 0 ? args[i + 1] : undefined;
+};
+
+// mulberry32: a seeded stream, so runs compare like for like
+function rng(seed) {
+  let a = seed >>> 0;
+  return () => {
+    a = (a + 0x6d2b79f5) >>> 0;
+    let t = Math.imul(a ^ (a >>> 15), 1 | a);
+    t = (t + Math.imul(t ^ (t >>> 7), 61 | t)) ^ t;
+    return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+  };
+}
+
+// frames[f] = { t, writes: [[orb, bytes]] }
+function generateSession(orbs, seconds, random) {
+  const frames = [];
+  const pick = (s) => s[Math.floor(random() * s.length)];
+  const nextChange = Array.from({ length: orbs }, () => random() * 3000);
+  const nextBeat = new Array(orbs).fill(0);
+  const streamUntil = new Array(orbs).fill(-1);
+  let nextWave = 10_000;
+
+  for (let f = 0; f < seconds * 60; f++) {
+    const t = 1000 + f * FRAME_MS + (random() - 0.5) * 2;
+    const writes = [];
+    for (let o = 0; o < orbs; o++) {
+      if (t >= nextChange[o]) {
+        writes.push([o, `${5 + Math.floor(random() * 36)}${pick("OGRWWC")}`]);
+        nextChange[o] = t + 1500 + random() * 4000;
+      }
+      if (t >= nextBeat[o]) {
+        writes.push([o, "H"]);
+        // Now and then the controller goes quiet for longer than a lapse
+        nextBeat[o] = t + (random() < 0.01 ? 1500 : 250);
+      }
+      if (streamUntil[o] < 0 && random() < 0.0005) streamUntil[o] = t + 1000;
+      if (streamUntil[o] >= 0) {
+        if (t < streamUntil[o]) {
+          const level = () => String.fromCharCode(Math.floor(random() * 256));
+          writes.push([o, `F\x01${level()}${level()}${level()}`]);
+        } else {
+          writes.push([o, pick("OGRW")]);
+          streamUntil[o] = -1;
+        }
+      }
+    }
+    if (t >= nextWave) {
+      for (let o = 0; o < orbs; o++) writes.push([o, `P${Math.round((o * 510) / orbs)}`]);
+      for (let o = 0; o < orbs; o++) writes.push([o, "Z"]);
+      nextWave = t + 10_000;
+    }
+    frames.push({ t, writes });
+  }
+  return frames;
+}
+
+async function play(sim, session, orbCount, seed, record) {
+  const orbs = [];
+  for (let o = 0; o < orbCount; o++) orbs.push(await sim.create(seed + o));
+  const frameUs = new Float64Array(session.length);
+  const pins = record ? new Uint8Array(session.length * orbCount * 3) : null;
+
+  for (let f = 0; f < session.length; f++) {
+    const { t, writes } = session[f];
+    const started = process.hrtime.bigint();
+    for (const [o, bytes] of writes) orbs[o].write(bytes);
+    for (let o = 0; o < orbCount; o++) orbs[o].run(t);
+    frameUs[f] = Number(process.hrtime.bigint() - started) / 1000;
+    if (pins) {
+      for (let o = 0; o < orbCount; o++) pins.set(orbs[o].pins, (f * orbCount + o) * 3);
+    }
+  }
+  return { frameUs, pins };
+}
+
+// The session as orb_sim_replay.cpp reads it, bytes as orbSim.js sends them
+function encodeSession(session, orbCount, seed) {
+  const chunks = [];
+  const u32 = (v) => {
+    const b = Buffer.alloc(4);
+    b.writeUInt32LE(v);
+    chunks.push(b);
+  };
+  u32(orbCount);
+  u32(session.length);
+  u32(seed);
+  for (const { t, writes } of session) {
+    const head = Buffer.alloc(12);
+    head.writeDoubleLE(t);
+    head.writeUInt32LE(writes.length, 8);
+    chunks.push(head);
+    for (const [o, data] of writes) {
+      const bytes = bytesOf(data);
+      const w = Buffer.alloc(4);
+      w.writeUInt16LE(o);
+      w.writeUInt16LE(bytes.length, 2);
+      chunks.push(w, Buffer.from(bytes));
+    }
+  }
+  return Buffer.concat(chunks);
+}
+
+function runNative(session, orbCount, seed) {
+  const root = fileURLToPath(new URL("..", import.meta.url));
+  const wasmDir = path.join(root, "modules/orb-preview/wasm");
+  const binary = path.join(os.tmpdir(), "orb_sim_replay");
+  execFileSync(process.env.CXX || "c++", [
+    "-std=c++17", "-O2", "-I", wasmDir, "-I", path.join(root, "../PhysicalOrbComponent"),
+    path.join(wasmDir, "orb_sim_replay.cpp"), "-o", binary,
+  ]);
+  const out = execFileSync(binary, {
+    input: encodeSession(session, orbCount, seed),
+    maxBuffer: orbCount * session.length * 7 + 1024,
+  });
+  const frameUs = new Float64Array(session.length);
+  const pins = new Uint8Array(session.length * orbCount * 3);
+  for (let o = 0; o < orbCount; o++) {
+    for (let f = 0; f < session.length; f++) {
+      const r = (o * session.length + f) * 7;
+      pins.set(out.subarray(r, r + 3), (f * orbCount + o) * 3);
+      frameUs[f] += out.readUInt32LE(r + 3) / 1000;
+    }
+  }
+  return { frameUs, pins };
+}
+
+function report(label, frameUs, orbCount) {
+  const sorted = Float64Array.from(frameUs).sort();
+  const mean = sorted.reduce((a, b) => a + b, 0) / sorted.length;
+  const p99 = sorted[Math.floor(0.99 * (sorted.length - 1))];
+  const budget = (100 * mean) / (FRAME_MS * 1000);
+  console.log(
+    `${label.padEnd(6)} ${mean.toFixed(1).padStart(8)} us/frame mean, ${p99.toFixed(1)} p99,` +
+      ` ${(mean / orbCount).toFixed(2)} us per orb, ${budget.toFixed(2)}% of a 60 fps frame`
+  );
+}
+
+const orbCount = parseInt(argValue("--orbs") || "40");
+const seconds = parseInt(argValue("--seconds") || "60");
+const seed = parseInt(argValue("--seed") || "1");
+const wasmPath =
+  argValue("--wasm") || fileURLToPath(new URL("../public/orb_sim.wasm", import.meta.url));
+
+const session = generateSession(orbCount, seconds, rng(seed));
+const bytes = session.reduce((n, f) => n + f.writes.reduce((m, [, b]) => m + b.length, 0), 0);
+console.log(
+  `${orbCount} orbs, ${session.length} frames over ${seconds} s, ${bytes} command bytes\n`
+);
+
+const native = args.includes("--native");
+const sims = [["js", { create: async (s) => createJsOrb(s) }]];
+if (fs.existsSync(wasmPath)) {
+  sims.unshift(["wasm", await loadWasmOrbs(fs.readFileSync(wasmPath))]);
+} else {
+  console.log(`no ${wasmPath}; npm run orb-wasm builds it.\n`);
+}
+const compare = sims.length > 1 || native;
+
+const runs = {};
+for (const [label, sim] of sims) {
+  await play(sim, session, orbCount, seed, false);
+  runs[label] = await play(sim, session, orbCount, seed, compare);
+  report(label, runs[label].frameUs, orbCount);
+}
+if (native) {
+  runs.native = runNative(session, orbCount, seed);
+  report("native", runs.native.frameUs, orbCount);
+}
+
+for (const label of ["wasm", "native"]) {
+  if (!runs[label]) continue;
+  const a = runs[label].pins;
+  const b = runs.js.pins;
+  let differ = 0;
+  for (let i = 0; i < a.length; i += 3) {
+    if (a[i] !== b[i] || a[i + 1] !== b[i + 1] || a[i + 2] !== b[i + 2]) differ++;
+  }
+  console.log(`\n${differ} of ${a.length / 3} orb-frames differ between ${label} and js`);
+}
@@ -0,0 +1,205 @@
+#!/usr/bin/env node
+
+/**
+ * Compares the two ways of keeping a user's points:
+ *   map:           users/{uid}.points.<bizId>, UserWallet listening to users/{uid}
+ *   subcollection: users/{uid}/points/{bizId}, UserWallet listening to the
+ *                  20 most recently scanned (app/MainDashboard.js)
+ * and reports what each scan costs the wallet's listener and how scans
+ * that land at once contend.
+ *
+ *   FIRESTORE_EMULATOR_HOST=localhost:8080 node scripts/points-bench.mjs [--businesses 500] [--scans 200]
+ *
+ * Snapshot bytes are Firestore's document size (name + fields + 32, see
+ * "Storage size calculations" in the Firestore docs) of every document
+ * the listener is sent, from a second client so local writes don't count.
+ * That is what a listener re-downloads, give or take protocol framing.
+ * Contention is --businesses scans at different businesses at once, done
+ * as transactions so every conflict shows up as a retry.
+ */
+
+import { initializeApp } from "firebase/app";
+import {
+  getFirestore,
+  connectFirestoreEmulator,
+  collection,
+  doc,
+  query,
+  orderBy,
+  limit,
+  onSnapshot,
+  runTransaction,
+  setDoc,
+  writeBatch,
+  increment,
+  serverTimestamp,
+  Timestamp,
+} from "firebase/firestore";
+
+const WALLET_PAGE = 20; // as in MainDashboard.js
+
+const args = process.argv.slice(2);
+const argValue = (name) => {
+  const i = args.indexOf(name);
+  return i >= 0 ? args[i + 1] : undefined;
+};
+
+if (!process.env.FIRESTORE_EMULATOR_HOST) {
+  console.error("Set FIRESTORE_EMULATOR_HOST; this writes test data");
+  process.exit(1);
+}
+const app = initializeApp({ projectId: argValue("--project") || "nsch3-eb96c", apiKey: "bench" });
+const db = getFirestore(app);
+// The wallet listens from its own client, so every snapshot it counts came
+// from the server rather than from this process's local writes
+const walletDb = getFirestore(initializeApp(app.options, "wallet"));
+const [host, port] = process.env.FIRESTORE_EMULATOR_HOST.split(":");
+connectFirestoreEmulator(db, host, parseInt(port));
+connectFirestoreEmulator(walletDb, host, parseInt(port));
+
+const businessCount = parseInt(argValue("--businesses") || "500");
+const scanCount = parseInt(argValue("--scans") || "200");
+const businesses = Array.from({ length: businessCount }, (_, i) => `business-${i}`);
+
+// ---- Document size, as Firestore counts it ----
+
+const utf8 = (s) => Buffer.byteLength(s, "utf8");
+
+function valueSize(v) {
+  if (v === null || typeof v === "boolean") return 1;
+  if (typeof v === "number" || v instanceof Timestamp) return 8;
+  if (typeof v === "string") return utf8(v) + 1;
+  if (Array.isArray(v)) return v.reduce((n, x) => n + valueSize(x), 0);
+  return Object.entries(v).reduce((n, [k, x]) => n + utf8(k) + 1 + valueSize(x), 0);
+}
+
+function documentSize(snapshot) {
+  const name = snapshot.ref.path.split("/").reduce((n, part) => n + utf8(part) + 1, 16);
+  return name + valueSize(snapshot.data()) + 32;
+}
+
+// ---- Listener cost per scan ----
+
+// Runs the scans one at a time, each waiting for the listener to see it
+async function measureListener(subscribe, scan) {
+  let bytes = 0;
+  let waiting = null;
+  const unsub = subscribe((sent) => {
+    bytes += sent;
+    if (waiting) waiting();
+  });
+  await new Promise((r) => setTimeout(r, 500)); // initial snapshot
+  bytes = 0;
+
+  for (let i = 0; i < scanCount; i++) {
+    const seen = new Promise((r) => (waiting = r));
+    await scan(businesses[(i * 7919) % businessCount]);
+    await seen;
+  }
+  unsub();
+  return bytes / scanCount;
+}
+
+const profile = { username: "bench", email: "bench@example.com", createdAt: new Date().toISOString() };
+
+async function seedMap(uid) {
+  const points = {};
+  for (const b of businesses) points[b] = 10;
+  await setDoc(doc(db, "users", uid), { ...profile, points });
+}
+
+async function seedSubcollection(uid) {
+  await setDoc(doc(db, "users", uid), profile);
+  for (let i = 0; i < businessCount; i += 500) {
+    const batch = writeBatch(db);
+    for (const b of businesses.slice(i, i + 500)) {
+      batch.set(doc(db, "users", uid, "points", b), { points: 10, updatedAt: serverTimestamp() });
+    }
+    await batch.commit();
+  }
+}
+
+async function listenerBytes() {
+  const mapUid = `points-bench-map-${Date.now()}`;
+  await seedMap(mapUid);
+  const mapBytes = await measureListener(
+    (sent) => onSnapshot(doc(walletDb, "users", mapUid), (s) => s.exists() && sent(documentSize(s))),
+    (bizId) => setDoc(doc(db, "users", mapUid), { points: { [bizId]: increment(10) } }, { merge: true })
+  );
+
+  const subUid = `points-bench-sub-${Date.now()}`;
+  await seedSubcollection(subUid);
+  const visible = query(
+    collection(walletDb, "users", subUid, "points"),
+    orderBy("updatedAt", "desc"),
+    limit(WALLET_PAGE)
+  );
+  const subBytes = await measureListener(
+    (sent) =>
+      onSnapshot(visible, (s) => {
+        let bytes = 0;
+        for (const change of s.docChanges()) {
+          if (change.type !== "removed") bytes += documentSize(change.doc);
+        }
+        sent(bytes);
+      }),
+    (bizId) =>
+      setDoc(
+        doc(db, "users", subUid, "points", bizId),
+        { points: increment(10), updatedAt: serverTimestamp() },
+        { merge: true }
+      )
+  );
+  return { mapBytes, subBytes };
+}
+
+// ---- Contention ----
+
+// target(bizId) -> [document, whether points is a map in it]
+async function contention(label, target) {
+  let attempts = 0;
+  const start = Date.now();
+  const results = await Promise.allSettled(
+    businesses.map(async (bizId) => {
+      const began = Date.now();
+      const [ref, inMap] = target(bizId);
+      await runTransaction(db, async (tx) => {
+        attempts++;
+        const snap = await tx.get(ref);
+        const points = snap.exists() ? snap.data().points : undefined;
+        if (inMap) {
+          tx.set(ref, { points: { [bizId]: ((points || {})[bizId] || 0) + 10 } }, { merge: true });
+        } else {
+          tx.set(ref, { points: (points || 0) + 10 }, { merge: true });
+        }
+      });
+      return Date.now() - began;
+    })
+  );
+  const latencies = results.filter((r) => r.status === "fulfilled").map((r) => r.value);
+  const failed = results.length - latencies.length;
+  latencies.sort((a, b) => a - b);
+  const pick = (q) => latencies[Math.min(latencies.length - 1, Math.floor(latencies.length * q))];
+  console.log(
+    `  ${label}: ${attempts} attempts, ${failed} gave up, ` +
+      `p50 ${pick(0.5)} ms, p99 ${pick(0.99)} ms, all done in ${Date.now() - start} ms`
+  );
+}
+
+const { mapBytes, subBytes } = await listenerBytes();
+console.log(`${businessCount} businesses, ${scanCount} scans`);
+console.log(`wallet listener bytes per scan:`);
+console.log(`  map in users/{uid}:         ${mapBytes.toFixed(0)}`);
+console.log(`  users/{uid}/points/{bizId}: ${subBytes.toFixed(0)} (${(mapBytes / subBytes).toFixed(0)}x less)`);
+
+console.log(`\n${businessCount} scans at once, one per business:`);
+const mapUid = `points-bench-map-tx-${Date.now()}`;
+await seedMap(mapUid);
+await contention("map in users/{uid}        ", () => [doc(db, "users", mapUid), true]);
+const subUid = `points-bench-sub-tx-${Date.now()}`;
+await seedSubcollection(subUid);
+await contention("users/{uid}/points/{bizId}", (bizId) => [
+  doc(db, "users", subUid, "points", bizId),
+  false,
+]);
+process.exit(0);
@@ -0,0 +1,186 @@
+#!/usr/bin/env node
+
+/**
+ * Replays a stream of barcode frames through the scanner's pipeline
+ * (services/scanPipeline.js) and the old one, and reports scans per minute.
+ *
+ *   node scripts/scan-bench.mjs [--people 300] [--seed 1]
+ *   node scripts/scan-bench.mjs --record frames.jsonl    save the generated stream
+ *   node scripts/scan-bench.mjs --frames frames.jsonl    replay a recorded one
+ *
+ * A frame is one onBarcodeScanned callback: {"t": ms, "data": code}. The
+ * generated stream is a queue at the door: each code is in view for
+ * 0.6-1.6 s at 15 fps, read on 80% of frames, with a short gap between
+ * people and sometimes two codes in view at once. Runs in virtual time;
+ * each write takes 150 ms plus an exponential tail (median ~320 ms).
+ *
+ * The old pipeline disarms on the first frame (callbacks keep arriving
+ * for one 50 ms render) and waits for its write. It runs twice: as
+ * shipped, where the alert, goBack and reopening the scanner take
+ * REOPEN_MS; and with an instant re-arm once the write lands.
+ *
+ * Last, one person keeps showing the same code: in two openings of the
+ * scanner, then 20 more times 6 s apart. It should earn points once, and
+ * once more when they come back after the repeat window.
+ */
+
+import fs from "fs";
+import {
+  REPEAT_SCAN_WINDOW_MS,
+  createScanPipeline,
+  createPointsWriter,
+} from "../services/scanPipeline.js";
+
+const FPS = 15;
+const READ_RATE = 0.8;
+const RENDER_LAG_MS = 50;
+const REOPEN_MS = 2500;
+
+const args = process.argv.slice(2);
+const argValue = (name) => {
+  const i = args.indexOf(name);
+  return i >= 0 ? args[i + 1] : undefined;
+};
+
+// mulberry32: a seeded stream, so runs compare like for like
+function rng(seed) {
+  let a = seed >>> 0;
+  return () => {
+    a = (a + 0x6d2b79f5) >>> 0;
+    let t = Math.imul(a ^ (a >>> 15), 1 | a);
+    t = (t + Math.imul(t ^ (t >>> 7), 61 | t)) ^ t;
+    return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+  };
+}
+
+function generateFrames(people, random) {
+  const frames = [];
+  let t = 0;
+  for (let i = 0; i < people; i++) {
+    const start = t;
+    const dwell = 600 + random() * 1000;
+    for (let f = start; f < start + dwell; f += 1000 / FPS) {
+      if (random() < READ_RATE) frames.push({ t: Math.round(f), data: `guest-${i}` });
+    }
+    // Next person steps up; one time in five their code shows early
+    t = random() < 0.2 ? start + dwell * 0.7 : start + dwell + 300 + random() * 500;
+  }
+  return frames.sort((a, b) => a.t - b.t);
+}
+
+// Virtual clock with a network whose writes finish at a given time
+function createNetwork(random) {
+  const inFlight = [];
+  let now = 0;
+  return {
+    now: () => now,
+    writes: 0,
+    write() {
+      this.writes++;
+      const latency = 150 - 250 * Math.log(1 - random());
+      return new Promise((resolve) => inFlight.push({ due: now + latency, resolve }));
+    },
+    // Runs every write that finishes by t (and whatever it sets off)
+    async advance(t) {
+      for (;;) {
+        inFlight.sort((a, b) => a.due - b.due);
+        if (!inFlight.length || inFlight[0].due > t) break;
+        const next = inFlight.shift();
+        now = next.due;
+        next.resolve();
+        await new Promise((r) => setImmediate(r));
+      }
+      now = Math.max(now, t);
+    },
+  };
+}
+
+async function runPipeline(frames, seed) {
+  const net = createNetwork(rng(seed));
+  const accepted = [];
+  const writer = createPointsWriter({ write: () => net.write() });
+  const pipeline = createScanPipeline({
+    now: net.now,
+    onAccept: (code) => {
+      accepted.push({ code, t: net.now() });
+      writer.add(code);
+    },
+  });
+  for (const frame of frames) {
+    await net.advance(frame.t);
+    pipeline.offer(frame.data);
+  }
+  await net.advance(Infinity);
+  return { accepted, writes: net.writes };
+}
+
+async function runLegacy(frames, seed, rearmMs) {
+  const net = createNetwork(rng(seed));
+  const accepted = [];
+  // setScanned() calls, each showing up on the render after it
+  let scanned = false;
+  const renders = [];
+  for (const frame of frames) {
+    await net.advance(frame.t);
+    renders.sort((a, b) => a.at - b.at);
+    while (renders.length && renders[0].at <= net.now()) scanned = renders.shift().value;
+    if (scanned) continue;
+    accepted.push({ code: frame.data, t: net.now() });
+    renders.push({ at: net.now() + RENDER_LAG_MS, value: true });
+    net.write().then(() => renders.push({ at: net.now() + rearmMs, value: false }));
+  }
+  await net.advance(Infinity);
+  return { accepted, writes: net.writes };
+}
+
+function report(label, frames, { accepted, writes }) {
+  const firstSeen = new Map();
+  for (const f of frames) if (!firstSeen.has(f.data)) firstSeen.set(f.data, f.t);
+  const people = firstSeen.size;
+  const scanned = new Map();
+  for (const a of accepted) {
+    if (!scanned.has(a.code)) scanned.set(a.code, a.t - firstSeen.get(a.code));
+  }
+  const waits = [...scanned.values()].sort((a, b) => a - b);
+  const minutes = (frames[frames.length - 1].t - frames[0].t) / 60000;
+  const pct = (p) => Math.round(waits[Math.min(waits.length - 1, Math.floor(p * waits.length))]);
+
+  console.log(label);
+  const missed = people - scanned.size;
+  console.log(`  ${(scanned.size / minutes).toFixed(1)} scans/min, ${missed}/${people} codes missed`);
+  console.log(`  ${accepted.length - scanned.size} duplicate accepts, ${writes} writes`);
+  console.log(`  first sighting -> accept: p50 ${pct(0.5)} ms, p95 ${pct(0.95)} ms\n`);
+}
+
+const seed = parseInt(argValue("--seed") || "1");
+const frames = argValue("--frames")
+  ? fs.readFileSync(argValue("--frames"), "utf8").trim().split("\n").map((l) => JSON.parse(l))
+  : generateFrames(parseInt(argValue("--people") || "300"), rng(seed));
+
+if (argValue("--record")) {
+  fs.writeFileSync(argValue("--record"), frames.map((f) => JSON.stringify(f)).join("\n") + "\n");
+}
+
+const people = new Set(frames.map((f) => f.data)).size;
+const minutes = (frames[frames.length - 1].t - frames[0].t) / 60000;
+const arriving = (people / minutes).toFixed(1);
+console.log(`${frames.length} frames, ${people} codes over ${minutes.toFixed(1)} min (${arriving}/min)\n`);
+report("old, as shipped", frames, await runLegacy(frames, seed, REOPEN_MS));
+report("old, re-armed when the write lands", frames, await runLegacy(frames, seed, RENDER_LAG_MS));
+report("new: dedupe + throttle, background writes", frames, await runPipeline(frames, seed));
+
+// Two scanner screens sharing one map, as QRScanner does
+const recent = new Map();
+let clock = 0;
+let farmed = 0;
+const opened = () => createScanPipeline({ recent, now: () => clock, onAccept: () => farmed++ });
+for (let opening = 0; opening < 2; opening++, clock += 30_000) {
+  const pipeline = opened();
+  for (let i = 0; i < 10; i++, clock += 100) pipeline.offer("same-business");
+}
+const kept = opened();
+for (let i = 0; i < 20; i++, clock += 6000) kept.offer("same-business");
+console.log(`same code re-scanned 40 times in ${(clock / 60000).toFixed(0)} min: ${farmed} accepted`);
+clock += REPEAT_SCAN_WINDOW_MS;
+kept.offer("same-business");
+console.log(`and again ${REPEAT_SCAN_WINDOW_MS / 60000} min later: ${farmed} accepted in all`);
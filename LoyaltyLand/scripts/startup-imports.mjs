@@ -0,0 +1,86 @@
+#!/usr/bin/env node
+
+/**
+ * Lists what the app evaluates before its first screen: every module
+ * reachable through static imports from the files under app/. In a
+ * release build Expo Router loads every route up front (asyncRoutes is
+ * only on for web and development), so a heavy SDK imported at the top
+ * of any route, or of anything a route imports, is on the cold-start
+ * path. Dynamic import() and lazyScreen() are where the graph stops.
+ *
+ *   node scripts/startup-imports.mjs [--root .]
+ *
+ * Prints how many of the app's own modules load at startup, which
+ * packages they pull in, and for each heavy SDK the modules that import
+ * it. Only this repo's sources are read, so it runs without
+ * node_modules; package sizes aren't counted.
+ */
+
+import fs from "fs";
+import path from "path";
+
+const HEAVY = [
+  "firebase/firestore",
+  "expo-camera",
+  "expo-location",
+  "expo-task-manager",
+  "react-native-maps",
+];
+const EXTENSIONS = [".tsx", ".ts", ".jsx", ".js", ".mjs"];
+
+const args = process.argv.slice(2);
+const argValue = (name) => {
+  const i = args.indexOf(name);
+  return i >= 0 ? args[i + 1] : undefined;
+};
+const root = path.resolve(argValue("--root") || ".");
+
+// import x from "y", import "y", export { x } from "y"; not import("y")
+const STATIC_IMPORT = /^\s*(?:import|export)\s+(?:[^'"]*?\s+from\s+)?["']([^"']+)["']/gm;
+
+function resolveFile(base) {
+  const candidates = [base, ...EXTENSIONS.map((e) => base + e)];
+  candidates.push(...EXTENSIONS.map((e) => path.join(base, "index" + e)));
+  return candidates.find((c) => fs.existsSync(c) && fs.statSync(c).isFile());
+}
+
+function resolve(spec, from) {
+  if (spec.startsWith("@/")) return resolveFile(path.join(root, spec.slice(2)));
+  if (spec.startsWith(".")) return resolveFile(path.resolve(path.dirname(from), spec));
+  return null; // a package
+}
+
+function routesUnder(dir) {
+  return fs.readdirSync(dir, { withFileTypes: true }).flatMap((entry) => {
+    const full = path.join(dir, entry.name);
+    if (entry.isDirectory()) return routesUnder(full);
+    return EXTENSIONS.includes(path.extname(entry.name)) ? [full] : [];
+  });
+}
+
+const seen = new Set();
+const packages = new Map(); // package -> modules importing it
+const queue = routesUnder(path.join(root, "app"));
+while (queue.length > 0) {
+  const file = queue.pop();
+  if (seen.has(file)) continue;
+  seen.add(file);
+  const source = fs.readFileSync(file, "utf8");
+  for (const [, spec] of source.matchAll(STATIC_IMPORT)) {
+    const local = resolve(spec, file);
+    if (local) {
+      queue.push(local);
+    } else if (!spec.startsWith(".") && !spec.startsWith("@/")) {
+      if (!packages.has(spec)) packages.set(spec, new Set());
+      packages.get(spec).add(path.relative(root, file));
+    }
+  }
+}
+
+console.log(`${seen.size} app modules load at startup, importing ${packages.size} packages`);
+for (const name of HEAVY) {
+  const users = packages.get(name);
+  console.log(
+    `  ${name.padEnd(20)} ${users ? [...users].sort().join(", ") : "not on the startup path"}`
+  );
+}
@@ -0,0 +1,109 @@
+// Events whose boundary is drawn as a polygon (a storefront, a stadium
+// section) rather than a circle round their coordinates. The event keeps
+// its corners as `boundary`, an array of GeoPoints in order; the centre
+// goes in `coordinates` as for any other event.
+//
+// Rings here are [[latitude, longitude]] and follow the rules of
+// modules/geofence/cpp/PolygonFences.h, which does the same tests
+// natively for many events at once: a ring with fewer than 3 corners or
+// more than 65535, no area, or a coordinate that isn't a finite number is
+// rejected, and containment is the same ray cast. Nothing here imports
+// expo, so it runs under node.
+
+// PolygonFences.h counts a row's edges in 16 bits
+const MAX_RING_CORNERS = 65535;
+
+const EARTH_RADIUS_M = 6371000;
+const RAD = Math.PI / 180;
+
+// The ring's corners, without a closing corner that repeats the first;
+// null if the boundary isn't a usable ring
+export function ringOf(boundary) {
+  if (!Array.isArray(boundary)) return null;
+  const ring = boundary.map((p) => [p?.latitude, p?.longitude]);
+  const first = ring[0];
+  const last = ring[ring.length - 1];
+  if (ring.length > 1 && first[0] === last[0] && first[1] === last[1]) ring.pop();
+  return validRing(ring) ? ring : null;
+}
+
+// Twice the signed area (shoelace), about the first corner's latitude so a
+// straight line's rounding stays near zero
+function twiceArea(ring) {
+  const lat0 = ring[0][0];
+  let sum = 0;
+  for (let i = 0, j = ring.length - 1; i < ring.length; j = i++) {
+    sum += (ring[j][1] - ring[i][1]) * (ring[j][0] + ring[i][0] - 2 * lat0);
+  }
+  return sum;
+}
+
+function bounds(ring) {
+  const lats = ring.map((p) => p[0]);
+  const lons = ring.map((p) => p[1]);
+  return {
+    south: Math.min(...lats),
+    north: Math.max(...lats),
+    west: Math.min(...lons),
+    east: Math.max(...lons),
+  };
+}
+
+export function validRing(ring) {
+  if (!Array.isArray(ring) || ring.length < 3 || ring.length > MAX_RING_CORNERS) return false;
+  if (!ring.every((p) => Number.isFinite(p[0]) && Number.isFinite(p[1]))) return false;
+  const { south, north, west, east } = bounds(ring);
+  return Math.abs(twiceArea(ring)) > (north - south) * (east - west) * 1e-9;
+}
+
+// The middle of the ring's bounding box
+export function ringCentre(ring) {
+  const { south, north, west, east } = bounds(ring);
+  return { latitude: (south + north) / 2, longitude: (west + east) / 2 };
+}
+
+// Metres east and north of (latitude, longitude), equirectangular
+function offsetM(latitude, longitude, p) {
+  return [
+    (p[1] - longitude) * RAD * Math.cos(latitude * RAD) * EARTH_RADIUS_M,
+    (p[0] - latitude) * RAD * EARTH_RADIUS_M,
+  ];
+}
+
+// How far the furthest corner is from (latitude, longitude): every point
+// of the ring is within this of it
+export function ringExtentM(ring, latitude, longitude) {
+  let furthest = 0;
+  for (const p of ring) {
+    furthest = Math.max(furthest, Math.hypot(...offsetM(latitude, longitude, p)));
+  }
+  return furthest;
+}
+
+// W. R. Franklin's pnpoly with x as longitude, as PolygonFences.h does
+export function ringContains(ring, latitude, longitude) {
+  let inside = false;
+  for (let i = 0, j = ring.length - 1; i < ring.length; j = i++) {
+    const [ay, ax] = ring[i];
+    const [by, bx] = ring[j];
+    const crosses = ay > latitude !== by > latitude;
+    if (crosses && longitude < ((bx - ax) * (latitude - ay)) / (by - ay) + ax) inside = !inside;
+  }
+  return inside;
+}
+
+// Metres from (latitude, longitude) to the nearest point of the ring's
+// edge, inside or out
+export function distanceToRingM(ring, latitude, longitude) {
+  let nearest = Infinity;
+  for (let i = 0, j = ring.length - 1; i < ring.length; j = i++) {
+    const [ax, ay] = offsetM(latitude, longitude, ring[i]);
+    const [bx, by] = offsetM(latitude, longitude, ring[j]);
+    const dx = bx - ax;
+    const dy = by - ay;
+    const lengthSq = dx * dx + dy * dy;
+    const t = lengthSq > 0 ? Math.max(0, Math.min(1, -(ax * dx + ay * dy) / lengthSq)) : 0;
+    nearest = Math.min(nearest, Math.hypot(ax + t * dx, ay + t * dy));
+  }
+  return nearest;
+}
@@ -5,8 +5,7 @@ import {
   onAuthStateChanged,
   User,
 } from 'firebase/auth';
-import { doc, setDoc, getDoc } from 'firebase/firestore';
-import { auth, db } from '../constants/firebaseConfig';
+import { auth, getDb } from '../constants/firebaseConfig';
 import { useAuthStore, UserRole } from '../store/authStore';
 
 interface PersonalProfileData {
@@ -32,12 +31,15 @@ export async function signUp(
   const user = userCredential.user;
 
   try {
+    // Firestore stays out of the startup bundle path until it's needed
+    const { doc, setDoc } = await import('firebase/firestore');
+    const db = getDb();
+
     if (role === 'personal') {
       const data = profileData as PersonalProfileData;
       await setDoc(doc(db, 'users', user.uid), {
         username: data.username,
         email: data.email,
-        points: 0,
         createdAt: new Date().toISOString(),
       });
     } else {
@@ -77,6 +79,9 @@ export async function signOut(): Promise<void> {
 }
 
 export async function getUserRole(uid: string): Promise<UserRole> {
+  const { doc, getDoc } = await import('firebase/firestore');
+  const db = getDb();
+
   // Check personal users collection first
   const userDoc = await getDoc(doc(db, 'users', uid));
   if (userDoc.exists()) {
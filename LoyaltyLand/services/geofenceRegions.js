@@ -0,0 +1,104 @@
+// Which orbs the OS watches as geofences, and the fewest calls that take
+// its registered regions from one set to the next.
+//
+// expo-location keeps one list of regions per task, and
+// startGeofencingAsync replaces the whole list: the OS drops every region,
+// adds them back and re-evaluates them all, and an enter it was about to
+// report is lost. So on Android each region gets a task of its own, a
+// slot. Adding or dropping an orb touches only its slot, and the regions
+// the user is walking into carry on undisturbed.
+//
+// That relies on tasks not touching each other's regions, which holds on
+// Android, where each task has its own geofencing PendingIntent. On iOS
+// the monitored regions are one set for the whole app, and
+// expo-location's iOS consumer looks to stop every region in that set
+// whenever a task starts or stops. That hasn't been checked against its
+// source or on a device. If it does, slots would wipe each other out, so
+// iOS keeps one task with the whole list (planList) and restarts it only
+// when the chosen set changes.
+//
+// scripts/geofence-bench.mjs walks past 200 orbs all three ways. Nothing
+// here imports expo, so that runs under node.
+
+import { ORB_RADIUS_M, distanceM } from "./locationSampling.js";
+
+// iOS watches at most 20 regions per app (Android allows 100)
+export const REGION_LIMIT = 20;
+
+// Regions are chosen again once the phone is this far from where they
+// last were
+export const RECHOOSE_M = 50;
+
+// A watched orb counts as this much closer when choosing, so walking along
+// a row of orbs doesn't swap the farthest one in and out
+export const KEEP_MARGIN_M = 25;
+
+export function regionFor(event) {
+  return {
+    identifier: event.id,
+    latitude: event.latitude,
+    longitude: event.longitude,
+    radius: ORB_RADIUS_M,
+    notifyOnEnter: true,
+    notifyOnExit: true,
+  };
+}
+
+// The limit events nearest the phone, as regions. watched: ids already
+// registered.
+export function chooseRegions(events, latitude, longitude, watched, limit = REGION_LIMIT) {
+  const scored = events.map((e) => ({
+    e,
+    d:
+      distanceM(latitude, longitude, e.latitude, e.longitude) -
+      (watched.has(e.id) ? KEEP_MARGIN_M : 0),
+  }));
+  scored.sort((a, b) => a.d - b.d);
+  return scored.slice(0, limit).map((s) => regionFor(s.e));
+}
+
+const sameRegion = (a, b) =>
+  a.latitude === b.latitude && a.longitude === b.longitude && a.radius === b.radius;
+
+// The single task's whole list when it differs from registered, else null
+export function planList(registered, wanted) {
+  const key = (rs) =>
+    rs.map((r) => `${r.identifier}@${r.latitude},${r.longitude},${r.radius}`).sort().join("|");
+  return key(registered) === key(wanted) ? null : wanted;
+}
+
+// slots[i] is the region slot i's task watches, or null. Returns the calls
+// that take the slots to wanted, in order, each { slot, region } with a
+// null region meaning stop that slot. A slot whose orb isn't wanted any
+// more takes a new one in the same call; only what's left over starts or
+// stops on its own. A moved orb is registered again where it is.
+export function planSlots(slots, wanted) {
+  const wantedById = new Map(wanted.map((r) => [r.identifier, r]));
+  const placed = new Set();
+  const calls = [];
+  const unwanted = [];
+  const empty = [];
+  slots.forEach((region, slot) => {
+    const want = region && wantedById.get(region.identifier);
+    if (!region) {
+      empty.push(slot);
+    } else if (!want || placed.has(want.identifier)) {
+      unwanted.push(slot);
+    } else {
+      placed.add(want.identifier);
+      if (!sameRegion(region, want)) calls.push({ slot, region: want });
+    }
+  });
+
+  // Reusing an unwanted slot saves stopping it
+  const free = [...unwanted, ...empty];
+  for (const region of wanted) {
+    if (placed.has(region.identifier) || free.length === 0) continue;
+    placed.add(region.identifier);
+    calls.push({ slot: free.shift(), region });
+  }
+  for (const slot of free) {
+    if (slots[slot]) calls.push({ slot, region: null });
+  }
+  return calls;
+}
@@ -0,0 +1,220 @@
+// Decides how hard the phone should look for its location, from how far it
+// is from the nearest event. Far from every orb, the OS's coarsest updates
+// (cell towers, a fix per kilometre moved) are enough; the GPS only comes
+// on once an orb is a few hundred metres away.
+//
+// createEventIndex keeps the grid cells within reach of an event and works
+// out, once per event list, how close any point in each one can get to an
+// event. A fix then costs one cell read to find its band, and only cells
+// in the closest band keep a list of events to measure against. Nothing here imports
+// expo, so scripts/location-bench.mjs runs it under node.
+//
+// An event with a polygon boundary (services/eventBoundary.js) carries its
+// ring and extentM, how far its furthest corner is from its coordinates.
+// The grids count it as that much closer, and the phone is at it while
+// inside the ring rather than within ORB_RADIUS_M.
+
+import { distanceToRingM, ringContains } from "./eventBoundary.js";
+
+// Closest band first. accuracy names an expo-location Accuracy
+// (services/orbMonitoring.js maps them). A band applies while the nearest
+// event may be within withinM.
+export const SAMPLING_BANDS = [
+  { name: "at", withinM: 200, accuracy: "high", timeIntervalMs: 10_000, distanceIntervalM: 10 },
+  { name: "near", withinM: 1500, accuracy: "balanced", timeIntervalMs: 60_000, distanceIntervalM: 50 },
+  { name: "town", withinM: 5000, accuracy: "low", timeIntervalMs: 300_000, distanceIntervalM: 250 },
+  // Cell-tower fixes: the nearest thing to iOS's significant-change service
+  { name: "far", withinM: Infinity, accuracy: "lowest", timeIntervalMs: 900_000, distanceIntervalM: 1000 },
+];
+
+// How close counts as being at an orb, and how far past that before leaving
+export const ORB_RADIUS_M = 50;
+export const EXIT_MARGIN_M = 20;
+
+// A coarser band only after this many fixes say so, so a fix on a band's
+// edge doesn't restart location updates back and forth
+export const SETTLE_FIXES = 2;
+
+const CELL_M = 200;
+const EARTH_RADIUS_M = 6371000;
+const RAD = Math.PI / 180;
+
+// Metres, equirectangular; fine over a town
+export function distanceM(lat1, lon1, lat2, lon2) {
+  const x = (lon2 - lon1) * RAD * Math.cos(((lat1 + lat2) / 2) * RAD);
+  const y = (lat2 - lat1) * RAD;
+  return Math.hypot(x, y) * EARTH_RADIUS_M;
+}
+
+export function bandFor(metres) {
+  for (let i = 0; i < SAMPLING_BANDS.length; i++) {
+    if (metres <= SAMPLING_BANDS[i].withinM) return i;
+  }
+  return SAMPLING_BANDS.length - 1;
+}
+
+// Two grids, each keeping only the cells near some event, so the cost is
+// per event however far apart the events are. Fine CELL_M cells reach
+// past the near band and keep the events to measure for the closest band.
+// Coarse COARSE_CELL_M cells reach VAGUE_FIX_M past the town band, where
+// a bound a kilometre off only means updates a little finer than needed.
+// Beyond them the bound is their reach. That has to be far enough that a
+// far-band fix, less its accuracy, still lands past the town band.
+const COARSE_CELL_M = 1000;
+const VAGUE_FIX_M = 2000;
+
+// Cells are cellM tall everywhere; each row's cells are as wide in degrees
+// of longitude as cellM is at that row, so they stay about square at any
+// latitude. Keys are row * CELL_KEY_ROW + column.
+const CELL_KEY_ROW = 2 ** 21;
+
+// minM: cell -> closest any point in the cell can be to an event (from
+// the centre, less half the diagonal and the event's extent, so a cell's
+// band is never coarser than it should be), for cells where that is
+// within reachM. nearby: cell -> events that may be within nearbyM of it.
+function createLayer(events, cellM, reachM, nearbyM) {
+  const latStep = cellM / (EARTH_RADIUS_M * RAD);
+  const lonStepOf = (row) => latStep / Math.max(0.01, Math.cos((row + 0.5) * latStep * RAD));
+  const halfDiagonal = (cellM * Math.SQRT2) / 2;
+  const minM = new Map();
+  const nearby = new Map();
+  for (const e of events) {
+    const extentM = e.extentM || 0;
+    const span = Math.ceil((reachM + halfDiagonal + extentM) / cellM);
+    const row0 = Math.floor(e.latitude / latStep);
+    for (let r = row0 - span; r <= row0 + span; r++) {
+      const lat = (r + 0.5) * latStep;
+      const lonStep = lonStepOf(r);
+      const col0 = Math.floor(e.longitude / lonStep);
+      for (let c = col0 - span; c <= col0 + span; c++) {
+        const d =
+          distanceM(lat, (c + 0.5) * lonStep, e.latitude, e.longitude) - halfDiagonal - extentM;
+        if (d > reachM) continue;
+        const key = r * CELL_KEY_ROW + c;
+        const best = minM.get(key);
+        if (best === undefined || d < best) minM.set(key, Math.max(0, d));
+        if (d <= nearbyM) {
+          const close = nearby.get(key);
+          if (close) close.push(e);
+          else nearby.set(key, [e]);
+        }
+      }
+    }
+  }
+  return {
+    minM,
+    nearby,
+    keyOf(latitude, longitude) {
+      const r = Math.floor(latitude / latStep);
+      return r * CELL_KEY_ROW + Math.floor(longitude / lonStepOf(r));
+    },
+  };
+}
+
+// events: [{ id, latitude, longitude }], plus ring and extentM for a
+// polygon boundary
+export function createEventIndex(events) {
+  // A cell a grid doesn't have is known to be further than its reach
+  const fineReach = SAMPLING_BANDS[1].withinM + CELL_M;
+  const coarseReach = SAMPLING_BANDS[SAMPLING_BANDS.length - 2].withinM + VAGUE_FIX_M;
+  const fine = createLayer(events, CELL_M, fineReach, SAMPLING_BANDS[0].withinM);
+  const coarse = createLayer(events, COARSE_CELL_M, coarseReach, -1);
+
+  return {
+    events,
+    cellsBuilt: fine.minM.size + coarse.minM.size,
+    // minM: a lower bound on the distance to the nearest event;
+    // nearby: the events that could be within the closest band
+    lookup(latitude, longitude) {
+      const key = fine.keyOf(latitude, longitude);
+      const m = fine.minM.get(key);
+      if (m !== undefined) return { minM: m, nearby: fine.nearby.get(key) || [] };
+      const far = coarse.minM.get(coarse.keyOf(latitude, longitude));
+      return { minM: far === undefined ? coarseReach : Math.max(fineReach, far), nearby: [] };
+    },
+  };
+}
+
+// offer(fix) takes each location the OS delivers ({ t, latitude,
+// longitude, accuracy } with accuracy in metres) and calls
+//   onBand(band)     when updates should switch to SAMPLING_BANDS[band]
+//   onEnter(event)   when the phone comes within ORB_RADIUS_M of an event,
+//                    or inside its ring
+//   onExit(event)    when it leaves again
+// A fix counts as close as its accuracy lets it be, so a vague fix steps
+// up rather than down. fencesAt(latitude, longitude), if given, returns
+// the ids of the polygon events containing the point (modules/geofence
+// does it natively); without it the nearby rings are ray cast here.
+// onEnter / onExit for circle events can be left out when the OS's own
+// geofences report those; circleEvents: false does that and still calls
+// them for polygon events, which the OS can't fence.
+export function createLocationSampler({
+  index,
+  onBand = () => {},
+  onEnter = () => {},
+  onExit = () => {},
+  fencesAt = null,
+  circleEvents = true,
+}) {
+  let band = SAMPLING_BANDS.length - 1;
+  let coarserFixes = 0;
+  const inside = new Set();
+
+  return {
+    band: () => band,
+    setIndex(next) {
+      index = next;
+    },
+    offer(fix) {
+      const { minM, nearby } = index.lookup(fix.latitude, fix.longitude);
+      const accuracy = fix.accuracy || 0;
+      const wanted = bandFor(Math.max(0, minM - accuracy));
+
+      if (wanted < band) {
+        band = wanted;
+        coarserFixes = 0;
+        onBand(band);
+      } else if (wanted > band && ++coarserFixes >= SETTLE_FIXES) {
+        band = wanted;
+        coarserFixes = 0;
+        onBand(band);
+      } else if (wanted === band) {
+        coarserFixes = 0;
+      }
+
+      const { latitude, longitude } = fix;
+      let fenced = null; // polygon events containing the fix, asked once
+      const inRing = (e) => {
+        if (!fencesAt) return ringContains(e.ring, latitude, longitude);
+        if (!fenced) fenced = new Set(fencesAt(latitude, longitude));
+        return fenced.has(e.id);
+      };
+      const reported = (e) => circleEvents || e.ring;
+
+      for (const e of nearby) {
+        if (inside.has(e.id)) continue;
+        const at = e.ring
+          ? inRing(e)
+          : distanceM(latitude, longitude, e.latitude, e.longitude) <= ORB_RADIUS_M;
+        if (at) {
+          inside.add(e.id);
+          if (reported(e)) onEnter(e);
+        }
+      }
+      for (const id of inside) {
+        const e = index.events.find((x) => x.id === id);
+        let left = true;
+        if (e?.ring) {
+          left = !inRing(e) && distanceToRingM(e.ring, latitude, longitude) > EXIT_MARGIN_M;
+        } else if (e) {
+          const d = distanceM(latitude, longitude, e.latitude, e.longitude);
+          left = d > ORB_RADIUS_M + EXIT_MARGIN_M;
+        }
+        if (left) {
+          inside.delete(id);
+          if (e && reported(e)) onExit(e);
+        }
+      }
+    },
+  };
+}
@@ -0,0 +1,290 @@
+import * as Location from "expo-location";
+import * as TaskManager from "expo-task-manager";
+import { collection, onSnapshot } from "firebase/firestore";
+import { fencesAt, setFences } from "geofence";
+import { Platform } from "react-native";
+import { getDb } from "../constants/firebaseConfig";
+import { ringExtentM, ringOf } from "./eventBoundary";
+import { RECHOOSE_M, REGION_LIMIT, chooseRegions, planList, planSlots } from "./geofenceRegions";
+import {
+  SAMPLING_BANDS,
+  createEventIndex,
+  createLocationSampler,
+  distanceM,
+} from "./locationSampling";
+
+// Watches for the user walking up to an orb. How often and how precisely
+// the phone looks is set by services/locationSampling.js from how far the
+// nearest event is, and only changes when that band does.
+//
+// By default it runs while the app is open, and the sampler works out
+// enters and exits from each fix. With `background: true` it also asks for
+// background location. If that's granted, the OS reports enters and exits
+// itself from geofences on the nearest orbs (services/geofenceRegions.js),
+// so they arrive even between fixes. That needs expo-location's
+// isIosBackgroundLocationEnabled / isAndroidBackgroundLocationEnabled in
+// app.json, which stay off until something in the app calls this with
+// background: true.
+//
+// Library only for now: no screen calls startOrbMonitoring, so none of
+// this (the bands, the geofence slots, the polygon fences) runs in the
+// app yet. Whatever ends up reacting to an enter (a prompt to scan, a
+// notification) is what should start it, with the app.json flags above
+// if it wants background: true. scripts/location-bench.mjs and
+// scripts/geofence-bench.mjs run the logic under node meanwhile.
+//
+// Events with a polygon boundary (services/eventBoundary.js) are tested
+// against their ring by the geofence module. The OS only fences circles,
+// so the sampler reports those enters and exits itself, in the background
+// too.
+
+export const ORB_LOCATION_TASK = "orb-location";
+
+// One task per geofence, so changing one doesn't restart the rest. Not on
+// iOS, where a task starting or stopping may drop every region the app
+// has (services/geofenceRegions.js): there the first task holds the whole
+// list.
+const FENCE_TASKS = Array.from({ length: REGION_LIMIT }, (_, i) => `orb-fence-${i}`);
+const ONE_TASK = Platform.OS === "ios";
+
+// Indexing a thousand events takes a quarter of a second under node and
+// longer on a phone, all on the JS thread, so a burst of moves (a business
+// dragging corners, a batch import) is built once, from the last snapshot,
+// this long after it ends
+const INDEX_REBUILD_MS = 5000;
+
+const ACCURACY = {
+  high: Location.Accuracy.High,
+  balanced: Location.Accuracy.Balanced,
+  low: Location.Accuracy.Low,
+  lowest: Location.Accuracy.Lowest,
+};
+
+let sampler = null;
+let inBackground = false;
+let watch = null; // foreground-only updates, when background was refused
+
+let handlers = null;
+let eventsById = new Map();
+let fenceIds = []; // event id of each ring given to the geofence module
+let slots = new Array(REGION_LIMIT).fill(null); // the region each fence task watches
+let listed = []; // the single task's regions, with ONE_TASK
+let chosenAt = null; // the fix regions were last chosen from
+let fencing = Promise.resolve(); // changes to the fences, one at a time
+
+function updateOptions(band) {
+  const b = SAMPLING_BANDS[band];
+  return {
+    accuracy: ACCURACY[b.accuracy],
+    timeInterval: b.timeIntervalMs,
+    distanceInterval: b.distanceIntervalM,
+    // Let iOS batch coarse fixes and pause while the user sits still
+    deferredUpdatesInterval: b.accuracy === "high" ? 0 : b.timeIntervalMs,
+    pausesUpdatesAutomatically: b.accuracy !== "high",
+    activityType: Location.ActivityType.Fitness,
+    showsBackgroundLocationIndicator: false,
+    foregroundService: {
+      notificationTitle: "LoyaltyLand",
+      notificationBody: "Watching for orbs nearby",
+    },
+  };
+}
+
+function toFix(loc) {
+  return {
+    t: loc.timestamp,
+    latitude: loc.coords.latitude,
+    longitude: loc.coords.longitude,
+    accuracy: loc.coords.accuracy,
+  };
+}
+
+// What the OS was already watching, last run's fences included
+async function loadSlots() {
+  const tasks = await TaskManager.getRegisteredTasksAsync();
+  const regionsOf = (name) => tasks.find((t) => t.taskName === name)?.options?.regions ?? [];
+  if (ONE_TASK) listed = regionsOf(FENCE_TASKS[0]);
+  else slots = FENCE_TASKS.map((name) => regionsOf(name)[0] ?? null);
+}
+
+// Chooses the nearest orbs again once the phone has moved far enough (or
+// at once, when the events changed) and makes only the calls that differ
+function refreshFences(fix, force = false) {
+  if (!inBackground || !fix) return;
+  if (!force && chosenAt) {
+    const moved = distanceM(chosenAt.latitude, chosenAt.longitude, fix.latitude, fix.longitude);
+    if (moved < RECHOOSE_M) return;
+  }
+  chosenAt = fix;
+  fencing = fencing.then(async () => {
+    const current = ONE_TASK ? listed : slots.filter(Boolean);
+    const watched = new Set(current.map((r) => r.identifier));
+    const circles = [...eventsById.values()].filter((e) => !e.ring);
+    const wanted = chooseRegions(circles, fix.latitude, fix.longitude, watched);
+    if (ONE_TASK) {
+      const list = planList(listed, wanted);
+      if (!list) return;
+      try {
+        if (list.length > 0) await Location.startGeofencingAsync(FENCE_TASKS[0], list);
+        else await Location.stopGeofencingAsync(FENCE_TASKS[0]);
+        listed = list;
+      } catch (e) {
+        console.warn("geofencing:", e);
+      }
+      return;
+    }
+    for (const { slot, region } of planSlots(slots, wanted)) {
+      try {
+        if (region) await Location.startGeofencingAsync(FENCE_TASKS[slot], [region]);
+        else await Location.stopGeofencingAsync(FENCE_TASKS[slot]);
+        slots[slot] = region;
+      } catch (e) {
+        console.warn("geofencing:", e);
+      }
+    }
+  });
+}
+
+function offerFix(fix) {
+  sampler?.offer(fix);
+  refreshFences(fix);
+}
+
+// Started again with the same task, updates pick up the new options; a
+// foreground watch has to be replaced
+async function applyBand(band) {
+  try {
+    if (inBackground) {
+      await Location.startLocationUpdatesAsync(ORB_LOCATION_TASK, updateOptions(band));
+    } else {
+      watch?.remove();
+      watch = await Location.watchPositionAsync(updateOptions(band), (loc) => offerFix(toFix(loc)));
+    }
+  } catch (e) {
+    console.warn("location updates:", e);
+  }
+}
+
+// Must be defined at module scope so a background launch finds it. A
+// launch with no sampler (the app was killed) ignores fixes until the app
+// opens and calls startOrbMonitoring again.
+TaskManager.defineTask(ORB_LOCATION_TASK, async ({ data, error }) => {
+  if (error || !sampler || !data) return;
+  for (const loc of data.locations) offerFix(toFix(loc));
+});
+
+for (const task of FENCE_TASKS) {
+  TaskManager.defineTask(task, async ({ data, error }) => {
+    if (error || !handlers || !data) return;
+    const event = eventsById.get(data.region.identifier);
+    if (!event) return;
+    if (data.eventType === Location.GeofencingEventType.Enter) handlers.onEnter?.(event);
+    else if (data.eventType === Location.GeofencingEventType.Exit) handlers.onExit?.(event);
+  });
+}
+
+// onEnter / onExit get the event. Returns a function that stops it all.
+export async function startOrbMonitoring({ onEnter, onExit, background = false } = {}) {
+  const { status } = await Location.requestForegroundPermissionsAsync();
+  if (status !== "granted") {
+    alert("Permission to access location was denied");
+    return () => {};
+  }
+  inBackground =
+    background && (await Location.requestBackgroundPermissionsAsync()).status === "granted";
+  if (inBackground) await loadSlots().catch(() => {});
+
+  handlers = { onEnter, onExit };
+  sampler = createLocationSampler({
+    index: createEventIndex([]),
+    onBand: applyBand,
+    onEnter,
+    onExit,
+    fencesAt: (latitude, longitude) => fencesAt(latitude, longitude).map((i) => fenceIds[i]),
+    // The geofences report circle events when they can
+    circleEvents: !inBackground,
+  });
+
+  function rebuild(snapshot) {
+    const events = [];
+    snapshot.forEach((doc) => {
+      const { coordinates, boundary } = doc.data();
+      if (coordinates) {
+        const { latitude, longitude } = coordinates;
+        const event = { id: doc.id, latitude, longitude };
+        const ring = ringOf(boundary);
+        if (ring) {
+          event.ring = ring;
+          event.extentM = ringExtentM(ring, latitude, longitude);
+        }
+        events.push(event);
+      }
+    });
+    const polygons = events.filter((e) => e.ring);
+    setFences(polygons.map((e) => e.ring));
+    fenceIds = polygons.map((e) => e.id);
+    sampler.setIndex(createEventIndex(events));
+    eventsById = new Map(events.map((e) => [e.id, e]));
+    refreshFences(chosenAt, true);
+  }
+
+  // The index is rebuilt whenever an event is added, moved, reshaped or
+  // removed, and not for edits that leave every event where it was. The
+  // first snapshot is built at once; later ones wait out the burst. Each
+  // snapshot holds every event, so only the last one is kept.
+  let built = false;
+  let pending = null;
+  let timer = null;
+  const unsub = onSnapshot(collection(getDb(), "events"), (snapshot) => {
+    if (timer) {
+      pending = snapshot;
+      return;
+    }
+    const moved = snapshot.docChanges().some(({ type, doc }) => {
+      if (type !== "modified") return true;
+      const before = eventsById.get(doc.id);
+      const { coordinates: after, boundary } = doc.data();
+      const ring = ringOf(boundary);
+      return (
+        before?.latitude !== after?.latitude ||
+        before?.longitude !== after?.longitude ||
+        JSON.stringify(before?.ring ?? null) !== JSON.stringify(ring)
+      );
+    });
+    if (!moved) return;
+    if (!built) {
+      built = true;
+      rebuild(snapshot);
+      return;
+    }
+    pending = snapshot;
+    timer = setTimeout(() => {
+      timer = null;
+      rebuild(pending);
+      pending = null;
+    }, INDEX_REBUILD_MS);
+  });
+
+  applyBand(sampler.band());
+
+  return () => {
+    unsub();
+    clearTimeout(timer);
+    setFences([]);
+    fenceIds = [];
+    sampler = null;
+    handlers = null;
+    watch?.remove();
+    watch = null;
+    if (inBackground) Location.stopLocationUpdatesAsync(ORB_LOCATION_TASK).catch(() => {});
+    fencing = fencing.then(async () => {
+      if (listed.length > 0) await Location.stopGeofencingAsync(FENCE_TASKS[0]).catch(() => {});
+      listed = [];
+      for (let slot = 0; slot < slots.length; slot++) {
+        if (slots[slot]) await Location.stopGeofencingAsync(FENCE_TASKS[slot]).catch(() => {});
+        slots[slot] = null;
+      }
+    });
+    chosenAt = null;
+  };
+}
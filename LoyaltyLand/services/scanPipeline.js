@@ -0,0 +1,96 @@
+// Turns the camera's barcode callbacks into scans. The camera reports a
+// code on every frame it's in view (10-30 times a second), so:
+//   - a code is accepted at most once per REPEAT_SCAN_WINDOW_MS, however
+//     often it comes back into view, so pointing the camera away and back
+//     doesn't earn again but a visit later in the day does. Pass the same
+//     `recent` map to every pipeline that should share the window (closing
+//     and reopening the scanner); forget() takes a code back out (say its
+//     write failed) so it can be scanned again
+//   - accepts are at least MIN_ACCEPT_GAP_MS apart; a code that arrives
+//     too soon isn't marked accepted, so its next frame gets it in
+// offer() is synchronous and allocation-free for repeats, so the callback
+// costs next to nothing and the scanner never has to be disarmed.
+//
+// The window keeps the camera's repeats and accidental double scans from
+// turning into extra points. It is not the limit on how often a customer
+// can earn: that lives on the app's device and is gone when the app
+// restarts, so a real limit needs enforcing where points are written.
+//
+// Points are written in the background by createPointsWriter: accepts
+// that pile up while a write is in flight go out together as one write.
+
+export const MIN_ACCEPT_GAP_MS = 400;
+export const REPEAT_SCAN_WINDOW_MS = 60 * 60 * 1000;
+export const POINTS_PER_SCAN = 10;
+
+// recent: code -> when it was accepted, oldest first. Only the last
+// window's accepts are kept.
+export function createScanPipeline({
+  onAccept,
+  now = Date.now,
+  minGapMs = MIN_ACCEPT_GAP_MS,
+  repeatWindowMs = REPEAT_SCAN_WINDOW_MS,
+  recent = new Map(),
+}) {
+  let lastAccept = -Infinity;
+
+  return {
+    offer(code) {
+      if (!code) return false;
+      const t = now();
+      const last = recent.get(code);
+      if (last !== undefined && t - last < repeatWindowMs) return false;
+      if (t - lastAccept < minGapMs) return false;
+      for (const [old, at] of recent) {
+        if (t - at < repeatWindowMs) break;
+        recent.delete(old);
+      }
+      // Re-inserted so the map stays in accept order
+      recent.delete(code);
+      recent.set(code, t);
+      lastAccept = t;
+      onAccept(code);
+      return true;
+    },
+    forget(code) {
+      recent.delete(code);
+    },
+  };
+}
+
+// write(counts) sends a Map of code -> scans and returns a promise. One
+// write is in flight at a time; onResult(codes, error) follows each one.
+// Firestore already retries while offline, so a rejected write is one that
+// won't succeed (rules, signed out) and is reported rather than retried.
+export function createPointsWriter({ write, onResult = () => {} }) {
+  let pending = new Map();
+  let inFlight = false;
+
+  const flush = async () => {
+    if (inFlight || pending.size === 0) return;
+    inFlight = true;
+    const batch = pending;
+    pending = new Map();
+    let error = null;
+    try {
+      await write(batch);
+    } catch (e) {
+      error = e;
+    }
+    inFlight = false;
+    onResult([...batch.keys()], error);
+    flush();
+  };
+
+  return {
+    add(code) {
+      pending.set(code, (pending.get(code) || 0) + 1);
+      flush();
+    },
+    pendingCount() {
+      let n = 0;
+      for (const count of pending.values()) n += count;
+      return n;
+    },
+  };
+}
@@ -1,15 +1,168 @@
+#if defined(ARDUINO_ARCH_ESP32)
+// Wi-Fi orb: dual-core build, see src/OrbDualCore.h
+#include "src/OrbDualCore.h"
+#else
+
+// 'U' firmware updates over Serial1 (src/OrbUpdate.h). Needs an Optiboot
+// bootloader with the orb's copy step, which this tree doesn't include,
+// so it's off for stock boards (Leonardo/Caterina, Mega/stk500v2). Define
+// it as 1 here or with -DORB_SERIAL_UPDATES=1 once the orb has one; until
+// then the orb answers 'X' to an update.
+#ifndef ORB_SERIAL_UPDATES
+#define ORB_SERIAL_UPDATES 0
+#endif
+
+#include "src/OrbCommands.h"
+#include "src/OrbCore.h"
+#if ORB_SERIAL_UPDATES && defined(__AVR__)
+#include "src/OrbUpdate.h"
+#endif
+
 const int redPin = 9;
 const int greenPin = 10;
 const int bluePin = 11;
 
-char currentMode = 'W'; 
+// Colour and pulse maths live in src/OrbCore.h so the app preview and the
+// host tools run exactly the same code
+OrbRenderState orb;
+// One pulse period per mode, so a tick is a table read rather than three
+// scale8s. 384 bytes keeps every other level, at most 1 off.
+OrbPeriodCache<384> pulseCache;
 unsigned long lastUpdate = 0;
-int brightness = 0;
-int fadeDirection = 1;
+bool streaming = false;
+
+// Answers '?' from host/link_monitor.cpp (src/OrbProtocol.h)
+uint16_t linkCommands = 0;
+uint16_t linkErrors = 0;
+
+void sendStatus() {
+  uint8_t reply[orbStatusLength];
+  orbStatusReply(linkCommands, linkErrors, reply);
+  Serial1.write(reply, sizeof(reply));
+}
+
+// 'H' heartbeats from host/orb_controller.cpp; a silent controller drops
+// the orb to the safe effect rather than leaving it on a stale colour
+OrbLiveness liveness;
+
+#if ORB_SERIAL_UPDATES && defined(__AVR__)
+// 'U' commands: block-diff firmware updates over Serial1 (src/OrbUpdate.h)
+AvrOrbStorage orbStorage;
+OrbUpdateReceiver<decltype(Serial1), AvrOrbStorage, SPM_PAGESIZE> orbUpdate(Serial1, orbStorage);
+#endif
+
+// Host-rendered frames (host/frame_renderer.cpp). Values are already the
+// pin levels, so while streaming the orb only displays what it's sent.
+//   'F' + count + (r g b)*count       full frame
+//   'D' + count + (index r g b)*count changed pixels only
+// Both carry their length, so a host rendering more pixels than this orb
+// has doesn't leave bytes behind to be read as commands. Pixels past
+// framePixels are read and dropped. Any colour letter goes back to the
+// local pulse.
+const int framePixels = 1;
+byte frame[framePixels][3];
+
+void readFramePacket(char kind) {
+  byte count = 0;
+  Serial1.readBytes((char *)&count, 1);
+  if (kind == 'F') {
+    for (byte i = 0; i < count; i++) {
+      byte pixel[3];
+      Serial1.readBytes((char *)pixel, 3);
+      if (i < framePixels) {
+        frame[i][0] = pixel[0];
+        frame[i][1] = pixel[1];
+        frame[i][2] = pixel[2];
+      }
+    }
+  } else {
+    for (byte i = 0; i < count; i++) {
+      byte pixel[4];
+      Serial1.readBytes((char *)pixel, 4);
+      if (pixel[0] < framePixels) {
+        frame[pixel[0]][0] = pixel[1];
+        frame[pixel[0]][1] = pixel[2];
+        frame[pixel[0]][2] = pixel[3];
+      }
+    }
+  }
+  streaming = true;
+  analogWrite(redPin,   frame[0][0]);
+  analogWrite(greenPin, frame[0][1]);
+  analogWrite(bluePin,  frame[0][2]);
+}
+
+// ---- Serial1 commands (src/OrbProtocol.h) ----
+
+// Reads the rest of a number the way parseInt() would, waiting up to its
+// 1 s timeout for each digit
+long readDigits(long value) {
+  for (;;) {
+    unsigned long start = millis();
+    while (Serial1.available() == 0 && millis() - start < 1000) {}
+    if (Serial1.available() == 0 || !isDigit(Serial1.peek())) break;
+    value = value * 10 + (Serial1.read() - '0');
+  }
+  return value;
+}
+
+// The first digit has already been read.
+// "speed" is the delay in ms between each brightness step.
+void onSpeed(char digit) {
+  orb.apply({'S', (int)readDigits(digit - '0')});
+  linkCommands++;
+}
+
+// Wave phase in pulse steps, then a group-wide 'Z' (host/wave_planner.cpp)
+void onPhase(char) {
+  orb.apply({orbPhase, (int)readDigits(0)});
+  linkCommands++;
+}
 
-// "speed" is the delay in ms between each brightness step. 
-// Smaller = Faster pulse. Larger = Slower pulse.
-int pulseSpeed = 20; 
+void onSync(char) {
+  orb.sync(millis());
+  streaming = false;
+  linkCommands++;
+}
+
+void onMode(char mode) {
+  orb.apply({'M', mode});
+  streaming = false;
+  linkCommands++;
+}
+
+void onStatus(char) {
+  sendStatus();
+}
+
+void onHeartbeat(char) {
+  liveness.beat(millis());
+  Serial1.write(orbHeartbeatReply);
+}
+
+#if ORB_SERIAL_UPDATES && defined(__AVR__)
+void onUpdate(char) {
+  orbUpdate.handle();
+}
+#endif
+
+void onSeparator(char) {}
+
+// Looked up by the byte itself, so adding a command here doesn't make
+// loop() any slower (src/OrbCommands.h)
+typedef OrbCommandTable<
+    OrbOnRange<'0', '9', onSpeed>,
+    OrbOn<'O', onMode>, OrbOn<'G', onMode>, OrbOn<'R', onMode>, OrbOn<'W', onMode>,
+    OrbOn<orbCandleMode, onMode>,
+    OrbOn<orbPhase, onPhase>, OrbOn<orbSync, onSync>,
+    OrbOn<'F', readFramePacket>, OrbOn<'D', readFramePacket>,
+#if ORB_SERIAL_UPDATES && defined(__AVR__)
+    OrbOn<'U', onUpdate>,
+#endif
+    OrbOn<orbStatusQuery, onStatus>,
+    OrbOn<orbHeartbeat, onHeartbeat>,
+    OrbOn<' ', onSeparator>, OrbOn<'\n', onSeparator>, OrbOn<'\r', onSeparator>>
+    OrbCommands;
 
 void setup() {
   Serial.begin(115200);
@@ -17,55 +170,42 @@ void setup() {
   pinMode(redPin, OUTPUT);
   pinMode(greenPin, OUTPUT);
   pinMode(bluePin, OUTPUT);
+
+  // A floating A0 picks up noise; its low bits differ from orb to orb
+  uint16_t seed = 0;
+  for (int i = 0; i < 16; i++) {
+    seed = (uint16_t)((seed << 1 | seed >> 15) ^ analogRead(A0));
+  }
+  orb.seed(seed);
 }
 
 void loop() {
   // Check Serial1 for mode or speed changes
   if (Serial1.available() > 0) {
-    if (isDigit(Serial1.peek())) {
-      // If the incoming data is a number, update the pulse speed
-      pulseSpeed = Serial1.parseInt();
-    } else {
-      // If it's a character, update the color mode
-      char incomingByte = Serial1.read();
-      if (incomingByte == 'O' || incomingByte == 'G' || 
-          incomingByte == 'R' || incomingByte == 'W') {
-        currentMode = incomingByte;
-      }
+    if (!OrbCommands::dispatch((char)Serial1.read())) {
+      linkErrors++;
     }
   }
 
-  // Define color targets (Based on Common Anode: 0 is full, 255 is off)
-  int rT, gT, bT;
-
-  switch (currentMode) {
-    case 'O': // Orange
-      rT = 0; gT = 150; bT = 255; 
-      break;
-    case 'G': // Green
-      rT = 255; gT = 0; bT = 255; 
-      break;
-    case 'R': // Red
-      rT = 0; gT = 255; bT = 255; 
-      break;
-    case 'W': // White
-    default:
-      rT = 0; gT = 0; bT = 0; 
-      break;
+  if (liveness.lapsed(millis())) {
+    orb.apply({'M', orbSafeMode});
+    orb.apply({'S', orbSafeSpeed});
+    streaming = false;
   }
 
+  // Streaming: the last frame stays on the pins until the next packet
+  if (streaming) return;
+
   // Non-blocking pulse logic
-  if (millis() - lastUpdate >= pulseSpeed) {
+  if (millis() - lastUpdate >= (unsigned long)orb.periodMs()) {
     lastUpdate = millis();
-    brightness += fadeDirection;
-    
-    if (brightness >= 255 || brightness <= 0) {
-      fadeDirection *= -1;
-    }
+    orb.setClock(lastUpdate);
+    OrbFrame pulse = orb.step(pulseCache);
 
-    // Standard GRB mapping using analogWrite
-    analogWrite(redPin,   map(brightness, 0, 255, 255, rT));
-    analogWrite(greenPin, map(brightness, 0, 255, 255, gT));
-    analogWrite(bluePin,  map(brightness, 0, 255, 255, bT));
+    analogWrite(redPin,   pulse.red);
+    analogWrite(greenPin, pulse.green);
+    analogWrite(bluePin,  pulse.blue);
   }
-}
\ No newline at end of file
+}
+
+#endif
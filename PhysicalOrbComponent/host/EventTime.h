@@ -0,0 +1,164 @@
+#pragma once
+
+// Turns CreateEvent's free-text dateString into a start/end time.
+// Understands what people actually type in that box:
+//   "Sat 2pm", "saturday 2:30pm - 5pm", "tomorrow noon to 3pm",
+//   "2pm-4pm" (today), "2026-10-18 14:00 - 16:30", "2026-10-18T14:00"
+// Without an end the event runs defaultEventHours. Times are local.
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+const int defaultEventHours = 2;
+
+struct EventWindow {
+  time_t start;
+  time_t end;
+};
+
+namespace eventtime {
+
+inline std::string lower(const std::string &s) {
+  std::string out = s;
+  for (char &c : out) c = (char)tolower((unsigned char)c);
+  return out;
+}
+
+inline void skipSpace(const char *&p) {
+  while (*p && isspace((unsigned char)*p)) p++;
+}
+
+// "2pm", "2:30 pm", "14:00", "noon", "midnight" -> minutes after midnight
+inline bool parseClock(const char *&p, int &minutes) {
+  skipSpace(p);
+  if (!strncmp(p, "noon", 4)) {
+    p += 4;
+    minutes = 12 * 60;
+    return true;
+  }
+  if (!strncmp(p, "midnight", 8)) {
+    p += 8;
+    minutes = 0;
+    return true;
+  }
+  if (!isdigit((unsigned char)*p)) return false;
+
+  char *end;
+  long hour = strtol(p, &end, 10);
+  p = end;
+  long minute = 0;
+  if (*p == ':') {
+    minute = strtol(p + 1, &end, 10);
+    p = end;
+  }
+  skipSpace(p);
+  if (!strncmp(p, "am", 2) || !strncmp(p, "pm", 2)) {
+    if (hour < 1 || hour > 12) return false;
+    bool pm = p[0] == 'p';
+    hour = hour % 12 + (pm ? 12 : 0);
+    p += 2;
+  } else if (!strncmp(p, "a", 1) || !strncmp(p, "p", 1)) {
+    // "2p" shorthand
+    if (hour < 1 || hour > 12) return false;
+    hour = hour % 12 + (p[0] == 'p' ? 12 : 0);
+    p += 1;
+  }
+  if (hour > 23 || minute > 59) return false;
+  minutes = (int)(hour * 60 + minute);
+  return true;
+}
+
+enum DayKind { NoDay, DateDay, RelativeDay, WeekdayDay };
+
+// Optional day part: ISO date, today/tomorrow or a weekday name
+inline DayKind parseDay(const char *&p, const tm &from, tm &day) {
+  skipSpace(p);
+  day = from;
+
+  int y, m, d, used = 0;
+  if (sscanf(p, "%4d-%2d-%2d%n", &y, &m, &d, &used) == 3 && used == 10) {
+    day.tm_year = y - 1900;
+    day.tm_mon = m - 1;
+    day.tm_mday = d;
+    p += used;
+    if (*p == 't') p++;
+    return DateDay;
+  }
+  if (!strncmp(p, "today", 5)) {
+    p += 5;
+    return RelativeDay;
+  }
+  if (!strncmp(p, "tomorrow", 8)) {
+    p += 8;
+    day.tm_mday += 1;
+    return RelativeDay;
+  }
+
+  static const char *names[] = {"sun", "mon", "tue", "wed", "thu", "fri", "sat"};
+  for (int w = 0; w < 7; w++) {
+    if (!strncmp(p, names[w], 3)) {
+      while (isalpha((unsigned char)*p)) p++; // "sat", "saturday"
+      day.tm_mday += (w - from.tm_wday + 7) % 7;
+      return WeekdayDay;
+    }
+  }
+  return NoDay;
+}
+
+inline time_t at(tm day, int minutes, int plusDays = 0) {
+  day.tm_mday += plusDays;
+  day.tm_hour = minutes / 60;
+  day.tm_min = minutes % 60;
+  day.tm_sec = 0;
+  day.tm_isdst = -1;
+  return mktime(&day);
+}
+
+} // namespace eventtime
+
+// now decides which "Sat" or bare "2pm" is meant: the next one that
+// hasn't already ended
+inline bool parseEventWindow(const std::string &text, time_t now, EventWindow &out) {
+  using namespace eventtime;
+  std::string s = lower(text);
+  const char *p = s.c_str();
+
+  tm today;
+  localtime_r(&now, &today);
+
+  tm day, endDay;
+  int startMinutes, endMinutes = -1;
+  DayKind kind = parseDay(p, today, day);
+  if (!parseClock(p, startMinutes)) return false;
+
+  skipSpace(p);
+  DayKind endKind = NoDay;
+  if (*p == '-' || !strncmp(p, "to", 2)) {
+    p += *p == '-' ? 1 : 2;
+    endKind = parseDay(p, day, endDay);
+    if (!parseClock(p, endMinutes)) return false;
+  }
+  skipSpace(p);
+  if (*p) return false;
+
+  // Roll a weekday forward a week, or a bare time forward a day, if that
+  // occurrence is already over
+  for (int attempt = 0; attempt < 2; attempt++) {
+    out.start = at(day, startMinutes);
+    if (endMinutes < 0) {
+      out.end = out.start + defaultEventHours * 3600;
+    } else {
+      out.end = endKind != NoDay ? at(endDay, endMinutes) : at(day, endMinutes);
+      if (out.end <= out.start) out.end = at(day, endMinutes, 1); // "10pm - 1am"
+    }
+    if (out.end > now || (kind != WeekdayDay && kind != NoDay)) break;
+    int step = kind == WeekdayDay ? 7 : 1;
+    day.tm_mday += step;
+    if (endKind != NoDay) endDay.tm_mday += step;
+  }
+  return true;
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+// One direction of a Serial1 link with the faults field links have: lost
+// bytes, flipped bits, noise bursts, latency, jitter and mismatched baud
+// rates. Runs in virtual time, and everything random comes from the seed,
+// so a run can be repeated byte for byte.
+//
+// Bytes go out back to back at the sender's baud, then wait latency plus
+// up to jitter before they arrive. A UART can't reorder, so a byte never
+// overtakes the one before it. Bursts are a two-state (Gilbert-Elliott)
+// channel: each byte may start a burst, each byte in one may end it, and
+// while it lasts bits flip at burstBitFlipRate.
+//
+// Baud mismatch is done at the bit level. The receiver syncs on each
+// start bit, then samples mid-bit at its own rate, so past a few percent
+// the later data bits and the stop bit come from the wrong place. A byte
+// with a bad stop bit still arrives, the way AVR and ESP32 UARTs hand
+// over framing errors, and is counted. Samples past the stop bit read an
+// idle line, even if the next byte's start bit is already there.
+
+#include <cstdint>
+#include <deque>
+#include <random>
+
+struct LinkFaults {
+  double lossRate = 0;        // per byte
+  double bitFlipRate = 0;     // per data bit
+  double burstStart = 0;      // per byte, chance a burst starts
+  double burstEnd = 0.1;      // per byte in a burst, chance it ends (mean length 1/burstEnd)
+  double burstBitFlipRate = 0.2;
+  int64_t latencyUs = 0;
+  int64_t jitterUs = 0;       // extra delay, uniform in [0, jitterUs]
+  int txBaud = 9600;
+  int rxBaud = 9600;
+};
+
+struct LinkByte {
+  int64_t atUs;  // when the receiver has it
+  uint8_t value;
+  uint32_t tag;  // caller's, e.g. which command the byte belonged to
+};
+
+struct LinkStats {
+  uint64_t sent = 0;
+  uint64_t lost = 0;
+  uint64_t flipped = 0;     // arrived with at least one bit changed
+  uint64_t framing = 0;     // arrived with a bad stop bit
+  uint64_t burstBytes = 0;  // sent while a burst was on
+  uint64_t bursts = 0;
+};
+
+class FaultyLink {
+public:
+  FaultyLink(const LinkFaults &faults, uint64_t seed) : faults(faults), rng(seed) {}
+
+  // 10 bits a byte: start, 8 data, stop
+  int64_t byteUs() const { return 10 * 1000000LL / faults.txBaud; }
+
+  // Writes one byte at nowUs; it goes out once the ones before it have
+  void write(uint8_t value, int64_t nowUs, uint32_t tag) {
+    stats.sent++;
+    int64_t start = nowUs > lineFreeUs ? nowUs : lineFreeUs;
+    lineFreeUs = start + byteUs();
+
+    if (burst) {
+      if (chance(faults.burstEnd)) burst = false;
+    } else if (chance(faults.burstStart)) {
+      burst = true;
+      stats.bursts++;
+    }
+    if (burst) stats.burstBytes++;
+
+    if (chance(faults.lossRate)) {
+      stats.lost++;
+      return;
+    }
+
+    uint8_t received = value;
+    double flipRate = burst ? faults.burstBitFlipRate : faults.bitFlipRate;
+    if (flipRate > 0) {
+      for (int bit = 0; bit < 8; bit++) {
+        if (chance(flipRate)) received ^= (uint8_t)(1 << bit);
+      }
+    }
+    bool framingError = false;
+    if (faults.rxBaud != faults.txBaud) received = sample(received, framingError);
+    if (received != value) stats.flipped++;
+    if (framingError) stats.framing++;
+
+    int64_t jitter = faults.jitterUs > 0 ? (int64_t)(rng() % (uint64_t)(faults.jitterUs + 1)) : 0;
+    int64_t arrive = lineFreeUs + faults.latencyUs + jitter;
+    if (arrive < lastArrivalUs) arrive = lastArrivalUs;
+    lastArrivalUs = arrive;
+    inFlight.push_back({arrive, received, tag});
+  }
+
+  // Next byte that has arrived by nowUs, oldest first
+  bool read(int64_t nowUs, LinkByte &out) {
+    if (inFlight.empty() || inFlight.front().atUs > nowUs) return false;
+    out = inFlight.front();
+    inFlight.pop_front();
+    return true;
+  }
+
+  // When the last byte written so far finishes going out
+  int64_t lineFreeAtUs() const { return lineFreeUs; }
+
+  bool inBurst() const { return burst; }
+
+  LinkStats stats;
+
+private:
+  bool chance(double p) { return p > 0 && uniform(rng) < p; }
+
+  // What a receiver at rxBaud reads from a frame sent at txBaud
+  uint8_t sample(uint8_t value, bool &framingError) const {
+    int bits[10];
+    bits[0] = 0;
+    for (int i = 0; i < 8; i++) bits[i + 1] = (value >> i) & 1;
+    bits[9] = 1;
+
+    uint8_t out = 0;
+    for (int k = 1; k <= 9; k++) {
+      // Middle of receive bit k, in transmit bit times
+      double at = (k + 0.5) * faults.txBaud / faults.rxBaud;
+      int index = (int)at;
+      int bit = index < 10 ? bits[index] : 1; // past the frame the line idles high
+      if (k <= 8) {
+        out |= (uint8_t)(bit << (k - 1));
+      } else {
+        framingError = bit == 0;
+      }
+    }
+    return out;
+  }
+
+  LinkFaults faults;
+  std::mt19937_64 rng;
+  std::uniform_real_distribution<double> uniform{0.0, 1.0};
+  std::deque<LinkByte> inFlight;
+  int64_t lineFreeUs = 0;
+  int64_t lastArrivalUs = 0;
+  bool burst = false;
+};
@@ -0,0 +1,486 @@
+#pragma once
+
+// Append-only time-series store for orb telemetry. A series is one metric
+// of one orb; samples are (ms timestamp, double).
+//
+// Samples are compressed as in Facebook's Gorilla: timestamps as the
+// delta of the delta (a steady reporting interval costs one bit), values
+// XORed with the previous one (an unchanged value costs one bit, a
+// slowly moving one a handful). Each series fills an open chunk in memory.
+// Full chunks (chunkBytes, or chunkSpanMs of time) are sealed and copied
+// into the current segment file. A segment is a fixed-size file mapped
+// MAP_SHARED, and a new one is started when it fills. Queries decode
+// straight out of the mappings.
+//
+// Open chunks are only in memory: a crash loses at most one chunk per
+// series. flush() (and the destructor) seals them.
+//
+// Queries rely on every series being in time order, chunk to chunk and
+// within a chunk, so append() refuses a sample older than the newest one
+// already in its series (sealed or open, this run or an earlier one).
+// Equal timestamps are kept.
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace telemetry {
+
+class BitWriter {
+public:
+  // Low `count` bits of value, most significant first
+  void write(uint64_t value, int count) {
+    if (count == 0) return;
+    if (count < 64) value &= (1ull << count) - 1;
+    int used = (int)(bits & 63);
+    if (used == 0) words.push_back(0);
+    int room = 64 - used;
+    if (count <= room) {
+      words.back() |= value << (room - count);
+    } else {
+      words.back() |= value >> (count - room);
+      words.push_back(value << (64 - (count - room)));
+    }
+    bits += (uint64_t)count;
+  }
+
+  void bit(bool b) { write(b ? 1 : 0, 1); }
+
+  const std::vector<uint64_t> &data() const { return words; }
+  uint64_t size() const { return bits; }
+
+  void clear() {
+    words.clear();
+    bits = 0;
+  }
+
+private:
+  std::vector<uint64_t> words;
+  uint64_t bits = 0;
+};
+
+class BitReader {
+public:
+  explicit BitReader(const uint64_t *words) : words(words) {}
+
+  uint64_t read(int count) {
+    if (count == 0) return 0;
+    size_t word = (size_t)(position >> 6);
+    int used = (int)(position & 63);
+    int room = 64 - used;
+    uint64_t value;
+    if (count <= room) {
+      value = (words[word] << used) >> (64 - count);
+    } else {
+      value = (words[word] << used) >> used << (count - room);
+      value |= words[word + 1] >> (64 - (count - room));
+    }
+    position += (uint64_t)count;
+    return value;
+  }
+
+  bool bit() { return read(1) != 0; }
+
+private:
+  const uint64_t *words;
+  uint64_t position = 0;
+};
+
+inline uint64_t valueBits(double value) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+inline double bitsValue(uint64_t bits) {
+  double value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+inline int64_t signExtend(uint64_t value, int bits) {
+  uint64_t sign = 1ull << (bits - 1);
+  return (int64_t)((value ^ sign) - sign);
+}
+
+// One chunk's worth of samples for one series
+class ChunkEncoder {
+public:
+  void append(int64_t ts, double value) {
+    uint64_t v = valueBits(value);
+    if (count == 0) {
+      bits.write((uint64_t)ts, 64);
+      bits.write(v, 64);
+      firstTs = ts;
+    } else {
+      writeTimestamp(ts);
+      writeValue(v);
+    }
+    lastTs = ts;
+    lastValue = v;
+    count++;
+  }
+
+  uint32_t size() const { return count; }
+  int64_t first() const { return firstTs; }
+  int64_t last() const { return lastTs; }
+  const BitWriter &data() const { return bits; }
+
+  void clear() {
+    bits.clear();
+    count = 0;
+    lastDelta = 0;
+    leading = 65; // no previous window
+    trailing = 0;
+  }
+
+private:
+  // 0, or a bucket prefix and the delta-of-delta in as few bits as fit
+  void writeTimestamp(int64_t ts) {
+    int64_t delta = ts - lastTs;
+    int64_t dod = delta - lastDelta;
+    lastDelta = delta;
+    if (dod == 0) {
+      bits.bit(false);
+    } else if (dod >= -64 && dod <= 63) {
+      bits.write(0b10, 2);
+      bits.write((uint64_t)dod, 7);
+    } else if (dod >= -256 && dod <= 255) {
+      bits.write(0b110, 3);
+      bits.write((uint64_t)dod, 9);
+    } else if (dod >= -2048 && dod <= 2047) {
+      bits.write(0b1110, 4);
+      bits.write((uint64_t)dod, 12);
+    } else if (dod >= INT32_MIN && dod <= INT32_MAX) {
+      bits.write(0b11110, 5);
+      bits.write((uint64_t)dod, 32);
+    } else {
+      bits.write(0b11111, 5);
+      bits.write((uint64_t)dod, 64);
+    }
+  }
+
+  // 0 if unchanged; 10 + the meaningful bits if they fit the previous
+  // window; 11 + leading zeros, length and the bits otherwise
+  void writeValue(uint64_t v) {
+    uint64_t x = v ^ lastValue;
+    if (x == 0) {
+      bits.bit(false);
+      return;
+    }
+    int lead = std::min(__builtin_clzll(x), 31);
+    int trail = __builtin_ctzll(x);
+    if (leading <= 64 && lead >= leading && trail >= trailing) {
+      bits.write(0b10, 2);
+      bits.write(x >> trailing, 64 - leading - trailing);
+    } else {
+      int length = 64 - lead - trail;
+      bits.write(0b11, 2);
+      bits.write((uint64_t)lead, 5);
+      bits.write((uint64_t)(length & 63), 6); // 64 is stored as 0
+      bits.write(x >> trail, length);
+      leading = lead;
+      trailing = trail;
+    }
+  }
+
+  BitWriter bits;
+  uint32_t count = 0;
+  int64_t firstTs = 0;
+  int64_t lastTs = 0;
+  int64_t lastDelta = 0;
+  uint64_t lastValue = 0;
+  int leading = 65;
+  int trailing = 0;
+};
+
+// Calls fn(ts, value) for every sample of an encoded chunk in [from, to]
+template <typename Fn>
+inline void decodeChunk(const uint64_t *words, uint32_t count, int64_t from, int64_t to, Fn fn) {
+  BitReader in(words);
+  int64_t ts = (int64_t)in.read(64);
+  uint64_t value = in.read(64);
+  int64_t delta = 0;
+  int leading = 0, trailing = 0;
+  for (uint32_t i = 0;; i++) {
+    if (ts > to) return;
+    if (ts >= from) fn(ts, bitsValue(value));
+    if (i + 1 == count) return;
+
+    int64_t dod;
+    if (!in.bit()) {
+      dod = 0;
+    } else if (!in.bit()) {
+      dod = signExtend(in.read(7), 7);
+    } else if (!in.bit()) {
+      dod = signExtend(in.read(9), 9);
+    } else if (!in.bit()) {
+      dod = signExtend(in.read(12), 12);
+    } else if (!in.bit()) {
+      dod = signExtend(in.read(32), 32);
+    } else {
+      dod = (int64_t)in.read(64);
+    }
+    delta += dod;
+    ts += delta;
+
+    if (in.bit()) {
+      if (in.bit()) {
+        leading = (int)in.read(5);
+        int length = (int)in.read(6);
+        if (length == 0) length = 64;
+        trailing = 64 - leading - length;
+      }
+      value ^= in.read(64 - leading - trailing) << trailing;
+    }
+  }
+}
+
+} // namespace telemetry
+
+class TelemetryStore {
+public:
+  static const size_t segmentBytes = 64 << 20;
+  static const size_t chunkBytes = 1024;               // payload before a chunk is sealed
+  static const int64_t chunkSpanMs = 24 * 3600 * 1000; // or a day of samples, if sooner
+
+  typedef uint32_t SeriesId;
+
+  // Opens (or creates) the store in dir, indexing any existing segments
+  explicit TelemetryStore(const std::string &dir) : dir(dir) {
+    std::vector<std::string> names;
+    if (DIR *d = opendir(dir.c_str())) {
+      while (dirent *entry = readdir(d)) {
+        std::string name = entry->d_name;
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".ots") == 0) {
+          names.push_back(name);
+        }
+      }
+      closedir(d);
+    }
+    std::sort(names.begin(), names.end());
+    for (const std::string &name : names) {
+      if (!mapSegment(dir + "/" + name, false)) return;
+      indexSegment((uint32_t)(segments.size() - 1));
+    }
+  }
+
+  ~TelemetryStore() {
+    flush();
+    for (Segment &s : segments) {
+      munmap(s.base, segmentBytes);
+      close(s.fd);
+    }
+  }
+
+  bool ok() const { return !failed; }
+
+  SeriesId series(uint32_t orbId, uint8_t metric) {
+    uint64_t key = seriesKey(orbId, metric);
+    auto it = byKey.find(key);
+    if (it != byKey.end()) return it->second;
+    SeriesId id = (SeriesId)all.size();
+    all.emplace_back();
+    all.back().orbId = orbId;
+    all.back().metric = metric;
+    byKey[key] = id;
+    return id;
+  }
+
+  // False (and nothing stored) if ts is older than the series' newest sample
+  bool append(SeriesId id, int64_t ts, double value) {
+    Series &s = all[id];
+    if (ts < s.lastTs) return false;
+    s.lastTs = ts;
+    s.open.append(ts, value);
+    if (s.open.data().size() >= chunkBytes * 8 || ts - s.open.first() >= chunkSpanMs) seal(id);
+    return true;
+  }
+
+  bool append(uint32_t orbId, uint8_t metric, int64_t ts, double value) {
+    return append(series(orbId, metric), ts, value);
+  }
+
+  void flush() {
+    for (SeriesId id = 0; id < all.size(); id++) {
+      if (all[id].open.size() > 0) seal(id);
+    }
+  }
+
+  // fn(ts, value) for every sample in [from, to], oldest first
+  template <typename Fn>
+  void query(SeriesId id, int64_t from, int64_t to, Fn fn) const {
+    const Series &s = all[id];
+    for (const ChunkRef &ref : s.chunks) {
+      if (ref.lastTs < from) continue;
+      if (ref.firstTs > to) break;
+      const ChunkHeader *h = header(ref);
+      telemetry::decodeChunk((const uint64_t *)(h + 1), h->count, from, to, fn);
+    }
+    if (s.open.size() > 0 && s.open.last() >= from && s.open.first() <= to) {
+      telemetry::decodeChunk(s.open.data().data().data(), s.open.size(), from, to, fn);
+    }
+  }
+
+  template <typename Fn>
+  bool query(uint32_t orbId, uint8_t metric, int64_t from, int64_t to, Fn fn) const {
+    auto it = byKey.find(seriesKey(orbId, metric));
+    if (it == byKey.end()) return false;
+    query(it->second, from, to, fn);
+    return true;
+  }
+
+  size_t seriesCount() const { return all.size(); }
+  uint32_t orbOf(SeriesId id) const { return all[id].orbId; }
+  uint8_t metricOf(SeriesId id) const { return all[id].metric; }
+
+  // Sealed bytes (headers included) and samples of one series
+  void usage(SeriesId id, uint64_t &bytes, uint64_t &samples) const {
+    bytes = samples = 0;
+    for (const ChunkRef &ref : all[id].chunks) {
+      const ChunkHeader *h = header(ref);
+      bytes += sizeof(ChunkHeader) + h->words * 8ull;
+      samples += h->count;
+    }
+  }
+
+  uint64_t diskBytes() const {
+    uint64_t total = 0;
+    for (const Segment &s : segments) total += ((const SegmentHeader *)s.base)->used;
+    return total;
+  }
+
+private:
+  struct SegmentHeader {
+    char magic[8];
+    uint64_t used; // bytes of the file written, this header included
+  };
+
+  struct ChunkHeader {
+    uint32_t orbId;
+    uint8_t metric;
+    uint8_t reserved[3];
+    uint32_t count;
+    uint32_t words; // payload size in 64-bit words
+    int64_t firstTs;
+    int64_t lastTs;
+  };
+
+  struct ChunkRef {
+    uint32_t segment;
+    uint32_t offset;
+    int64_t firstTs;
+    int64_t lastTs;
+  };
+
+  struct Series {
+    uint32_t orbId;
+    uint8_t metric;
+    int64_t lastTs = INT64_MIN; // newest sample, sealed or open
+    telemetry::ChunkEncoder open;
+    std::vector<ChunkRef> chunks;
+  };
+
+  struct Segment {
+    int fd;
+    char *base;
+  };
+
+  static uint64_t seriesKey(uint32_t orbId, uint8_t metric) {
+    return (uint64_t)orbId << 8 | metric;
+  }
+
+  const ChunkHeader *header(const ChunkRef &ref) const {
+    return (const ChunkHeader *)(segments[ref.segment].base + ref.offset);
+  }
+
+  bool mapSegment(const std::string &path, bool create) {
+    int fd = ::open(path.c_str(), O_RDWR | (create ? O_CREAT | O_EXCL : 0), 0644);
+    if (fd < 0 || (create && ftruncate(fd, (off_t)segmentBytes) < 0)) {
+      perror(path.c_str());
+      if (fd >= 0) close(fd);
+      failed = true;
+      return false;
+    }
+    void *base = mmap(nullptr, segmentBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+      perror(path.c_str());
+      close(fd);
+      failed = true;
+      return false;
+    }
+    SegmentHeader *h = (SegmentHeader *)base;
+    if (create) {
+      memcpy(h->magic, "ORBTS1\0", 8);
+      h->used = sizeof(SegmentHeader);
+    } else if (memcmp(h->magic, "ORBTS1\0", 8) != 0 || h->used > segmentBytes) {
+      fprintf(stderr, "%s: not a telemetry segment\n", path.c_str());
+      munmap(base, segmentBytes);
+      close(fd);
+      failed = true;
+      return false;
+    }
+    segments.push_back(Segment{fd, (char *)base});
+    return true;
+  }
+
+  void indexSegment(uint32_t index) {
+    const char *base = segments[index].base;
+    uint64_t used = ((const SegmentHeader *)base)->used;
+    for (uint64_t offset = sizeof(SegmentHeader); offset < used;) {
+      const ChunkHeader *h = (const ChunkHeader *)(base + offset);
+      SeriesId id = series(h->orbId, h->metric);
+      all[id].chunks.push_back(ChunkRef{index, (uint32_t)offset, h->firstTs, h->lastTs});
+      all[id].lastTs = std::max(all[id].lastTs, h->lastTs);
+      offset += sizeof(ChunkHeader) + h->words * 8ull;
+    }
+  }
+
+  // Copies the open chunk into the current segment and starts a new one
+  void seal(SeriesId id) {
+    Series &s = all[id];
+    const std::vector<uint64_t> &words = s.open.data().data();
+    size_t bytes = sizeof(ChunkHeader) + words.size() * 8;
+    SegmentHeader *seg = segments.empty() ? nullptr : (SegmentHeader *)segments.back().base;
+    if (!seg || seg->used + bytes > segmentBytes) {
+      char name[32];
+      snprintf(name, sizeof(name), "/%06zu.ots", segments.size());
+      if (failed || !mapSegment(dir + name, true)) {
+        s.open.clear(); // nowhere to put it
+        return;
+      }
+      seg = (SegmentHeader *)segments.back().base;
+    }
+
+    uint32_t offset = (uint32_t)seg->used;
+    ChunkHeader h = {};
+    h.orbId = s.orbId;
+    h.metric = s.metric;
+    h.count = s.open.size();
+    h.words = (uint32_t)words.size();
+    h.firstTs = s.open.first();
+    h.lastTs = s.open.last();
+    char *at = segments.back().base + offset;
+    memcpy(at, &h, sizeof(h));
+    memcpy(at + sizeof(h), words.data(), words.size() * 8);
+    seg->used += bytes; // after the chunk, so a crash mid-copy leaves it unwritten
+
+    s.chunks.push_back(ChunkRef{(uint32_t)(segments.size() - 1), offset, h.firstTs, h.lastTs});
+    s.open.clear();
+  }
+
+  std::string dir;
+  std::vector<Segment> segments;
+  std::vector<Series> all;
+  std::unordered_map<uint64_t, SeriesId> byKey;
+  bool failed = false;
+};
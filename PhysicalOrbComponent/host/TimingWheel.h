@@ -0,0 +1,187 @@
+#pragma once
+
+// Hierarchical timing wheel for scheduled orb actions. Four levels of 256
+// slots cover 2^32 ticks (49 days at 1 ms); anything further out waits in
+// an overflow list. Insert and cancel are O(1): entries live in one pool
+// and sit on intrusive doubly-linked slot lists. Entries cascade down a
+// level each time the level below wraps, so each one moves at most four
+// times before it fires.
+//
+// Entries due on the same tick fire in the order they were scheduled. A
+// slot list is kept in that order: a new entry goes on the tail, and one
+// cascading down goes in front of any scheduled later, which were placed
+// straight into the lower level.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+template <typename Payload>
+class TimingWheel {
+public:
+  struct Handle {
+    uint32_t index;
+    uint32_t generation;
+  };
+
+  explicit TimingWheel(uint64_t startTick = 0) : now(startTick) {
+    for (uint32_t &head : heads) head = nil;
+    for (uint32_t &tail : tails) tail = nil;
+  }
+
+  void reserve(size_t count) { pool.reserve(count); }
+
+  uint64_t currentTick() const { return now; }
+  size_t size() const { return live; }
+
+  // Pool plus slot lists, i.e. what the wheel itself costs
+  size_t memoryBytes() const {
+    return pool.capacity() * sizeof(Entry) + sizeof(heads) + sizeof(tails);
+  }
+
+  // Ticks already passed fire on the next advance()
+  Handle schedule(uint64_t tick, const Payload &payload) {
+    uint32_t index;
+    if (freeHead != nil) {
+      index = freeHead;
+      freeHead = pool[index].next;
+    } else {
+      index = (uint32_t)pool.size();
+      pool.push_back(Entry());
+    }
+    Entry &e = pool[index];
+    e.tick = tick < now ? now : tick;
+    e.sequence = nextSequence++;
+    e.payload = payload;
+    place(index);
+    live++;
+    return Handle{index, e.generation};
+  }
+
+  bool cancel(Handle handle) {
+    if (handle.index >= pool.size()) return false;
+    Entry &e = pool[handle.index];
+    if (e.list == nil || e.generation != handle.generation) return false;
+    unlink(handle.index);
+    release(handle.index);
+    return true;
+  }
+
+  // Fires everything due up to and including tick, in tick order and then
+  // the order it was scheduled, by appending it to due. The caller sends
+  // that as one batch.
+  void advance(uint64_t tick, std::vector<Payload> &due) {
+    while (now <= tick) {
+      uint32_t list = now & slotMask;
+      uint32_t index = heads[list];
+      heads[list] = tails[list] = nil;
+      while (index != nil) {
+        uint32_t next = pool[index].next;
+        due.push_back(pool[index].payload);
+        release(index);
+        index = next;
+      }
+
+      now++;
+      if ((now & slotMask) == 0) cascade();
+    }
+  }
+
+private:
+  static const int slotBits = 8;
+  static const uint32_t slotCount = 1u << slotBits;
+  static const uint32_t slotMask = slotCount - 1;
+  static const int levels = 4;
+  static const uint32_t overflowList = levels * slotCount;
+  static const uint32_t nil = UINT32_MAX;
+
+  struct Entry {
+    uint64_t tick = 0;
+    uint64_t sequence = 0; // schedule() order
+    uint32_t next = nil;
+    uint32_t prev = nil;
+    uint32_t generation = 0;
+    uint32_t list = nil; // nil while on the free list
+    Payload payload;
+  };
+
+  void place(uint32_t index) {
+    Entry &e = pool[index];
+    uint64_t delta = e.tick - now;
+    uint32_t list = overflowList;
+    for (int level = 0; level < levels; level++) {
+      if (delta < (1ull << (slotBits * (level + 1)))) {
+        list = level * slotCount + (uint32_t)((e.tick >> (slotBits * level)) & slotMask);
+        break;
+      }
+    }
+    e.list = list;
+    // Almost always the tail; a cascading entry steps back past the few
+    // scheduled after it
+    uint32_t after = tails[list];
+    while (after != nil && pool[after].sequence > e.sequence) after = pool[after].prev;
+    e.prev = after;
+    e.next = after != nil ? pool[after].next : heads[list];
+    if (e.next != nil) {
+      pool[e.next].prev = index;
+    } else {
+      tails[list] = index;
+    }
+    if (after != nil) {
+      pool[after].next = index;
+    } else {
+      heads[list] = index;
+    }
+  }
+
+  void unlink(uint32_t index) {
+    Entry &e = pool[index];
+    if (e.prev != nil) {
+      pool[e.prev].next = e.next;
+    } else {
+      heads[e.list] = e.next;
+    }
+    if (e.next != nil) {
+      pool[e.next].prev = e.prev;
+    } else {
+      tails[e.list] = e.prev;
+    }
+  }
+
+  void release(uint32_t index) {
+    Entry &e = pool[index];
+    e.list = nil;
+    e.generation++;
+    e.next = freeHead;
+    freeHead = index;
+    live--;
+  }
+
+  // Re-place one slot's entries now that they are closer
+  void replaceList(uint32_t list) {
+    uint32_t index = heads[list];
+    heads[list] = tails[list] = nil;
+    while (index != nil) {
+      uint32_t next = pool[index].next;
+      place(index);
+      index = next;
+    }
+  }
+
+  void cascade() {
+    for (int level = 1; level < levels; level++) {
+      uint32_t slot = (uint32_t)((now >> (slotBits * level)) & slotMask);
+      replaceList(level * slotCount + slot);
+      if (slot != 0) return;
+    }
+    replaceList(overflowList);
+  }
+
+  std::vector<Entry> pool;
+  uint32_t heads[levels * slotCount + 1];
+  uint32_t tails[levels * slotCount + 1];
+  uint32_t freeHead = nil;
+  uint64_t nextSequence = 0;
+  size_t live = 0;
+  uint64_t now;
+};
@@ -0,0 +1,255 @@
+// The candle effect (OrbCandle, src/OrbNoise.h): what a sample costs, and
+// how its flicker compares with a recorded flame.
+//
+//   g++ -std=c++11 -O2 candle_noise_sim.cpp -o candle_noise_sim
+//   ./candle_noise_sim [--seconds N] [--speed MS] [--trace FILE --rate HZ]
+//
+// A trace is one light reading per line (photodiode, camera patch, ...),
+// sampled at --rate; only the first number on a line is used and lines
+// starting with # are skipped. Both signals are scaled so their brightest
+// sample is 1, since a sensor's gain is arbitrary, then compared on:
+//   level      mean and spread, relative to the peak
+//   spectrum   where the flicker's power sits, in Hz, so the orb's tick
+//              rate and the trace's sample rate don't need to match
+//   dips       how often it falls more than two deviations below its mean
+// --speed is the pulse speed in ms per tick (the orb's default is 20).
+// Seed-to-seed correlation checks that orbs side by side stay apart.
+//
+// Cycles are the host's TSC (x86 only). On AVR a candle tick is three
+// octaves of four hashes and three lerps each; none of it divides.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <x86intrin.h>
+
+#include "../src/OrbCore.h"
+
+struct FlickerStats {
+  double mean, deviation;
+  double band[4]; // share of flicker power below 2 Hz, 2-8, 8-15, above 15
+  double centroidHz;
+  double dipsPerSecond;
+};
+
+static const double bandEdges[] = {2, 8, 15};
+
+// Mean and spread on the peak-scaled signal; spectrum from 256-sample
+// Hann windows, half overlapped, with the mean taken out
+static FlickerStats measure(const std::vector<double> &raw, double rateHz) {
+  FlickerStats s = {};
+  double peak = *std::max_element(raw.begin(), raw.end());
+  std::vector<double> v(raw.size());
+  for (size_t i = 0; i < raw.size(); i++) v[i] = peak > 0 ? raw[i] / peak : 0;
+
+  for (double x : v) s.mean += x;
+  s.mean /= v.size();
+  for (double x : v) s.deviation += (x - s.mean) * (x - s.mean);
+  s.deviation = std::sqrt(s.deviation / v.size());
+
+  const size_t n = 256;
+  std::vector<double> power(n / 2 + 1, 0.0);
+  for (size_t start = 0; start + n <= v.size(); start += n / 2) {
+    for (size_t k = 1; k <= n / 2; k++) {
+      double re = 0, im = 0;
+      for (size_t i = 0; i < n; i++) {
+        double w = 0.5 - 0.5 * std::cos(2 * M_PI * i / (n - 1));
+        double x = (v[start + i] - s.mean) * w;
+        re += x * std::cos(2 * M_PI * k * i / n);
+        im -= x * std::sin(2 * M_PI * k * i / n);
+      }
+      power[k] += re * re + im * im;
+    }
+  }
+  double total = 0, weighted = 0;
+  for (size_t k = 1; k <= n / 2; k++) {
+    double hz = k * rateHz / n;
+    int b = hz < bandEdges[0] ? 0 : hz < bandEdges[1] ? 1 : hz < bandEdges[2] ? 2 : 3;
+    s.band[b] += power[k];
+    total += power[k];
+    weighted += power[k] * hz;
+  }
+  if (total > 0) {
+    for (double &b : s.band) b /= total;
+    s.centroidHz = weighted / total;
+  }
+
+  double threshold = s.mean - 2 * s.deviation;
+  int dips = 0;
+  bool below = false;
+  for (double x : v) {
+    if (!below && x < threshold) dips++;
+    below = x < threshold;
+  }
+  s.dipsPerSecond = dips / (v.size() / rateHz);
+  return s;
+}
+
+static void printStats(const char *label, const FlickerStats &s) {
+  std::printf("  %-10s mean %.2f  dev %.3f  <2Hz %3.0f%%  2-8 %3.0f%%  8-15 %3.0f%%  >15 %3.0f%%"
+              "  centroid %4.1f Hz  dips %.2f/s\n",
+              label, s.mean, s.deviation, 100 * s.band[0], 100 * s.band[1], 100 * s.band[2],
+              100 * s.band[3], s.centroidHz, s.dipsPerSecond);
+}
+
+static std::vector<double> candleSamples(uint16_t seed, size_t count) {
+  OrbRenderState orb;
+  orb.seed(seed);
+  orb.apply({'M', orbCandleMode});
+  std::vector<double> out(count);
+  for (size_t i = 0; i < count; i++) out[i] = orb.step().brightness;
+  return out;
+}
+
+static std::vector<double> pulseSamples(size_t count) {
+  OrbRenderState orb;
+  std::vector<double> out(count);
+  for (size_t i = 0; i < count; i++) out[i] = orb.step().brightness;
+  return out;
+}
+
+static double correlation(const std::vector<double> &a, const std::vector<double> &b) {
+  double ma = 0, mb = 0;
+  for (size_t i = 0; i < a.size(); i++) {
+    ma += a[i];
+    mb += b[i];
+  }
+  ma /= a.size();
+  mb /= b.size();
+  double ab = 0, aa = 0, bb = 0;
+  for (size_t i = 0; i < a.size(); i++) {
+    ab += (a[i] - ma) * (b[i] - mb);
+    aa += (a[i] - ma) * (a[i] - ma);
+    bb += (b[i] - mb) * (b[i] - mb);
+  }
+  return ab / std::sqrt(aa * bb);
+}
+
+static bool readTrace(const char *path, std::vector<double> &out) {
+  FILE *f = std::fopen(path, "r");
+  if (!f) return false;
+  char line[256];
+  while (std::fgets(line, sizeof(line), f)) {
+    if (line[0] == '#') continue;
+    char *end = nullptr;
+    double v = std::strtod(line, &end);
+    if (end != line) out.push_back(v);
+  }
+  std::fclose(f);
+  return true;
+}
+
+static volatile unsigned sink;
+
+template <typename Body>
+static double cyclesPer(unsigned count, Body body) {
+  double best = 1e18;
+  for (int round = 0; round < 10; round++) {
+    unsigned long long start = __rdtsc();
+    body();
+    best = std::min(best, double(__rdtsc() - start) / count);
+  }
+  return best;
+}
+
+int main(int argc, char **argv) {
+  double seconds = 600;
+  int speed = 20;
+  const char *tracePath = nullptr;
+  double traceRate = 0;
+  for (int i = 1; i < argc; i++) {
+    if (!std::strcmp(argv[i], "--seconds") && i + 1 < argc) {
+      seconds = std::atof(argv[++i]);
+    } else if (!std::strcmp(argv[i], "--speed") && i + 1 < argc) {
+      speed = std::max(1, std::atoi(argv[++i]));
+    } else if (!std::strcmp(argv[i], "--trace") && i + 1 < argc) {
+      tracePath = argv[++i];
+    } else if (!std::strcmp(argv[i], "--rate") && i + 1 < argc) {
+      traceRate = std::atof(argv[++i]);
+    } else {
+      std::fprintf(stderr,
+                   "usage: %s [--seconds N] [--speed MS] [--trace FILE --rate HZ]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (tracePath && traceRate <= 0) {
+    std::fprintf(stderr, "--trace needs --rate\n");
+    return 1;
+  }
+
+  // ---- Cost ----
+  const unsigned samples = 1 << 16;
+  OrbNoise noise(1234);
+  double at1 = cyclesPer(samples, [&] {
+    unsigned acc = 0;
+    for (unsigned i = 0; i < samples; i++) acc += noise.at((uint16_t)(i * 37));
+    sink = acc;
+  });
+  double at2 = cyclesPer(samples, [&] {
+    unsigned acc = 0;
+    for (unsigned i = 0; i < samples; i++) {
+      acc += noise.at((uint16_t)(i * 37), (uint16_t)(i * 11));
+    }
+    sink = acc;
+  });
+  double fractal1 = cyclesPer(samples, [&] {
+    unsigned acc = 0;
+    for (unsigned i = 0; i < samples; i++) acc += noise.fractal((uint16_t)(i * 37), 3);
+    sink = acc;
+  });
+  OrbCandle candle;
+  candle.reseed(1234);
+  double tick = cyclesPer(samples, [&] {
+    unsigned acc = 0;
+    for (unsigned i = 0; i < samples; i++) acc += candle.next();
+    sink = acc;
+  });
+  std::printf("host cycles per sample:\n");
+  std::printf("  1D %.1f   2D %.1f   1D x3 octaves %.1f   candle tick (2D x3) %.1f\n", at1, at2,
+              fractal1, tick);
+
+  // ---- Lattice points next to each other are unrelated ----
+  std::vector<double> here, right, below;
+  for (unsigned x = 0; x < 256; x++) {
+    for (unsigned y = 0; y < 256; y++) {
+      here.push_back(noise.at((uint16_t)(x << 8), (uint16_t)(y << 8)));
+      right.push_back(noise.at((uint16_t)((x + 1) << 8), (uint16_t)(y << 8)));
+      below.push_back(noise.at((uint16_t)(x << 8), (uint16_t)((y + 1) << 8)));
+    }
+  }
+  std::printf("lattice neighbours: correlation %.3f along x, %.3f along y\n",
+              correlation(here, right), correlation(here, below));
+
+  // ---- Flicker ----
+  double rateHz = 1000.0 / speed;
+  size_t count = (size_t)(seconds * rateHz);
+  if (count < 512) count = 512;
+  std::vector<double> flame = candleSamples(1, count);
+  std::printf("\nflicker at %d ms per tick (%.0f Hz), %zu samples:\n", speed, rateHz, count);
+  printStats("candle", measure(flame, rateHz));
+  printStats("pulse", measure(pulseSamples(count), rateHz));
+
+  double worst = 0;
+  for (uint16_t seed = 1; seed < 16; seed++) {
+    double r = correlation(candleSamples(seed, count), candleSamples((uint16_t)(seed + 1), count));
+    worst = std::max(worst, std::fabs(r));
+  }
+  std::printf("  neighbouring seeds 1..16: largest |correlation| %.3f\n", worst);
+
+  if (!tracePath) {
+    std::printf("\nno --trace given; pass a recorded flame to compare against\n");
+    return 0;
+  }
+  std::vector<double> trace;
+  if (!readTrace(tracePath, trace) || trace.size() < 256) {
+    std::fprintf(stderr, "%s: need at least 256 samples\n", tracePath);
+    return 1;
+  }
+  std::printf("\n%s: %zu samples at %.0f Hz\n", tracePath, trace.size(), traceRate);
+  printStats("recorded", measure(trace, traceRate));
+  printStats("candle", measure(flame, rateHz));
+  return 0;
+}
@@ -0,0 +1,106 @@
+// Cycles per command for the loop() dispatch: the if/else chain it used
+// to be against OrbCommandTable (src/OrbCommands.h), with 4 and with 64
+// commands declared.
+//
+//   g++ -std=c++17 -O2 command_dispatch_bench.cpp -o command_dispatch_bench
+//   ./command_dispatch_bench [--commands N]
+//
+// Cycles are the host's TSC (x86 only), averaged over N commands drawn
+// evenly from the declared set, and again for the byte the chain checks
+// last. On AVR the table path is the same shape: subtract, compare, two
+// LPM reads of the slot and an ICALL, whatever the table holds.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include <x86intrin.h>
+
+#include "../src/OrbCommands.h"
+
+static unsigned hits[256];
+
+template <int Key>
+static void hit(char) {
+  hits[Key]++;
+}
+
+// Keeps host gcc from turning the chain back into a jump table, which
+// the Arduino toolchain's avr-gcc 7 doesn't do for an if/else chain
+static inline bool no() {
+  asm volatile("");
+  return false;
+}
+
+// The old shape: one comparison per command until one matches
+template <int... Keys>
+struct Chain {
+  __attribute__((noinline)) static bool dispatch(char c) {
+    return ((c == (char)Keys ? (hit<Keys>(c), true) : no()) || ...);
+  }
+};
+
+template <int First, typename Seq>
+struct Build;
+
+template <int First, int... I>
+struct Build<First, std::integer_sequence<int, I...>> {
+  typedef Chain<(First + I)...> chain;
+  typedef OrbCommandTable<OrbOn<(char)(First + I), hit<First + I>>...> table;
+};
+
+template <typename Dispatch>
+__attribute__((noinline)) static double cyclesPer(Dispatch dispatch,
+                                                  const std::vector<char> &input) {
+  unsigned long long start = __rdtsc();
+  for (char c : input) dispatch(c);
+  return double(__rdtsc() - start) / input.size();
+}
+
+template <int Count>
+static void run(size_t commands) {
+  const int first = '0';
+  typedef Build<first, std::make_integer_sequence<int, Count>> B;
+
+  std::vector<char> even(commands), last(commands, (char)(first + Count - 1));
+  unsigned seed = 12345;
+  for (char &c : even) {
+    seed = seed * 1103515245u + 12345u;
+    c = (char)(first + (seed >> 16) % Count);
+  }
+
+  // Warm up, then keep the best of a few runs
+  double chainEven = 1e9, chainLast = 1e9, tableEven = 1e9, tableLast = 1e9;
+  for (int round = 0; round < 5; round++) {
+    chainEven = std::min(chainEven, cyclesPer(B::chain::dispatch, even));
+    chainLast = std::min(chainLast, cyclesPer(B::chain::dispatch, last));
+    tableEven = std::min(tableEven, cyclesPer(B::table::dispatch, even));
+    tableLast = std::min(tableLast, cyclesPer(B::table::dispatch, last));
+  }
+
+  unsigned total = 0;
+  for (unsigned h : hits) total += h;
+  std::printf("%2d commands  chain %5.1f cycles (last %5.1f)  table %5.1f cycles (last %5.1f)"
+              "  table %u slots, %zu bytes  [%u handled]\n",
+              Count, chainEven, chainLast, tableEven, tableLast, B::table::size,
+              B::table::size * sizeof(OrbCommandHandler), total);
+  std::memset(hits, 0, sizeof(hits));
+}
+
+int main(int argc, char **argv) {
+  size_t commands = 1000000;
+  for (int i = 1; i < argc; i++) {
+    if (!std::strcmp(argv[i], "--commands") && i + 1 < argc) {
+      commands = std::strtoul(argv[++i], nullptr, 10);
+    } else {
+      std::fprintf(stderr, "usage: %s [--commands N]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (commands == 0) commands = 1;
+
+  run<4>(commands);
+  run<64>(commands);
+  return 0;
+}
@@ -0,0 +1,230 @@
+// Host build of the ESP32 dual-core orb (src/OrbDualCore.h).
+// The render core and the comms core become two threads running the
+// header's own OrbRenderCore::tick and OrbCommsCore::poll. The comms
+// thread fakes radio stalls and the render thread records how late each
+// tick is. MQTT payloads go through the same DoubleBuffer as on the orb.
+//
+//   g++ -std=c++17 -O2 -pthread dual_core_sim.cpp -o dual_core_sim
+//   ./dual_core_sim [--single] [--seconds N] [--period MS] [--stall MS]
+//
+// --single runs comms and render in one loop like the AVR sketch does,
+// which is the "before" number. Afterwards a writer and a reader hammer a
+// DoubleBuffer for a second and count torn copies, which must be 0.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/OrbDualCore.h"
+
+using Clock = std::chrono::steady_clock;
+
+struct SimOptions {
+  bool single = false;
+  int seconds = 5;
+  int periodMs = 20;
+  int stallMs = 30; // worst radio stall
+};
+
+static OrbCommandQueue orbCommands;
+static DoubleBuffer<OrbTarget> mqttTarget;
+static std::atomic<bool> running{true};
+static const Clock::time_point started = Clock::now();
+
+static unsigned long millis() {
+  return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() -
+                                                                              started)
+      .count();
+}
+
+// Busy wait, a stalled radio driver holds the core rather than sleeping
+static void stall(int ms) {
+  Clock::time_point until = Clock::now() + std::chrono::milliseconds(ms);
+  while (Clock::now() < until) {
+  }
+}
+
+// Stands in for Serial1: hands out a byte of the script per poll and
+// swallows replies
+struct SimLink {
+  std::string script;
+  size_t pos = 0;
+  bool ready = false;
+
+  int available() const { return ready ? 1 : 0; }
+  int read() {
+    ready = false;
+    return (unsigned char)script[pos++ % script.size()];
+  }
+  size_t write(uint8_t) { return 1; }
+  size_t write(const uint8_t *, size_t n) { return n; }
+};
+
+// One pass of the comms side: maybe a stall, a byte of Serial1, and now
+// and then an MQTT message
+static void commsStep(std::mt19937 &rng, const SimOptions &opt, OrbCommsCore &comms,
+                      SimLink &link, OrbTarget &mqttState) {
+  if (rng() % 20 == 0) {
+    stall(1 + rng() % opt.stallMs);
+  }
+  link.ready = true;
+  comms.poll(link, orbCommands, millis());
+  if (rng() % 50 == 0) {
+    // keep the configured period so jitter numbers stay comparable
+    std::string payload = std::string(1, "GROW"[rng() % 4]) + std::to_string(opt.periodMs);
+    if (applyOrbPayload(payload.data(), payload.size(), mqttState)) mqttTarget.publish(mqttState);
+  }
+}
+
+static void printJitter(const char *label, std::vector<long> &lateUs) {
+  if (lateUs.empty()) return;
+  std::sort(lateUs.begin(), lateUs.end());
+  size_t n = lateUs.size();
+  printf("%s: %zu ticks, late p50=%ldus p99=%ldus max=%ldus\n", label, n, lateUs[n / 2],
+         lateUs[n * 99 / 100], lateUs[n - 1]);
+}
+
+static SimLink scriptFor(const SimOptions &opt) {
+  SimLink link;
+  std::string speed = std::to_string(opt.periodMs);
+  link.script = "G" + speed + "R" + speed + "O" + speed + "W" + speed + " ";
+  return link;
+}
+
+static void runDualCore(const SimOptions &opt) {
+  std::vector<long> lateUs;
+  DoubleBuffer<OrbFrame> orbFrame;
+
+  std::thread render([&] {
+    static OrbRenderCore core;
+    core.state.apply({'S', opt.periodMs});
+    Clock::time_point next = Clock::now();
+    while (running.load(std::memory_order_relaxed)) {
+      std::this_thread::sleep_until(next);
+      lateUs.push_back(
+          std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - next).count());
+
+      orbFrame.publish(core.tick(orbCommands, mqttTarget, millis()));
+      next += std::chrono::milliseconds(core.state.periodMs());
+    }
+  });
+
+  std::thread comms([&] {
+    std::mt19937 rng(1);
+    OrbCommsCore core;
+    SimLink link = scriptFor(opt);
+    OrbTarget mqttState = {0, -1, -1, 0, 0};
+    uint32_t lastTick = 0;
+    uint32_t frames = 0;
+    while (running.load(std::memory_order_relaxed)) {
+      commsStep(rng, opt, core, link, mqttState);
+      OrbFrame frame;
+      if (orbFrame.read(frame) && frame.tick != lastTick) {
+        lastTick = frame.tick;
+        frames++;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    printf("comms saw %u distinct frames\n", frames);
+  });
+
+  std::this_thread::sleep_for(std::chrono::seconds(opt.seconds));
+  running = false;
+  render.join();
+  comms.join();
+  printJitter("dual-core", lateUs);
+}
+
+// Same work, one loop(): a stall delays the next pulse step directly
+static void runSingleLoop(const SimOptions &opt) {
+  std::vector<long> lateUs;
+  std::mt19937 rng(1);
+  static OrbRenderCore render;
+  OrbCommsCore comms;
+  SimLink link = scriptFor(opt);
+  OrbTarget mqttState = {0, -1, -1, 0, 0};
+  render.state.apply({'S', opt.periodMs});
+
+  Clock::time_point end = Clock::now() + std::chrono::seconds(opt.seconds);
+  Clock::time_point next = Clock::now();
+  while (Clock::now() < end) {
+    commsStep(rng, opt, comms, link, mqttState);
+    Clock::time_point now = Clock::now();
+    if (now >= next) {
+      lateUs.push_back(std::chrono::duration_cast<std::chrono::microseconds>(now - next).count());
+      render.tick(orbCommands, mqttTarget, millis());
+      next += std::chrono::milliseconds(render.state.periodMs());
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  printJitter("single-loop", lateUs);
+}
+
+// Every field of a published value is the same counter, so a copy that
+// mixes two publishes shows up as fields that disagree
+struct TornCheck {
+  uint32_t words[8];
+};
+
+static void checkTornReads() {
+  DoubleBuffer<TornCheck> buffer;
+  std::atomic<bool> writing{true};
+  std::thread writer([&] {
+    TornCheck value;
+    for (uint32_t n = 1; writing.load(std::memory_order_relaxed); n++) {
+      std::fill(std::begin(value.words), std::end(value.words), n);
+      buffer.publish(value);
+    }
+  });
+
+  uint64_t reads = 0, torn = 0;
+  Clock::time_point end = Clock::now() + std::chrono::seconds(1);
+  while (Clock::now() < end) {
+    TornCheck copy;
+    buffer.read(copy);
+    reads++;
+    for (uint32_t w : copy.words) {
+      if (w != copy.words[0]) {
+        torn++;
+        break;
+      }
+    }
+  }
+  writing = false;
+  writer.join();
+  printf("double buffer: %llu reads under a busy writer, %llu torn\n", (unsigned long long)reads,
+         (unsigned long long)torn);
+}
+
+int main(int argc, char **argv) {
+  SimOptions opt;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--single")) {
+      opt.single = true;
+    } else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) {
+      opt.seconds = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--period") && i + 1 < argc) {
+      opt.periodMs = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--stall") && i + 1 < argc) {
+      opt.stallMs = std::max(1, atoi(argv[++i]));
+    } else {
+      fprintf(stderr, "usage: %s [--single] [--seconds N] [--period MS] [--stall MS]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  if (opt.single) {
+    runSingleLoop(opt);
+  } else {
+    runDualCore(opt);
+  }
+  checkTornReads();
+  return 0;
+}
@@ -0,0 +1,182 @@
+// Fires orb commands when events start and end. Each event's dateString
+// becomes two scheduled actions on a TimingWheel (1 ms ticks): the event's
+// colour at the start, back to white at the end. Everything due on a tick
+// goes out as one batch. A window that has already ended is skipped, and
+// one under way starts at once.
+//
+//   g++ -std=c++17 -O2 event_scheduler.cpp -o event_scheduler
+//   ./event_scheduler < events.txt       lines of orbId|mode|dateString
+//   ./event_scheduler --parse "Sat 2pm - 5pm"
+//   ./event_scheduler --bench [N]        insert/cancel cost, memory, jitter
+//
+// Commands go to stdout as "<orbId> <mode><speed>", one line per orb, so
+// the output can be piped into whatever owns the link.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "EventTime.h"
+#include "TimingWheel.h"
+
+using Clock = std::chrono::steady_clock;
+
+struct OrbAction {
+  uint32_t orbId;
+  char mode;
+  uint16_t pulseSpeed;
+};
+
+const uint16_t eventPulseSpeed = 20; // same as the sketch's default
+
+static uint64_t wallMs() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+static double nsPerOp(Clock::time_point start, size_t ops) {
+  return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ops;
+}
+
+static void printTimes(const char *text) {
+  EventWindow w;
+  if (!parseEventWindow(text, time(nullptr), w)) {
+    printf("can't read \"%s\"\n", text);
+    return;
+  }
+  char start[64], end[64];
+  strftime(start, sizeof(start), "%a %Y-%m-%d %H:%M", localtime(&w.start));
+  strftime(end, sizeof(end), "%a %Y-%m-%d %H:%M", localtime(&w.end));
+  printf("%s -> %s\n", start, end);
+}
+
+// Only the last command per orb in a batch matters
+static void sendBatch(std::vector<OrbAction> &due) {
+  std::stable_sort(due.begin(), due.end(),
+                   [](const OrbAction &a, const OrbAction &b) { return a.orbId < b.orbId; });
+  for (size_t i = 0; i < due.size(); i++) {
+    if (i + 1 < due.size() && due[i + 1].orbId == due[i].orbId) continue;
+    printf("%u %c%u\n", due[i].orbId, due[i].mode, due[i].pulseSpeed);
+  }
+  fflush(stdout);
+  due.clear();
+}
+
+static int runEvents() {
+  uint64_t start = wallMs();
+  TimingWheel<OrbAction> wheel(start);
+  time_t now = time(nullptr);
+
+  char line[512];
+  while (fgets(line, sizeof(line), stdin)) {
+    line[strcspn(line, "\r\n")] = 0;
+    char *mode = strchr(line, '|');
+    char *when = mode ? strchr(mode + 1, '|') : nullptr;
+    EventWindow w;
+    if (!when || !parseEventWindow(when + 1, now, w)) {
+      fprintf(stderr, "skipping \"%s\"\n", line);
+      continue;
+    }
+    // Orbs are numbered; an id that isn't a number would land on orb 0
+    char *idEnd = nullptr;
+    unsigned long id = strtoul(line, &idEnd, 10);
+    if (idEnd == line || idEnd != mode || id > UINT32_MAX || line[0] == '-') {
+      fprintf(stderr, "skipping \"%s\": orb id isn't a number\n", line);
+      continue;
+    }
+    if (w.end <= now) {
+      fprintf(stderr, "skipping \"%s\": already over\n", line);
+      continue;
+    }
+    uint32_t orbId = (uint32_t)id;
+    wheel.schedule((uint64_t)w.start * 1000, OrbAction{orbId, mode[1], eventPulseSpeed});
+    wheel.schedule((uint64_t)w.end * 1000, OrbAction{orbId, 'W', eventPulseSpeed});
+  }
+  fprintf(stderr, "%zu actions scheduled\n", wheel.size());
+
+  std::vector<OrbAction> due;
+  while (wheel.size() > 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    wheel.advance(wallMs(), due);
+    if (!due.empty()) sendBatch(due);
+  }
+  return 0;
+}
+
+static void runBench(size_t count) {
+  std::mt19937_64 rng(1);
+  const uint64_t horizon = 3600 * 1000; // an hour of 1 ms ticks
+  std::vector<uint64_t> ticks(count);
+  for (uint64_t &t : ticks) t = rng() % horizon;
+
+  TimingWheel<OrbAction> wheel;
+  wheel.reserve(count);
+  std::vector<TimingWheel<OrbAction>::Handle> handles(count);
+  Clock::time_point t0 = Clock::now();
+  for (size_t i = 0; i < count; i++) {
+    handles[i] = wheel.schedule(ticks[i], OrbAction{(uint32_t)i, 'G', eventPulseSpeed});
+  }
+  printf("insert: %.1f ns/op\n", nsPerOp(t0, count));
+  printf("memory: %.1f bytes/item (%zu-byte entries)\n", (double)wheel.memoryBytes() / count,
+         wheel.memoryBytes() / count);
+
+  std::shuffle(handles.begin(), handles.end(), rng);
+  size_t cancels = count / 10;
+  t0 = Clock::now();
+  for (size_t i = 0; i < cancels; i++) wheel.cancel(handles[i]);
+  printf("cancel: %.1f ns/op (%zu)\n", nsPerOp(t0, cancels), cancels);
+
+  std::vector<OrbAction> due;
+  due.reserve(count);
+  size_t remaining = wheel.size();
+  t0 = Clock::now();
+  wheel.advance(horizon, due);
+  double seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+  printf("advance: %zu fired over %llu ticks in %.0f ms (%.1f ns/item)\n", due.size(),
+         (unsigned long long)horizon, seconds * 1e3, seconds * 1e9 / remaining);
+
+  // Real time: the same count spread over 10 s of 1 ms ticks, lateness of
+  // each batch against when it was due
+  const uint64_t spanMs = 10 * 1000;
+  TimingWheel<OrbAction> live;
+  live.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    live.schedule(rng() % spanMs, OrbAction{(uint32_t)i, 'R', eventPulseSpeed});
+  }
+  std::vector<long> lateUs;
+  lateUs.reserve(spanMs);
+  Clock::time_point origin = Clock::now();
+  for (uint64_t tick = 0; tick < spanMs; tick++) {
+    Clock::time_point dueAt = origin + std::chrono::milliseconds(tick);
+    std::this_thread::sleep_until(dueAt);
+    due.clear();
+    live.advance(tick, due);
+    lateUs.push_back(
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - dueAt).count());
+  }
+  std::sort(lateUs.begin(), lateUs.end());
+  size_t n = lateUs.size();
+  printf("firing: %zu batches, late p50=%ldus p99=%ldus max=%ldus\n", n, lateUs[n / 2],
+         lateUs[n * 99 / 100], lateUs[n - 1]);
+}
+
+int main(int argc, char **argv) {
+  if (argc == 3 && !strcmp(argv[1], "--parse")) {
+    printTimes(argv[2]);
+  } else if (argc >= 2 && !strcmp(argv[1], "--bench")) {
+    runBench(argc >= 3 ? (size_t)atol(argv[2]) : 1000000);
+  } else if (argc == 1) {
+    return runEvents();
+  } else {
+    fprintf(stderr, "usage: %s [--parse TEXT | --bench [N]] < events\n", argv[0]);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,256 @@
+// Checks src/OrbFixed.h against plain integer maths, then times the
+// colour paths ported onto it against the code they replaced: Arduino's
+// map() for a pin level, the int brightness walk, the running-remainder
+// cache build, and a long-maths lerp.
+//
+//   g++ -std=c++11 -O2 fixed_point_bench.cpp -o fixed_point_bench
+//   ./fixed_point_bench [--rounds N]
+//
+// Cycles are the host's TSC (x86 only), best of N rounds. map() is built
+// here the way WMath.cpp has it, an out-of-line function dividing by its
+// in_max - in_min argument, so the host pays a real division the way the
+// orb's __divmodsi4 does. The fixed-point side never divides; on AVR the
+// gap is wider than here, since a 32-bit division there runs in software.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <x86intrin.h>
+
+#include "../src/OrbCore.h"
+
+// ---- What the orb used to run ----
+
+__attribute__((noipa)) static long arduinoMap(long x, long inMin, long inMax, long outMin,
+                                             long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+struct IntPulse {
+  int brightness = 0;
+  int fadeDirection = 1;
+
+  void advance() {
+    brightness += fadeDirection;
+    if (brightness >= 255 || brightness <= 0) fadeDirection *= -1;
+  }
+};
+
+struct SatPulse {
+  uint8_t brightness = 0;
+  int8_t fadeDirection = 1;
+
+  void advance() {
+    brightness = orbAddSat(brightness, fadeDirection);
+    if (brightness == 255 || brightness == 0) fadeDirection = (int8_t)-fadeDirection;
+  }
+};
+
+// OrbPeriodCache<768>::build as it was: a running remainder per channel
+static void remainderBuild(char mode, OrbLevels *table) {
+  int targets[3];
+  orbTargets(mode, targets[0], targets[1], targets[2]);
+  int step[3], remainder[3] = {0, 0, 0}, dimmed[3] = {0, 0, 0};
+  for (int c = 0; c < 3; c++) step[c] = 255 - targets[c];
+  for (int brightness = 0; brightness < 256; brightness++) {
+    table[brightness].red = (uint8_t)(255 - dimmed[0]);
+    table[brightness].green = (uint8_t)(255 - dimmed[1]);
+    table[brightness].blue = (uint8_t)(255 - dimmed[2]);
+    for (int c = 0; c < 3; c++) {
+      remainder[c] += step[c];
+      if (remainder[c] >= 255) {
+        remainder[c] -= 255;
+        dimmed[c]++;
+      }
+    }
+  }
+}
+
+// ---- Exactness ----
+
+static long clampTo(long v, long lo, long hi) {
+  return v < lo ? lo : v > hi ? hi : v;
+}
+
+// Every pair of an 8-bit format against long maths, clamped
+template <typename T, int Frac>
+static bool checkAllPairs() {
+  typedef OrbQ<T, Frac> Q;
+  const long lo = OrbFixedTraits<T>::min, hi = OrbFixedTraits<T>::max;
+  for (long a = lo; a <= hi; a++) {
+    for (long b = lo; b <= hi; b++) {
+      Q x = Q::fromRaw((T)a), y = Q::fromRaw((T)b);
+      if ((x + y).raw() != clampTo(a + b, lo, hi)) return false;
+      if ((x - y).raw() != clampTo(a - b, lo, hi)) return false;
+      long product = (a * b + (1L << (Frac - 1))) >> Frac;
+      if ((x * y).raw() != clampTo(product, lo, hi)) return false;
+    }
+  }
+  return true;
+}
+
+static bool checkQ8_8() {
+  std::mt19937 rng(3);
+  for (int i = 0; i < 1000000; i++) {
+    long a = (int16_t)rng(), b = (int16_t)rng();
+    OrbQ8_8 x = OrbQ8_8::fromRaw((int16_t)a), y = OrbQ8_8::fromRaw((int16_t)b);
+    if ((x + y).raw() != clampTo(a + b, -32768, 32767)) return false;
+    if ((x - y).raw() != clampTo(a - b, -32768, 32767)) return false;
+    if ((x * y).raw() != clampTo((a * b + 128) >> 8, -32768, 32767)) return false;
+    OrbUQ0_8 t = OrbUQ0_8::fromRaw((uint8_t)(rng() & 0xff));
+    long lerp = a + (((b - a) * t.raw()) >> 8);
+    if (orbLerp(x, y, t).raw() != lerp) return false;
+  }
+  return OrbQ8_8::fromInt(200).raw() == 32767 && OrbQ8_8::fromInt(-3).toInt() == -3;
+}
+
+static bool selfCheck() {
+  for (unsigned x = 0; x <= 255 * 255; x++) {
+    if (orbDiv255((uint16_t)x) != x / 255) return false;
+  }
+  for (int b = 0; b < 256; b++) {
+    for (int target = 0; target < 256; target++) {
+      if (orbMapLevel(b, target) != arduinoMap(b, 0, 255, 255, target)) return false;
+    }
+  }
+  for (int a = 0; a < 256; a++) {
+    for (int b = 0; b < 256; b++) {
+      for (int t = 0; t < 256; t++) {
+        long expected = a + (long)(b - a) * t / 255;
+        if (orbLerp8((uint8_t)a, (uint8_t)b, (uint8_t)t) != expected) return false;
+      }
+    }
+  }
+  if (!checkAllPairs<uint8_t, 8>() || !checkAllPairs<int8_t, 4>()) return false;
+  if (!checkQ8_8()) return false;
+
+  // Past either end, the level stops rather than wrapping
+  if (orbAddSat<uint8_t>(250, 7) != 255 || orbAddSat<uint8_t>(3, -7) != 0) return false;
+
+  IntPulse before;
+  SatPulse after;
+  for (int tick = 0; tick < 3 * pulseSteps; tick++) {
+    before.advance();
+    after.advance();
+    if (before.brightness != after.brightness) return false;
+  }
+
+  const char modes[] = {'O', 'G', 'R', 'W'};
+  for (char mode : modes) {
+    OrbLevels old[256];
+    remainderBuild(mode, old);
+    OrbPeriodCache<768> cache;
+    cache.build(mode);
+    for (int b = 0; b < 256; b++) {
+      const OrbLevels &now = cache.at(b);
+      if (now.red != old[b].red || now.green != old[b].green || now.blue != old[b].blue) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// ---- Cycles ----
+
+static volatile unsigned sink;
+
+template <typename Body>
+static double bestCycles(int rounds, unsigned per, Body body) {
+  double best = 1e18;
+  for (int r = 0; r < rounds; r++) {
+    unsigned long long start = __rdtsc();
+    body();
+    best = std::min(best, double(__rdtsc() - start) / per);
+  }
+  return best;
+}
+
+static void report(const char *what, double before, double after) {
+  std::printf("  %-28s %8.1f -> %6.1f cycles  (%.1fx)\n", what, before, after, before / after);
+}
+
+int main(int argc, char **argv) {
+  int rounds = 20;
+  for (int i = 1; i < argc; i++) {
+    if (!std::strcmp(argv[i], "--rounds") && i + 1 < argc) {
+      rounds = std::max(1, std::atoi(argv[++i]));
+    } else {
+      std::fprintf(stderr, "usage: %s [--rounds N]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  if (!selfCheck()) {
+    std::fprintf(stderr, "self-check failed: fixed-point results differ from integer maths\n");
+    return 1;
+  }
+  std::printf("self-check ok: map(), lerp, Q8 and Q8.8 ops, pulse walk and cache build match\n");
+
+  const unsigned levels = 256 * 256;
+  double mapCycles = bestCycles(rounds, levels, [] {
+    unsigned acc = 0;
+    for (int b = 0; b < 256; b++) {
+      for (int t = 0; t < 256; t++) acc += (unsigned)arduinoMap(b, 0, 255, 255, t);
+    }
+    sink = acc;
+  });
+  double levelCycles = bestCycles(rounds, levels, [] {
+    unsigned acc = 0;
+    for (int b = 0; b < 256; b++) {
+      for (int t = 0; t < 256; t++) acc += orbMapLevel(b, t);
+    }
+    sink = acc;
+  });
+
+  const unsigned ticks = 100000;
+  double intWalk = bestCycles(rounds, ticks, [] {
+    IntPulse p;
+    for (unsigned i = 0; i < ticks; i++) p.advance();
+    sink = (unsigned)p.brightness;
+  });
+  double satWalk = bestCycles(rounds, ticks, [] {
+    SatPulse p;
+    for (unsigned i = 0; i < ticks; i++) p.advance();
+    sink = p.brightness;
+  });
+
+  double remainderCycles = bestCycles(rounds, 1, [] {
+    OrbLevels table[256];
+    remainderBuild('O', table);
+    sink = table[200].green;
+  });
+  double scaleCycles = bestCycles(rounds, 1, [] {
+    OrbPeriodCache<768> cache;
+    cache.build('O');
+    sink = cache.at(200).green;
+  });
+
+  double longLerp = bestCycles(rounds, levels, [] {
+    unsigned acc = 0;
+    for (long a = 0; a < 256; a += 17) {
+      for (long t = 0; t < 256; t++) {
+        for (long b = 0; b < 256; b += 16) acc += (unsigned)arduinoMap(t, 0, 255, a, b);
+      }
+    }
+    sink = acc;
+  });
+  double fixedLerp = bestCycles(rounds, levels, [] {
+    unsigned acc = 0;
+    for (int a = 0; a < 256; a += 17) {
+      for (int t = 0; t < 256; t++) {
+        for (int b = 0; b < 256; b += 16) acc += orbLerp8((uint8_t)a, (uint8_t)b, (uint8_t)t);
+      }
+    }
+    sink = acc;
+  });
+
+  std::printf("host cycles, before -> after:\n");
+  report("pin level: map() -> scale8", mapCycles, levelCycles);
+  report("pulse tick: int -> sat add", intWalk, satWalk);
+  report("cache build (768 B)", remainderCycles, scaleCycles);
+  report("crossfade: map() -> lerp8", longLerp, fixedLerp);
+  return 0;
+}
@@ -0,0 +1,390 @@
+// Host-side batch renderer for frame streaming mode. Instead of every orb
+// running its own pulse, the host renders all of them and streams ready
+// pin levels ('F' / 'D' packets, see hackathon_LEDS.ino).
+//
+// Colour buffers are structure-of-arrays (one byte array per channel over
+// every pixel of every orb) so the pulse and map() maths run 16 pixels per
+// SSE2 instruction. Each orb's frame is delta-encoded against the last one
+// sent to it.
+//
+//   g++ -std=c++17 -O2 -pthread frame_renderer.cpp -o frame_renderer
+//   ./frame_renderer [--orbs 10000] [--pixels 16] [--frames 300] [--fps 15] [--threads N]
+//                    [--scalar 1]
+//
+// --fps is how often each orb is sent a frame, in orb time. The report
+// says whether that many bytes a second fit a 9600-baud link, and the
+// highest rate that would. Threads are started once and handed each frame
+// a slice of the fleet.
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "../src/OrbCore.h"
+
+using Clock = std::chrono::steady_clock;
+
+struct OrbFleet {
+  int orbs = 0;
+  int pixels = 0; // per orb
+
+  // Per orb
+  std::vector<uint32_t> periodMs;
+
+  // Per pixel, index = orb * pixels + pixel
+  std::vector<uint16_t> phase;
+  std::vector<uint16_t> step; // scratch: where in the pulse this pixel is
+  std::vector<uint8_t> targetR, targetG, targetB;
+  std::vector<uint8_t> red, green, blue;
+  std::vector<uint8_t> sentR, sentG, sentB;
+
+  void resize(int orbCount, int pixelCount) {
+    orbs = orbCount;
+    pixels = pixelCount;
+    size_t n = (size_t)orbs * pixels;
+    periodMs.assign(orbs, 20);
+    phase.assign(n, 0);
+    step.assign(n, 0);
+    targetR.assign(n, 0);
+    targetG.assign(n, 0);
+    targetB.assign(n, 0);
+    red.assign(n, 255);
+    green.assign(n, 255);
+    blue.assign(n, 255);
+    // Orbs power up dark (common anode), which is what "sent" starts as
+    sentR.assign(n, 255);
+    sentG.assign(n, 255);
+    sentB.assign(n, 255);
+  }
+};
+
+// Same as map(brightness, 0, 255, 255, target) on the orb:
+// 255 - floor(b * (255 - target) / 255); mapLevel8 below is its SSE form
+static inline uint8_t mapLevel(unsigned b, unsigned target) {
+  return orbMapLevel((int)b, (int)target);
+}
+
+static inline unsigned triangle(unsigned step) {
+  return step <= 255 ? step : pulseSteps - step;
+}
+
+static void renderScalar(OrbFleet &f, size_t begin, size_t end) {
+  for (size_t i = begin; i < end; i++) {
+    unsigned b = triangle(f.step[i]);
+    f.red[i] = mapLevel(b, f.targetR[i]);
+    f.green[i] = mapLevel(b, f.targetG[i]);
+    f.blue[i] = mapLevel(b, f.targetB[i]);
+  }
+}
+
+#if defined(__SSE2__)
+static inline __m128i mapLevel8(__m128i b, __m128i target) {
+  const __m128i k255 = _mm_set1_epi16(255);
+  const __m128i one = _mm_set1_epi16(1);
+  __m128i x = _mm_mullo_epi16(b, _mm_sub_epi16(k255, target));
+  __m128i q = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, one), _mm_srli_epi16(x, 8)), 8);
+  return _mm_sub_epi16(k255, q);
+}
+
+static inline __m128i triangle8(__m128i step) {
+  const __m128i k255 = _mm_set1_epi16(255);
+  __m128i down = _mm_sub_epi16(_mm_set1_epi16(pulseSteps), step);
+  __m128i falling = _mm_cmpgt_epi16(step, k255);
+  return _mm_or_si128(_mm_and_si128(falling, down), _mm_andnot_si128(falling, step));
+}
+
+static inline void mapChannel16(const uint8_t *target, uint8_t *out, __m128i bLo, __m128i bHi) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i t = _mm_loadu_si128((const __m128i *)target);
+  __m128i lo = mapLevel8(bLo, _mm_unpacklo_epi8(t, zero));
+  __m128i hi = mapLevel8(bHi, _mm_unpackhi_epi8(t, zero));
+  _mm_storeu_si128((__m128i *)out, _mm_packus_epi16(lo, hi));
+}
+
+static void renderSimd(OrbFleet &f, size_t begin, size_t end) {
+  size_t i = begin;
+  for (; i + 16 <= end; i += 16) {
+    __m128i bLo = triangle8(_mm_loadu_si128((const __m128i *)&f.step[i]));
+    __m128i bHi = triangle8(_mm_loadu_si128((const __m128i *)&f.step[i + 8]));
+    mapChannel16(&f.targetR[i], &f.red[i], bLo, bHi);
+    mapChannel16(&f.targetG[i], &f.green[i], bLo, bHi);
+    mapChannel16(&f.targetB[i], &f.blue[i], bLo, bHi);
+  }
+  renderScalar(f, i, end);
+}
+#else
+static void renderSimd(OrbFleet &f, size_t begin, size_t end) {
+  renderScalar(f, begin, end);
+}
+#endif
+
+// One divide per orb, then every pixel is base + its phase offset
+static void advance(OrbFleet &f, int orbBegin, int orbEnd, uint64_t timeMs) {
+  for (int o = orbBegin; o < orbEnd; o++) {
+    unsigned base = (unsigned)((timeMs / f.periodMs[o]) % pulseSteps);
+    size_t first = (size_t)o * f.pixels;
+    for (int p = 0; p < f.pixels; p++) {
+      unsigned s = base + f.phase[first + p];
+      f.step[first + p] = (uint16_t)(s >= pulseSteps ? s - pulseSteps : s);
+    }
+  }
+}
+
+// Appends [orb u16]['F'|'D' packet] for every orb whose frame changed and
+// returns the packet count. The orb id only routes the packet to its link.
+// A delta is (index r g b) per changed pixel and a full frame (r g b) per
+// pixel, both after a pixel count; the full frame wins when more than
+// about three quarters of the pixels moved.
+static size_t encode(OrbFleet &f, int orbBegin, int orbEnd, std::vector<uint8_t> &out) {
+  std::vector<uint8_t> changed(f.pixels);
+  size_t packets = 0;
+  for (int o = orbBegin; o < orbEnd; o++) {
+    size_t first = (size_t)o * f.pixels;
+    int count = 0;
+    for (int p = 0; p < f.pixels; p++) {
+      size_t i = first + p;
+      if (f.red[i] != f.sentR[i] || f.green[i] != f.sentG[i] || f.blue[i] != f.sentB[i]) {
+        changed[count++] = (uint8_t)p;
+      }
+    }
+    if (count == 0) continue;
+
+    packets++;
+    out.push_back((uint8_t)(o & 0xff));
+    out.push_back((uint8_t)(o >> 8));
+    if (2 + 4 * count < 2 + 3 * f.pixels) {
+      out.push_back('D');
+      out.push_back((uint8_t)count);
+      for (int c = 0; c < count; c++) {
+        size_t i = first + changed[c];
+        out.push_back(changed[c]);
+        out.push_back(f.red[i]);
+        out.push_back(f.green[i]);
+        out.push_back(f.blue[i]);
+      }
+    } else {
+      out.push_back('F');
+      out.push_back((uint8_t)f.pixels);
+      for (int p = 0; p < f.pixels; p++) {
+        out.push_back(f.red[first + p]);
+        out.push_back(f.green[first + p]);
+        out.push_back(f.blue[first + p]);
+      }
+    }
+    memcpy(&f.sentR[first], &f.red[first], f.pixels);
+    memcpy(&f.sentG[first], &f.green[first], f.pixels);
+    memcpy(&f.sentB[first], &f.blue[first], f.pixels);
+  }
+  return packets;
+}
+
+static bool useSimd = true;
+
+// Returns link bytes, i.e. without the routing header
+static size_t renderFrame(OrbFleet &f, int orbBegin, int orbEnd, uint64_t timeMs,
+                          std::vector<uint8_t> &out) {
+  advance(f, orbBegin, orbEnd, timeMs);
+  if (useSimd) {
+    renderSimd(f, (size_t)orbBegin * f.pixels, (size_t)orbEnd * f.pixels);
+  } else {
+    renderScalar(f, (size_t)orbBegin * f.pixels, (size_t)orbEnd * f.pixels);
+  }
+  size_t packets = encode(f, orbBegin, orbEnd, out);
+  return out.size() - 2 * packets;
+}
+
+static void setupFleet(OrbFleet &f, int orbs, int pixels) {
+  static const uint8_t modes[4][3] = {{0, 150, 255}, {255, 0, 255}, {0, 255, 255}, {0, 0, 0}};
+  std::mt19937 rng(7);
+  f.resize(orbs, pixels);
+  for (int o = 0; o < orbs; o++) {
+    f.periodMs[o] = 5 + rng() % 36;
+    const uint8_t *mode = modes[rng() % 4];
+    for (int p = 0; p < pixels; p++) {
+      size_t i = (size_t)o * pixels + p;
+      f.phase[i] = (uint16_t)(p * pulseSteps / pixels); // chase around the orb
+      f.targetR[i] = mode[0];
+      f.targetG[i] = mode[1];
+      f.targetB[i] = mode[2];
+    }
+  }
+}
+
+// The streamed frames must match what the orb would have rendered itself
+static bool selfCheck() {
+  for (unsigned x = 0; x <= 255 * 255; x++) {
+    if (((x + 1 + (x >> 8)) >> 8) != x / 255) return false;
+  }
+
+  OrbRenderState orb;
+  orb.apply({'M', 'O'});
+  OrbFleet f;
+  f.resize(1, 1);
+  f.targetR[0] = 0;
+  f.targetG[0] = 150;
+  f.targetB[0] = 255;
+  for (int tick = 1; tick <= 2 * pulseSteps; tick++) {
+    OrbFrame expected = orb.step();
+    f.step[0] = (uint16_t)(tick % pulseSteps);
+    renderScalar(f, 0, 1);
+    if (f.red[0] != expected.red || f.green[0] != expected.green || f.blue[0] != expected.blue) {
+      return false;
+    }
+  }
+
+  OrbFleet a, b;
+  setupFleet(a, 257, 16);
+  setupFleet(b, 257, 16);
+  advance(a, 0, a.orbs, 123456);
+  advance(b, 0, b.orbs, 123456);
+  renderScalar(a, 0, a.step.size());
+  renderSimd(b, 0, b.step.size());
+  return a.red == b.red && a.green == b.green && a.blue == b.blue;
+}
+
+// Renders one frame across threads that live for the whole run. Each
+// frame bumps a generation; every worker renders its slice for it and the
+// last one done wakes the caller, which has meanwhile done the last slice.
+class FramePool {
+public:
+  FramePool(OrbFleet &fleet, int threads)
+      : f(fleet), out(threads), linkBytes(threads), count(threads) {
+    for (int t = 0; t + 1 < threads; t++) workers.emplace_back([this, t] { work(t); });
+  }
+
+  ~FramePool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+      generation++;
+    }
+    wake.notify_all();
+    for (auto &w : workers) w.join();
+  }
+
+  size_t render(uint64_t timeMs) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      frameMs = timeMs;
+      pending = count - 1;
+      generation++;
+    }
+    wake.notify_all();
+    renderSlice(count - 1, timeMs);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return pending == 0; });
+    size_t bytes = 0;
+    for (size_t b : linkBytes) bytes += b;
+    return bytes;
+  }
+
+private:
+  void renderSlice(int t, uint64_t timeMs) {
+    int begin = (int)((int64_t)f.orbs * t / count);
+    int end = (int)((int64_t)f.orbs * (t + 1) / count);
+    out[t].clear();
+    linkBytes[t] = renderFrame(f, begin, end, timeMs, out[t]);
+  }
+
+  void work(int t) {
+    uint64_t seen = 0;
+    for (;;) {
+      uint64_t timeMs;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [&] { return generation != seen; });
+        seen = generation;
+        if (stopping) return;
+        timeMs = frameMs;
+      }
+      renderSlice(t, timeMs);
+      std::lock_guard<std::mutex> lock(mutex);
+      if (--pending == 0) done.notify_one();
+    }
+  }
+
+  OrbFleet &f;
+  std::vector<std::vector<uint8_t>> out;
+  std::vector<size_t> linkBytes;
+  int count;
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable wake, done;
+  uint64_t generation = 0;
+  uint64_t frameMs = 0;
+  int pending = 0;
+  bool stopping = false;
+};
+
+static double runBench(int orbs, int pixels, int frames, int fps, int threads,
+                       double &bytesPerOrbFrame) {
+  OrbFleet f;
+  setupFleet(f, orbs, pixels);
+  const uint64_t frameMs = 1000 / fps;
+  uint64_t bytes = 0;
+
+  FramePool pool(f, threads);
+  Clock::time_point start = Clock::now();
+  for (int frame = 0; frame < frames; frame++) {
+    bytes += pool.render(frame * frameMs);
+  }
+  double secs = std::chrono::duration<double>(Clock::now() - start).count();
+  bytesPerOrbFrame = (double)bytes / frames / orbs;
+  return frames / secs;
+}
+
+int main(int argc, char **argv) {
+  int orbs = 10000;
+  int pixels = 16;
+  int frames = 300;
+  int fps = 15;
+  int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (!strcmp(argv[i], "--orbs")) orbs = atoi(argv[i + 1]);
+    else if (!strcmp(argv[i], "--pixels")) pixels = std::min(255, atoi(argv[i + 1]));
+    else if (!strcmp(argv[i], "--frames")) frames = atoi(argv[i + 1]);
+    else if (!strcmp(argv[i], "--fps")) fps = std::min(1000, std::max(1, atoi(argv[i + 1])));
+    else if (!strcmp(argv[i], "--threads")) threads = std::max(1, atoi(argv[i + 1]));
+    else if (!strcmp(argv[i], "--scalar")) useSimd = atoi(argv[i + 1]) == 0;
+    else {
+      fprintf(stderr, "unknown option %s\n", argv[i]);
+      return 1;
+    }
+  }
+
+  if (!selfCheck()) {
+    fprintf(stderr, "renderer does not match the firmware pulse\n");
+    return 1;
+  }
+
+  double bytes = 0;
+  double fps1 = runBench(orbs, pixels, frames, fps, 1, bytes);
+  printf("%d orbs x %d pixels, 1 thread:  %.0f frames/s\n", orbs, pixels, fps1);
+  if (threads > 1) {
+    double fpsN = runBench(orbs, pixels, frames, fps, threads, bytes);
+    printf("%d orbs x %d pixels, %d threads: %.0f frames/s\n", orbs, pixels, threads, fpsN);
+  }
+  // 9600 baud at 10 bits a byte
+  const double linkBytesPerSec = 960;
+  double fullFrame = 2 + 3.0 * pixels;
+  double needed = bytes * fps;
+  printf("link bytes per orb per frame: %.1f (full frame %.0f)\n", bytes, fullFrame);
+  printf("at %d fps that is %.0f bytes/s per link: %s the %.0f of 9600 baud"
+         " (at most %.1f fps would)\n",
+         fps, needed, needed <= linkBytesPerSec ? "fits" : "over", linkBytesPerSec,
+         bytes > 0 ? linkBytesPerSec / bytes : 0.0);
+  return 0;
+}
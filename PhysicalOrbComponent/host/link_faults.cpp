@@ -0,0 +1,329 @@
+// Drives the firmware's Serial1 parser through a faulty link (FaultyLink.h)
+// and reports how many commands the orb gets right and how long it spends
+// showing the wrong thing.
+//
+//   g++ -std=c++17 -O2 link_faults.cpp -o link_faults
+//   ./link_faults [--commands N] [--interval MS] [--refresh MS] [--seed N]
+//   ./link_faults --loss P --flip P --burst START:END[:FLIP] --latency MS
+//                 --jitter MS --baud TX:RX [...]
+//
+// With no fault options it runs a set of profiles, from a clean cable to a
+// bad one. Any fault option runs just that link instead.
+//
+// The controller side is what orb_controller sends: a command every
+// --interval ms on average (a mode letter, or a speed ended by '\n') and
+// 'H' every orbHeartbeatMs. --refresh also resends the whole state
+// ("G25\n") every N ms, which is how a controller can recover a lost
+// command. The orb side is OrbCommandParser and OrbLiveness
+// (src/OrbProtocol.h) polled every ms, with the ESP32 comms task's 1 s
+// timeout for a number with nothing after it.
+//
+// A command is ok when the orb's parser produces exactly what was sent
+// and nothing else from its bytes, lost when it produces nothing, and
+// wrong when something else comes out, e.g. 'G' with a flipped bit is an
+// 'O'. The orb is out of sync once a command should have landed and its
+// mode or speed still isn't what the controller last set. The incident
+// ends when it is again; its length is the recovery time.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/OrbProtocol.h"
+#include "FaultyLink.h"
+
+struct Frame {
+  int64_t dueUs;
+  OrbCommand expect[2];
+  int expectCount;
+  bool heartbeat;
+  std::vector<OrbCommand> got;
+};
+
+struct RunOptions {
+  int commands = 20000;
+  int intervalMs = 200;
+  int refreshMs = 0;
+  uint64_t seed = 1;
+};
+
+struct RunResult {
+  LinkStats link;
+  int commands = 0, ok = 0, lost = 0, wrong = 0;
+  int safeTrips = 0;
+  std::vector<int64_t> incidentsUs;
+  int64_t outOfSyncUs = 0;
+  int64_t totalUs = 0;
+};
+
+static const char modes[] = {'O', 'G', 'R', 'W', orbCandleMode};
+
+static RunResult run(const LinkFaults &faults, const RunOptions &opt) {
+  RunResult result;
+  FaultyLink link(faults, opt.seed);
+  std::mt19937_64 rng(opt.seed ^ 0x5DEECE66DULL);
+  std::exponential_distribution<double> gap(1.0 / (opt.intervalMs * 1000.0));
+
+  std::vector<Frame> frames;
+  uint32_t latestState = 0; // newest frame that set mode or speed
+  char wantMode = 'W';
+  int wantSpeed = 20;
+
+  auto send = [&](const std::string &bytes, int64_t nowUs, std::initializer_list<OrbCommand> expect,
+                  bool heartbeat) {
+    Frame f = {};
+    f.heartbeat = heartbeat;
+    for (const OrbCommand &c : expect) f.expect[f.expectCount++] = c;
+    uint32_t tag = (uint32_t)frames.size();
+    for (char c : bytes) link.write((uint8_t)c, nowUs, tag);
+    // When it should have landed at the latest, plus the orb's 1 ms poll
+    f.dueUs = link.lineFreeAtUs() + faults.latencyUs + faults.jitterUs + 1000;
+    frames.push_back(f);
+    if (!heartbeat) latestState = tag;
+  };
+
+  OrbCommandParser parser;
+  OrbLiveness liveness;
+  char orbMode = 'W';
+  int orbSpeed = 20;
+  int64_t lastByteUs = 0;
+  uint32_t lastTag = 0;
+
+  auto apply = [&](const OrbCommand &cmd, uint32_t tag, int64_t nowUs) {
+    if (cmd.kind == orbHeartbeat) {
+      liveness.beat((unsigned long)(nowUs / 1000));
+      return;
+    }
+    if (cmd.kind != 'M' && cmd.kind != 'S') return;
+    frames[tag].got.push_back(cmd);
+    if (cmd.kind == 'M') orbMode = (char)cmd.value;
+    if (cmd.kind == 'S') orbSpeed = cmd.value;
+  };
+
+  int64_t nextCommandUs = (int64_t)gap(rng);
+  int64_t nextBeatUs = 0;
+  int64_t nextRefreshUs = opt.refreshMs > 0 ? opt.refreshMs * 1000LL : -1;
+  size_t dueChecked = 0;
+  int64_t incidentStartUs = -1;
+  int sent = 0;
+  int64_t endUs = -1;
+
+  for (int64_t now = 0;; now += 1000) {
+    // ---- Controller ----
+    if (sent < opt.commands && now >= nextCommandUs) {
+      if (rng() % 4 == 0) {
+        int speed = 5 + (int)(rng() % 56);
+        wantSpeed = speed;
+        send(std::to_string(speed) + "\n", now, {{'S', speed}}, false);
+      } else {
+        char mode;
+        do {
+          mode = modes[rng() % sizeof(modes)];
+        } while (mode == wantMode);
+        wantMode = mode;
+        send(std::string(1, mode), now, {{'M', mode}}, false);
+      }
+      sent++;
+      nextCommandUs = now + 1000 + (int64_t)gap(rng);
+      if (sent == opt.commands) endUs = now + 5000000; // let the last ones land
+    }
+    if (nextRefreshUs >= 0 && now >= nextRefreshUs) {
+      send(std::string(1, wantMode) + std::to_string(wantSpeed) + "\n", now,
+           {{'M', wantMode}, {'S', wantSpeed}}, false);
+      nextRefreshUs = now + opt.refreshMs * 1000LL;
+    }
+    if (now >= nextBeatUs) {
+      send(std::string(1, orbHeartbeat), now, {}, true);
+      nextBeatUs = now + orbHeartbeatMs * 1000;
+    }
+
+    // ---- Orb ----
+    LinkByte b;
+    while (link.read(now, b)) {
+      OrbCommand out[2];
+      int count = parser.feed((char)b.value, out);
+      for (int i = 0; i < count; i++) apply(out[i], b.tag, now);
+      lastByteUs = b.atUs;
+      lastTag = b.tag;
+    }
+    OrbCommand flushed;
+    if (parser.pending() && now - lastByteUs >= 1000000 && parser.flush(flushed)) {
+      apply(flushed, lastTag, now);
+    }
+    if (liveness.lapsed((unsigned long)(now / 1000))) {
+      result.safeTrips++;
+      orbMode = orbSafeMode;
+      orbSpeed = orbSafeSpeed;
+    }
+
+    // ---- Sync ----
+    bool synced = orbMode == wantMode && orbSpeed == wantSpeed;
+    // Only the newest state matters: an older command that went missing
+    // but was overtaken by a good one never showed
+    while (dueChecked < frames.size() && frames[dueChecked].dueUs <= now) {
+      if (dueChecked == latestState && !synced && incidentStartUs < 0) incidentStartUs = now;
+      dueChecked++;
+    }
+    if (result.safeTrips > 0 && !synced && incidentStartUs < 0 && liveness.inSafeEffect()) {
+      incidentStartUs = now;
+    }
+    if (synced && incidentStartUs >= 0) {
+      result.incidentsUs.push_back(now - incidentStartUs);
+      result.outOfSyncUs += now - incidentStartUs;
+      incidentStartUs = -1;
+    }
+
+    if (endUs >= 0 && now >= endUs) {
+      if (incidentStartUs >= 0) {
+        result.incidentsUs.push_back(now - incidentStartUs);
+        result.outOfSyncUs += now - incidentStartUs;
+      }
+      result.totalUs = now;
+      break;
+    }
+  }
+
+  for (const Frame &f : frames) {
+    if (f.heartbeat) continue;
+    result.commands++;
+    bool exact = (int)f.got.size() == f.expectCount;
+    for (int i = 0; exact && i < f.expectCount; i++) {
+      exact = f.got[i].kind == f.expect[i].kind && f.got[i].value == f.expect[i].value;
+    }
+    if (exact) {
+      result.ok++;
+    } else if (f.got.empty()) {
+      result.lost++;
+    } else {
+      result.wrong++;
+    }
+  }
+  result.link = link.stats;
+  return result;
+}
+
+static double percentileMs(std::vector<int64_t> v, double q) {
+  if (v.empty()) return 0;
+  std::sort(v.begin(), v.end());
+  return v[std::min(v.size() - 1, (size_t)(v.size() * q))] / 1000.0;
+}
+
+static void printHeader() {
+  std::printf("%-22s %7s %7s %7s | %6s %6s %6s %5s | %9s %8s %8s %8s %6s\n", "link", "lost",
+              "flipped", "framing", "ok", "lost", "wrong", "safe", "incidents", "p50 ms", "p99 ms",
+              "max ms", "out");
+}
+
+static void printRow(const char *name, const RunResult &r) {
+  double n = r.commands > 0 ? r.commands : 1;
+  double bytes = r.link.sent > 0 ? (double)r.link.sent : 1;
+  std::printf("%-22s %6.2f%% %6.2f%% %6.2f%% | %5.1f%% %5.2f%% %5.2f%% %5d | %9zu %8.0f %8.0f "
+              "%8.0f %5.2f%%\n",
+              name, 100 * r.link.lost / bytes, 100 * r.link.flipped / bytes,
+              100 * r.link.framing / bytes, 100 * r.ok / n, 100 * r.lost / n, 100 * r.wrong / n,
+              r.safeTrips, r.incidentsUs.size(), percentileMs(r.incidentsUs, 0.5),
+              percentileMs(r.incidentsUs, 0.99), percentileMs(r.incidentsUs, 1.0),
+              r.totalUs > 0 ? 100.0 * r.outOfSyncUs / r.totalUs : 0.0);
+}
+
+struct Profile {
+  const char *name;
+  LinkFaults faults;
+};
+
+static LinkFaults makeFaults(double loss, double flip, double burstStart, double burstEnd,
+                             int latencyMs, int jitterMs, int rxBaud) {
+  LinkFaults f;
+  f.lossRate = loss;
+  f.bitFlipRate = flip;
+  f.burstStart = burstStart;
+  f.burstEnd = burstEnd;
+  f.latencyUs = latencyMs * 1000LL;
+  f.jitterUs = jitterMs * 1000LL;
+  f.rxBaud = rxBaud;
+  return f;
+}
+
+int main(int argc, char **argv) {
+  RunOptions opt;
+  LinkFaults custom;
+  bool haveCustom = false;
+  for (int i = 1; i < argc; i++) {
+    bool more = i + 1 < argc;
+    if (!strcmp(argv[i], "--commands") && more) {
+      opt.commands = std::max(1, atoi(argv[++i]));
+    } else if (!strcmp(argv[i], "--interval") && more) {
+      opt.intervalMs = std::max(1, atoi(argv[++i]));
+    } else if (!strcmp(argv[i], "--refresh") && more) {
+      opt.refreshMs = std::max(0, atoi(argv[++i]));
+    } else if (!strcmp(argv[i], "--seed") && more) {
+      opt.seed = strtoull(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--loss") && more) {
+      custom.lossRate = atof(argv[++i]);
+      haveCustom = true;
+    } else if (!strcmp(argv[i], "--flip") && more) {
+      custom.bitFlipRate = atof(argv[++i]);
+      haveCustom = true;
+    } else if (!strcmp(argv[i], "--burst") && more) {
+      double start = 0, end = 0.1, flip = 0.2;
+      if (sscanf(argv[++i], "%lf:%lf:%lf", &start, &end, &flip) < 2) {
+        fprintf(stderr, "--burst wants START:END[:FLIP]\n");
+        return 1;
+      }
+      custom.burstStart = start;
+      custom.burstEnd = end;
+      custom.burstBitFlipRate = flip;
+      haveCustom = true;
+    } else if (!strcmp(argv[i], "--latency") && more) {
+      custom.latencyUs = atoi(argv[++i]) * 1000LL;
+      haveCustom = true;
+    } else if (!strcmp(argv[i], "--jitter") && more) {
+      custom.jitterUs = atoi(argv[++i]) * 1000LL;
+      haveCustom = true;
+    } else if (!strcmp(argv[i], "--baud") && more) {
+      if (sscanf(argv[++i], "%d:%d", &custom.txBaud, &custom.rxBaud) != 2 || custom.txBaud <= 0 ||
+          custom.rxBaud <= 0) {
+        fprintf(stderr, "--baud wants TX:RX\n");
+        return 1;
+      }
+      haveCustom = true;
+    } else {
+      fprintf(stderr,
+              "usage: %s [--commands N] [--interval MS] [--refresh MS] [--seed N]\n"
+              "          [--loss P] [--flip P] [--burst START:END[:FLIP]] [--latency MS]\n"
+              "          [--jitter MS] [--baud TX:RX]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  std::printf("%d commands, one every %d ms on average, refresh %s, seed %llu\n\n", opt.commands,
+              opt.intervalMs, opt.refreshMs > 0 ? (std::to_string(opt.refreshMs) + " ms").c_str()
+                                                : "off",
+              (unsigned long long)opt.seed);
+  printHeader();
+  if (haveCustom) {
+    printRow("custom", run(custom, opt));
+    return 0;
+  }
+
+  // loss, flip, burst start/end, latency, jitter, receiver baud
+  const Profile profiles[] = {
+      {"clean", makeFaults(0, 0, 0, 0.1, 0, 0, 9600)},
+      {"usb-serial, 20ms", makeFaults(0, 0, 0, 0.1, 20, 10, 9600)},
+      {"field cable", makeFaults(0.001, 1e-4, 0.0005, 0.1, 20, 30, 9600)},
+      {"noisy cable", makeFaults(0.01, 1e-3, 0.005, 0.05, 50, 100, 9600)},
+      {"radio bridge", makeFaults(0.02, 1e-4, 0.002, 0.02, 120, 250, 9600)},
+      {"baud -5% (9120)", makeFaults(0, 0, 0, 0.1, 0, 0, 9120)},
+      {"baud -8% (8832)", makeFaults(0, 0, 0, 0.1, 0, 0, 8832)},
+      {"baud +5% (10080)", makeFaults(0, 0, 0, 0.1, 0, 0, 10080)},
+      {"baud +8% (10368)", makeFaults(0, 0, 0, 0.1, 0, 0, 10368)},
+  };
+  for (const Profile &p : profiles) printRow(p.name, run(p.faults, opt));
+  return 0;
+}
@@ -0,0 +1,555 @@
+// Link health monitor for a fleet of orbs. Forwards commands to each orb's
+// Serial1 link, asks every orb for its status once a second ('?', see
+// src/OrbProtocol.h) and serves the counters from LinkMetrics.h in
+// Prometheus text format.
+//
+//   g++ -std=c++17 -O2 -pthread link_monitor.cpp -o link_monitor
+//   ./link_monitor --port 1=/dev/ttyACM0 [--port 2=...] [--http 9464]
+//   ./link_monitor --sim 1000 [--seconds N] [--http 9464]
+//   ./link_monitor --sim 1000 --overhead
+//
+// With --port, commands come in on stdin as "<orbId> <command>", which is
+// what event_scheduler prints. --sim runs N in-process orbs on socket
+// pairs, a few of them on lossy or dead links. --overhead runs a fixed
+// command load with and without recording and compares the link thread's
+// CPU time.
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/OrbChannels.h"
+#include "../src/OrbProtocol.h"
+#include "LinkMetrics.h"
+
+const int probeIntervalMs = 1000;
+const int replyTimeoutMs = 250;
+const int maxProbeAttempts = 3;
+
+static std::atomic<bool> running{true};
+
+static int64_t monotonicUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static int64_t threadCpuUs() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// ---- Link thread ----
+
+struct OrbLink {
+  uint32_t orbId;
+  int fd;
+  uint8_t reply[orbStatusLength];
+  int replyLength = 0;
+  int64_t probeSentUs = -1; // -1 = nothing outstanding
+  int probeAttempts = 0;
+  int64_t nextProbeUs = 0;
+  // Sent since the last poll(), not yet in the metrics
+  uint32_t unfoldedBytes = 0;
+  uint32_t unfoldedCommands = 0;
+};
+
+// Owns the links and is the only writer of their metrics. Sends are
+// tallied on the OrbLink, whose line write() just touched, and folded into
+// the metrics in poll()'s walk over the links: touching a cold metrics
+// line straight after every write() syscall cost ~100 ns a command.
+template <typename Metrics>
+class LinkMonitor {
+public:
+  LinkMonitor(std::vector<OrbLink> &links, Metrics *metrics, int probeMs)
+      : links(links), metrics(metrics), probeUs((int64_t)probeMs * 1000) {
+    epollFd = epoll_create1(0);
+    int64_t now = monotonicUs();
+    for (size_t i = 0; i < links.size(); i++) {
+      epoll_event ev = {};
+      ev.events = EPOLLIN;
+      ev.data.u64 = i;
+      epoll_ctl(epollFd, EPOLL_CTL_ADD, links[i].fd, &ev);
+      // Spread the probes over the interval instead of 1000 at once
+      links[i].nextProbeUs = now + probeUs * (int64_t)i / (int64_t)links.size();
+      metrics[i].orbId = links[i].orbId;
+    }
+  }
+
+  ~LinkMonitor() { close(epollFd); }
+
+  void send(size_t orb, const char *text, size_t length) {
+    OrbLink &link = links[orb];
+    if (!writeAll(link.fd, text, length) || !Metrics::enabled) return;
+    link.unfoldedBytes += (uint32_t)length;
+    link.unfoldedCommands += (uint32_t)orbCommandCount(text, length);
+  }
+
+  // One pass: replies that have arrived, then probes that are due
+  void poll(int timeoutMs) {
+    epoll_event events[64];
+    int n = epoll_wait(epollFd, events, 64, timeoutMs);
+    int64_t now = monotonicUs();
+    for (int i = 0; i < n; i++) {
+      readReplies(events[i].data.u64, now);
+    }
+
+    for (size_t i = 0; i < links.size(); i++) {
+      OrbLink &link = links[i];
+      if (link.unfoldedBytes > 0) {
+        metrics[i].sent(link.unfoldedBytes, (int)link.unfoldedCommands);
+        link.unfoldedBytes = 0;
+        link.unfoldedCommands = 0;
+      }
+      if (link.probeSentUs >= 0) {
+        if (now - link.probeSentUs < replyTimeoutMs * 1000) continue;
+        if (link.probeAttempts < maxProbeAttempts) {
+          metrics[i].retried();
+          probe(i, now);
+          continue;
+        }
+        link.probeSentUs = -1; // orb is quiet; try again next interval
+      }
+      if (now >= link.nextProbeUs) {
+        link.probeAttempts = 0;
+        link.nextProbeUs += probeUs;
+        if (link.nextProbeUs < now) link.nextProbeUs = now + probeUs;
+        probe(i, now);
+      }
+    }
+  }
+
+private:
+  static bool writeAll(int fd, const char *data, size_t length) {
+    while (length > 0) {
+      ssize_t n = ::write(fd, data, length);
+      if (n <= 0) return false;
+      data += n;
+      length -= (size_t)n;
+    }
+    return true;
+  }
+
+  void probe(size_t orb, int64_t now) {
+    OrbLink &link = links[orb];
+    if (!writeAll(link.fd, &orbStatusQuery, 1)) return;
+    if (Metrics::enabled) link.unfoldedBytes++;
+    link.probeSentUs = now;
+    link.probeAttempts++;
+  }
+
+  // Anything that isn't a status reply is skipped
+  void readReplies(size_t orb, int64_t now) {
+    OrbLink &link = links[orb];
+    uint8_t buf[256];
+    ssize_t n = ::read(link.fd, buf, sizeof(buf));
+    for (ssize_t i = 0; i < n; i++) {
+      if (link.replyLength == 0 && buf[i] != 's') continue;
+      link.reply[link.replyLength++] = buf[i];
+      if (link.replyLength < orbStatusLength) continue;
+      link.replyLength = 0;
+
+      uint16_t commands = (uint16_t)(link.reply[1] | (link.reply[2] << 8));
+      uint16_t errors = (uint16_t)(link.reply[3] | (link.reply[4] << 8));
+      uint64_t latencyUs = link.probeSentUs >= 0 ? (uint64_t)(now - link.probeSentUs) : 0;
+      metrics[orb].status(commands, errors, now / 1000, latencyUs);
+      link.probeSentUs = -1;
+    }
+  }
+
+  std::vector<OrbLink> &links;
+  Metrics *metrics;
+  int64_t probeUs;
+  int epollFd;
+};
+
+// ---- Prometheus endpoint ----
+
+static void serveMetrics(int port, const std::vector<OrbLinkMetrics> &metrics) {
+  int server = socket(AF_INET, SOCK_STREAM, 0);
+  int yes = 1;
+  setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons((uint16_t)port);
+  if (bind(server, (sockaddr *)&addr, sizeof(addr)) < 0 || listen(server, 8) < 0) {
+    fprintf(stderr, "can't listen on 127.0.0.1:%d\n", port);
+    close(server);
+    return;
+  }
+  fprintf(stderr, "metrics on http://127.0.0.1:%d/metrics\n", port);
+
+  std::string body;
+  while (running) {
+    pollfd p = {server, POLLIN, 0};
+    if (::poll(&p, 1, 200) <= 0) continue;
+    int client = accept(server, nullptr, nullptr);
+    if (client < 0) continue;
+
+    char request[1024];
+    ssize_t n = recv(client, request, sizeof(request) - 1, 0);
+    request[n > 0 ? n : 0] = 0;
+    const char *status = "200 OK";
+    body.clear();
+    if (!strncmp(request, "GET /metrics", 12)) {
+      int64_t nowMs = monotonicUs() / 1000;
+      writePrometheus(metrics.data(), metrics.size(), nowMs, body);
+    } else {
+      status = "404 Not Found";
+    }
+    char head[160];
+    int headLength = snprintf(head, sizeof(head),
+                              "HTTP/1.0 %s\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                              "Content-Length: %zu\r\n\r\n",
+                              status, body.size());
+    send(client, head, (size_t)headLength, MSG_NOSIGNAL);
+    send(client, body.data(), body.size(), MSG_NOSIGNAL);
+    close(client);
+  }
+  close(server);
+}
+
+// ---- Simulated orbs ----
+
+// The ESP32 comms task's parsing on the far end of a socket pair. Orbs
+// with id % 100 == 7 get 2% of their bytes garbled; id % 250 == 3 never
+// answer.
+static void runSimOrbs(const std::vector<int> &fds, const std::vector<uint32_t> &ids) {
+  std::vector<OrbCommandParser> parsers(fds.size());
+  std::mt19937 rng(7);
+
+  // Drains every link every few ms like a UART buffer would, rather than
+  // waking on each write and bouncing the host thread off the CPU
+  while (running) {
+    for (size_t orb = 0; orb < fds.size(); orb++) {
+      char buf[4096];
+      ssize_t length = recv(fds[orb], buf, sizeof(buf), MSG_DONTWAIT);
+      bool lossy = ids[orb] % 100 == 7;
+      bool dead = ids[orb] % 250 == 3;
+      for (ssize_t i = 0; i < length; i++) {
+        if (dead) continue;
+        char c = lossy && rng() % 50 == 0 ? '\xff' : buf[i]; // line noise
+        OrbCommand out[2];
+        int count = parsers[orb].feed(c, out);
+        for (int j = 0; j < count; j++) {
+          if (out[j].kind != orbStatusQuery) continue;
+          uint8_t reply[orbStatusLength];
+          parsers[orb].status(reply);
+          if (::write(fds[orb], reply, sizeof(reply)) < 0) break;
+        }
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+}
+
+struct SimFleet {
+  std::vector<OrbLink> links;
+  std::vector<int> orbFds;
+  std::vector<uint32_t> orbIds;
+
+  explicit SimFleet(size_t count) {
+    for (size_t i = 0; i < count; i++) {
+      int pair[2];
+      if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) < 0) {
+        perror("socketpair");
+        exit(1);
+      }
+      OrbLink link = {};
+      link.orbId = (uint32_t)(i + 1);
+      link.fd = pair[0];
+      link.probeSentUs = -1;
+      links.push_back(link);
+      orbFds.push_back(pair[1]);
+      orbIds.push_back(link.orbId);
+    }
+  }
+
+  ~SimFleet() {
+    for (OrbLink &link : links) close(link.fd);
+    for (int fd : orbFds) close(fd);
+  }
+};
+
+// What the app and gateway send: a colour change (candles included),
+// sometimes a speed, and now and then a wave's phase and sync
+static size_t simCommand(std::mt19937 &rng, char *out) {
+  static const char modes[] = "OGRWC";
+  if (rng() % 16 == 0) {
+    return (size_t)snprintf(out, 16, "%c%u%c\n", orbPhase, (unsigned)(rng() % 510), orbSync);
+  }
+  if (rng() % 4 == 0) {
+    return (size_t)snprintf(out, 16, "%c%u\n", modes[rng() % 5], (unsigned)(5 + rng() % 40));
+  }
+  out[0] = modes[rng() % 5];
+  out[1] = '\n';
+  return 2;
+}
+
+// Fixed load on one link thread; returns its CPU time
+template <typename Metrics>
+static int64_t loadRun(SimFleet &fleet, Metrics *metrics, int rounds) {
+  LinkMonitor<Metrics> monitor(fleet.links, metrics, 50);
+  std::mt19937 rng(1);
+  char text[16];
+  int64_t start = threadCpuUs();
+  for (int round = 0; round < rounds; round++) {
+    for (size_t orb = 0; orb < fleet.links.size(); orb++) {
+      monitor.send(orb, text, simCommand(rng, text));
+    }
+    monitor.poll(1);
+  }
+  return threadCpuUs() - start;
+}
+
+// LinkMonitor's recording work on its own, no syscalls: the tally per
+// send, the fold per poll and a status reply per 16 sends (the probe rate
+// loadRun ends up with)
+static double recordingNsPerCommand(SimFleet &fleet, OrbLinkMetrics *metrics, int rounds) {
+  std::mt19937 rng(1);
+  std::vector<std::string> texts;
+  for (size_t i = 0; i < fleet.links.size(); i++) {
+    char text[16];
+    texts.emplace_back(text, simCommand(rng, text));
+  }
+
+  std::vector<OrbLink> &links = fleet.links;
+  int64_t start = threadCpuUs();
+  for (int round = 0; round < rounds; round++) {
+    for (size_t orb = 0; orb < links.size(); orb++) {
+      const std::string &text = texts[orb];
+      links[orb].unfoldedBytes += (uint32_t)text.size();
+      links[orb].unfoldedCommands += (uint32_t)orbCommandCount(text.data(), text.size());
+    }
+    for (size_t orb = 0; orb < links.size(); orb++) {
+      metrics[orb].sent(links[orb].unfoldedBytes, (int)links[orb].unfoldedCommands);
+      links[orb].unfoldedBytes = 0;
+      links[orb].unfoldedCommands = 0;
+    }
+    for (size_t orb = (size_t)round % 16; orb < links.size(); orb += 16) {
+      metrics[orb].status((uint16_t)round, 0, monotonicUs() / 1000, 500 + orb);
+    }
+  }
+  return (threadCpuUs() - start) * 1e3 / ((double)rounds * links.size());
+}
+
+// The simulated orbs share the box, so single runs swing by 10% or more
+// and even with/without pairs, alternating which goes first, only get the
+// difference to within a few percent. The recording work timed on its own
+// is the sharper number.
+static void runOverhead(size_t count) {
+  SimFleet fleet(count);
+  std::thread orbs(runSimOrbs, std::cref(fleet.orbFds), std::cref(fleet.orbIds));
+
+  const int rounds = 100;
+  const int pairs = 31;
+  std::vector<OrbLinkMetrics> metrics(count);
+  std::vector<NullLinkMetrics> none(count);
+
+  std::vector<double> overhead;
+  int64_t total[2] = {0, 0};
+  for (int pair = 0; pair < pairs; pair++) {
+    int64_t without, with;
+    if (pair % 2 == 0) {
+      without = loadRun(fleet, none.data(), rounds);
+      with = loadRun(fleet, metrics.data(), rounds);
+    } else {
+      with = loadRun(fleet, metrics.data(), rounds);
+      without = loadRun(fleet, none.data(), rounds);
+    }
+    overhead.push_back(100.0 * (with - without) / without);
+    total[0] += without;
+    total[1] += with;
+  }
+  running = false;
+  orbs.join();
+  double recordNs = recordingNsPerCommand(fleet, metrics.data(), rounds * pairs);
+
+  std::sort(overhead.begin(), overhead.end());
+  size_t commands = count * rounds * pairs;
+  double withUs = (double)total[1] / commands;
+  printf("%zu orbs, %zu commands each way, link thread CPU:\n", count, commands);
+  printf("  without metrics: %.2f us/command\n", (double)total[0] / commands);
+  printf("  with metrics:    %.2f us/command\n", withUs);
+  printf("  A/B overhead: median %.2f%% (middle half %.2f%% .. %.2f%%)\n", overhead[pairs / 2],
+         overhead[pairs / 4], overhead[pairs * 3 / 4]);
+  printf("  recording alone: %.1f ns/command = %.2f%% of link CPU\n", recordNs,
+         recordNs / (withUs * 10));
+}
+
+static void printSummary(const std::vector<OrbLinkMetrics> &metrics) {
+  uint64_t sent = 0, acked = 0, errors = 0, retries = 0;
+  size_t silent = 0;
+  int64_t nowMs = monotonicUs() / 1000;
+  for (const OrbLinkMetrics &m : metrics) {
+    sent += m.commands.get();
+    acked += m.commandsAcked.get();
+    errors += m.parseErrors.get();
+    retries += m.retries.get();
+    int64_t seen = m.lastSeenMs.load();
+    if (seen < 0 || nowMs - seen > 3 * probeIntervalMs) silent++;
+  }
+  printf("%zu orbs: %llu commands sent, %llu acked, %llu parse errors, %llu retries, %zu silent\n",
+         metrics.size(), (unsigned long long)sent, (unsigned long long)acked,
+         (unsigned long long)errors, (unsigned long long)retries, silent);
+  if (!metrics.empty()) {
+    const LatencyHistogram &h = *metrics[0].statusLatency;
+    printf("orb %u status round trip p50=%lluus p99=%lluus\n", metrics[0].orbId,
+           (unsigned long long)h.percentile(0.5), (unsigned long long)h.percentile(0.99));
+  }
+}
+
+static void runSim(size_t count, int seconds, int httpPort) {
+  SimFleet fleet(count);
+  std::vector<OrbLinkMetrics> metrics(count);
+  std::thread orbs(runSimOrbs, std::cref(fleet.orbFds), std::cref(fleet.orbIds));
+  std::thread http(serveMetrics, httpPort, std::cref(metrics));
+
+  // Every orb gets a command about every 2 s
+  LinkMonitor<OrbLinkMetrics> monitor(fleet.links, metrics.data(), probeIntervalMs);
+  std::mt19937 rng(1);
+  char text[16];
+  int64_t end = monotonicUs() + (int64_t)seconds * 1000000;
+  while (monotonicUs() < end) {
+    for (size_t i = 0; i < count / 200 + 1; i++) {
+      size_t orb = rng() % count;
+      monitor.send(orb, text, simCommand(rng, text));
+    }
+    monitor.poll(10);
+  }
+  // Let the last probes come back before reporting
+  for (int i = 0; i < 50; i++) monitor.poll(10);
+
+  running = false;
+  orbs.join();
+  http.join();
+  printSummary(metrics);
+}
+
+// ---- Real orbs ----
+
+struct LineCommand {
+  uint32_t orbId;
+  char text[30];
+};
+
+static SpscQueue<LineCommand, 1024> stdinCommands;
+
+static void readStdin() {
+  char line[256];
+  while (fgets(line, sizeof(line), stdin)) {
+    LineCommand cmd = {};
+    char *rest;
+    cmd.orbId = (uint32_t)strtoul(line, &rest, 10);
+    while (*rest == ' ') rest++;
+    rest[strcspn(rest, "\r\n")] = 0;
+    if (rest == line || !*rest) continue;
+    snprintf(cmd.text, sizeof(cmd.text), "%s\n", rest);
+    while (!stdinCommands.push(cmd)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+}
+
+static int openSerial(const char *path) {
+  int fd = ::open(path, O_RDWR | O_NOCTTY);
+  if (fd < 0) return -1;
+  termios tio;
+  tcgetattr(fd, &tio);
+  cfmakeraw(&tio);
+  cfsetispeed(&tio, B9600);
+  cfsetospeed(&tio, B9600);
+  tcsetattr(fd, TCSANOW, &tio);
+  return fd;
+}
+
+static int runPorts(std::vector<OrbLink> &links, int httpPort) {
+  std::map<uint32_t, size_t> byId;
+  for (size_t i = 0; i < links.size(); i++) byId[links[i].orbId] = i;
+
+  std::vector<OrbLinkMetrics> metrics(links.size());
+  LinkMonitor<OrbLinkMetrics> monitor(links, metrics.data(), probeIntervalMs);
+  std::thread http(serveMetrics, httpPort, std::cref(metrics));
+  std::thread input(readStdin);
+  input.detach();
+
+  for (;;) {
+    LineCommand cmd;
+    while (stdinCommands.pop(cmd)) {
+      auto it = byId.find(cmd.orbId);
+      if (it != byId.end()) monitor.send(it->second, cmd.text, strlen(cmd.text));
+    }
+    monitor.poll(10);
+  }
+}
+
+int main(int argc, char **argv) {
+  std::vector<OrbLink> links;
+  size_t simCount = 0;
+  int seconds = 10;
+  int httpPort = 9464;
+  bool overhead = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--port") && i + 1 < argc) {
+      char *spec = argv[++i];
+      char *path = strchr(spec, '=');
+      int fd = path ? openSerial(path + 1) : -1;
+      if (fd < 0) {
+        fprintf(stderr, "can't open %s (want ID=/dev/tty...)\n", spec);
+        return 1;
+      }
+      OrbLink link = {};
+      link.orbId = (uint32_t)strtoul(spec, nullptr, 10);
+      link.fd = fd;
+      link.probeSentUs = -1;
+      links.push_back(link);
+    } else if (!strcmp(argv[i], "--sim") && i + 1 < argc) {
+      simCount = (size_t)atol(argv[++i]);
+    } else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) {
+      seconds = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--http") && i + 1 < argc) {
+      httpPort = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--overhead")) {
+      overhead = true;
+    } else {
+      fprintf(stderr,
+              "usage: %s --port ID=/dev/tty... [--http PORT]\n"
+              "       %s --sim N [--seconds S] [--http PORT] [--overhead]\n",
+              argv[0], argv[0]);
+      return 1;
+    }
+  }
+
+  if (simCount > 0 && overhead) {
+    runOverhead(simCount);
+  } else if (simCount > 0) {
+    runSim(simCount, seconds, httpPort);
+  } else if (!links.empty()) {
+    return runPorts(links, httpPort);
+  } else {
+    fprintf(stderr, "nothing to monitor: give --port or --sim\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,247 @@
+// Fleet benchmark for the MQTT orb transport (src/OrbMqtt.h) against a
+// local Mosquitto broker. Each simulated orb is its own MQTT client running
+// the firmware's payload parser and coalescing mailbox; a render thread
+// sweeps the fleet every 20 ms like the orb's render core would.
+//
+//   g++ -std=c++17 -O2 -pthread mqtt_fleet_bench.cpp -o mqtt_fleet_bench -lmosquitto
+//   mosquitto -p 1883 &
+//   ./mqtt_fleet_bench [--orbs 1000] [--burst 10] [--rounds 20] [--host H] [--port P]
+//
+// The pulse speed in each payload doubles as a sequence number, so latency
+// is measured without changing the payload format.
+
+#include <mosquitto.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/OrbMqtt.h"
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchOptions {
+  int orbs = 1000;
+  int burst = 10;
+  int rounds = 20;
+  int groupSize = 50;
+  int reconnects = 100;
+  const char *host = "localhost";
+  int port = 1883;
+};
+
+struct SimOrb {
+  std::string id;
+  std::string group;
+  mosquitto *client = nullptr;
+  OrbTarget state = {0, -1, -1, 0, 0};
+  DoubleBuffer<OrbTarget> mailbox;
+  uint32_t seen = 0;
+  std::atomic<uint64_t> received{0};
+  uint64_t rendered = 0;
+  std::vector<long> latencyUs;
+  std::atomic<int64_t> reconnectStart{0};
+  std::atomic<int64_t> reconnectUs{-1};
+};
+
+static BenchOptions opt;
+static std::unique_ptr<std::atomic<int64_t>[]> sentAt;
+static size_t maxSeq = 0;
+
+static int64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch())
+      .count();
+}
+
+static void onConnect(mosquitto *client, void *userdata, int rc) {
+  if (rc != 0) return;
+  SimOrb *orb = static_cast<SimOrb *>(userdata);
+  char topic[64];
+  orbStateTopic(topic, sizeof(topic), orb->id.c_str());
+  mosquitto_subscribe(client, nullptr, topic, 0);
+  groupStateTopic(topic, sizeof(topic), orb->group.c_str());
+  mosquitto_subscribe(client, nullptr, topic, 0);
+}
+
+static void onMessage(mosquitto *, void *userdata, const mosquitto_message *msg) {
+  SimOrb *orb = static_cast<SimOrb *>(userdata);
+  int64_t now = nowNs();
+  if (!applyOrbPayload(static_cast<const char *>(msg->payload), msg->payloadlen, orb->state)) {
+    return;
+  }
+  orb->mailbox.publish(orb->state);
+  orb->received++;
+
+  size_t seq = (size_t)orb->state.pulseSpeed;
+  if (msg->retain) {
+    int64_t start = orb->reconnectStart.load();
+    if (start && orb->reconnectUs.load() < 0) orb->reconnectUs = (now - start) / 1000;
+  } else if (seq < maxSeq && sentAt[seq].load()) {
+    orb->latencyUs.push_back((now - sentAt[seq].load()) / 1000);
+  }
+}
+
+// orb is null for the controller, which only publishes
+static mosquitto *connectClient(const char *id, SimOrb *orb) {
+  mosquitto *client = mosquitto_new(id, true, orb);
+  if (!client) {
+    fprintf(stderr, "mosquitto_new failed for %s\n", id);
+    exit(1);
+  }
+  if (orb) {
+    mosquitto_connect_callback_set(client, onConnect);
+    mosquitto_message_callback_set(client, onMessage);
+  }
+  if (mosquitto_connect(client, opt.host, opt.port, 60) != MOSQ_ERR_SUCCESS) {
+    fprintf(stderr, "cannot reach broker at %s:%d\n", opt.host, opt.port);
+    exit(1);
+  }
+  mosquitto_loop_start(client);
+  return client;
+}
+
+static void printLatency(const char *label, std::vector<long> &us) {
+  if (us.empty()) {
+    printf("%s: no samples\n", label);
+    return;
+  }
+  std::sort(us.begin(), us.end());
+  size_t n = us.size();
+  printf("%s: n=%zu p50=%ldus p99=%ldus max=%ldus\n", label, n, us[n / 2], us[n * 99 / 100],
+         us[n - 1]);
+}
+
+int main(int argc, char **argv) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (!strcmp(argv[i], "--orbs")) opt.orbs = atoi(argv[i + 1]);
+    else if (!strcmp(argv[i], "--burst")) opt.burst = atoi(argv[i + 1]);
+    else if (!strcmp(argv[i], "--rounds")) opt.rounds = atoi(argv[i + 1]);
+    else if (!strcmp(argv[i], "--host")) opt.host = argv[i + 1];
+    else if (!strcmp(argv[i], "--port")) opt.port = atoi(argv[i + 1]);
+    else {
+      fprintf(stderr, "unknown option %s\n", argv[i]);
+      return 1;
+    }
+  }
+
+  int groups = (opt.orbs + opt.groupSize - 1) / opt.groupSize;
+  maxSeq = (size_t)opt.rounds * (opt.orbs * opt.burst + groups) + 1;
+  sentAt.reset(new std::atomic<int64_t>[maxSeq]);
+  for (size_t i = 0; i < maxSeq; i++) sentAt[i] = 0;
+
+  mosquitto_lib_init();
+
+  std::vector<std::unique_ptr<SimOrb>> fleet;
+  for (int i = 0; i < opt.orbs; i++) {
+    std::unique_ptr<SimOrb> orb(new SimOrb);
+    orb->id = "bench-orb-" + std::to_string(i);
+    orb->group = "bench-group-" + std::to_string(i / opt.groupSize);
+    orb->client = connectClient(orb->id.c_str(), orb.get());
+    fleet.push_back(std::move(orb));
+  }
+  mosquitto *publisher = connectClient("bench-controller", nullptr);
+  std::this_thread::sleep_for(std::chrono::seconds(2)); // let subscriptions land
+
+  std::atomic<bool> rendering{true};
+  std::thread render([&] {
+    while (rendering) {
+      for (auto &orb : fleet) {
+        if (orb->mailbox.version() != orb->seen) {
+          OrbTarget target;
+          orb->seen = orb->mailbox.read(target);
+          orb->rendered++;
+        }
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+  });
+
+  // Bursts to each orb's retained topic, then one broadcast per group
+  size_t seq = 1;
+  char topic[64];
+  char payload[16];
+  Clock::time_point start = Clock::now();
+  for (int round = 0; round < opt.rounds; round++) {
+    for (auto &orb : fleet) {
+      orbStateTopic(topic, sizeof(topic), orb->id.c_str());
+      for (int b = 0; b < opt.burst; b++) {
+        int len = snprintf(payload, sizeof(payload), "%c%zu", "OGRW"[b % 4], seq);
+        sentAt[seq] = nowNs();
+        mosquitto_publish(publisher, nullptr, topic, len, payload, 0, true);
+        seq++;
+      }
+    }
+    for (int g = 0; g < groups; g++) {
+      groupStateTopic(topic, sizeof(topic), ("bench-group-" + std::to_string(g)).c_str());
+      int len = snprintf(payload, sizeof(payload), "W%zu", seq);
+      sentAt[seq] = nowNs();
+      mosquitto_publish(publisher, nullptr, topic, len, payload, 0, false);
+      seq++;
+    }
+  }
+  double publishSecs = std::chrono::duration<double>(Clock::now() - start).count();
+
+  uint64_t expected = (uint64_t)opt.rounds * opt.orbs * (opt.burst + 1);
+  uint64_t delivered = 0;
+  for (int wait = 0; wait < 300; wait++) {
+    delivered = 0;
+    for (auto &orb : fleet) delivered += orb->received;
+    if (delivered >= expected) break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  double deliverSecs = std::chrono::duration<double>(Clock::now() - start).count();
+
+  // The last burst message is still retained per orb; bounce a slice of
+  // the fleet and time how long until that state is back
+  int bounced = std::min(opt.reconnects, opt.orbs);
+  for (int i = 0; i < bounced; i++) {
+    SimOrb &orb = *fleet[i];
+    mosquitto_disconnect(orb.client);
+    mosquitto_loop_stop(orb.client, false);
+    orb.reconnectStart = nowNs();
+    mosquitto_reconnect(orb.client);
+    mosquitto_loop_start(orb.client);
+  }
+  std::this_thread::sleep_for(std::chrono::seconds(2));
+
+  rendering = false;
+  render.join();
+
+  std::vector<long> latency, reconnect;
+  uint64_t rendered = 0;
+  for (auto &orb : fleet) {
+    latency.insert(latency.end(), orb->latencyUs.begin(), orb->latencyUs.end());
+    rendered += orb->rendered;
+  }
+  for (int i = 0; i < bounced; i++) {
+    if (fleet[i]->reconnectUs >= 0) reconnect.push_back(fleet[i]->reconnectUs);
+  }
+
+  printf("orbs=%d burst=%d rounds=%d\n", opt.orbs, opt.burst, opt.rounds);
+  printf("published %zu msgs in %.2fs (%.0f msg/s)\n", seq - 1, publishSecs,
+         (seq - 1) / publishSecs);
+  printf("delivered %llu/%llu in %.2fs (%.0f msg/s)\n", (unsigned long long)delivered,
+         (unsigned long long)expected, deliverSecs, delivered / deliverSecs);
+  printf("rendered %llu state changes (%.1f msgs coalesced per render)\n",
+         (unsigned long long)rendered, rendered ? (double)delivered / rendered : 0.0);
+  printLatency("publish->orb latency", latency);
+  printLatency("reconnect->retained state", reconnect);
+
+  for (auto &orb : fleet) {
+    mosquitto_disconnect(orb->client);
+    mosquitto_loop_stop(orb->client, true);
+    mosquitto_destroy(orb->client);
+  }
+  mosquitto_disconnect(publisher);
+  mosquitto_loop_stop(publisher, true);
+  mosquitto_destroy(publisher);
+  mosquitto_lib_cleanup();
+  return 0;
+}
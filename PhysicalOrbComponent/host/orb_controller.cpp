@@ -0,0 +1,489 @@
+// Heartbeating orb controller with a hot standby. Run two (or more) on the
+// same port and lock file: one holds the lock and drives the orb, sending
+// 'H' every orbHeartbeatMs (src/OrbProtocol.h); the rest wait on the lock
+// and take over when the primary dies or hangs.
+//
+//   g++ -std=c++17 -O2 -pthread orb_controller.cpp -o orb_controller
+//   ./orb_controller --port /dev/ttyACM0 [--lock /tmp/orb.lock] < commands
+//   ./orb_controller --sim [--kills N]
+//
+// The lock file is both the lock and the lease: the primary flock()s it
+// and writes its pid, last beat and the orb's mode/speed into it on every
+// beat. A dead primary's flock goes with it, so a standby sees it within
+// one poll. A hung one keeps the lock, so a standby that finds the lease
+// stale kills the holder before taking over; a primary that wakes up later
+// can't talk over the new one. The new primary resends the lease's mode
+// and speed so the orb carries on where it was, and so does a primary
+// whose orb answers again after going quiet long enough to have dropped
+// to the safe effect.
+//
+// Commands on stdin are passed through as they are ("G", "25", ...).
+// --sim runs an orb on a pty with the firmware's parser and OrbLiveness,
+// kills and freezes primaries, and reports how long failover takes and
+// whether the orb ever noticed.
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/file.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/OrbProtocol.h"
+
+const int64_t beatUs = (int64_t)orbHeartbeatMs * 1000;
+const int64_t staleLeaseUs = 3 * beatUs; // a beat short of the orb giving up
+const int standbyPollMs = 5;
+
+static int64_t monotonicUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static void sleepMs(int ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+
+// ---- Controller ----
+
+struct Lease {
+  int32_t pid;
+  int64_t beatUs; // steady clock, which is system-wide on Linux
+  char mode;      // 0 = nothing sent yet
+  int16_t speed;
+};
+
+static bool readLease(int fd, Lease &lease) {
+  return pread(fd, &lease, sizeof(lease), 0) == (ssize_t)sizeof(lease);
+}
+
+static void writeLease(int fd, const Lease &lease) {
+  if (pwrite(fd, &lease, sizeof(lease), 0) != (ssize_t)sizeof(lease)) perror("lease");
+}
+
+static int openSerial(const char *path) {
+  int fd = ::open(path, O_RDWR | O_NOCTTY | O_CLOEXEC);
+  if (fd < 0) return -1;
+  termios tio;
+  tcgetattr(fd, &tio);
+  cfmakeraw(&tio);
+  cfsetispeed(&tio, B9600);
+  cfsetospeed(&tio, B9600);
+  tcsetattr(fd, TCSANOW, &tio);
+  return fd;
+}
+
+static bool writeAll(int fd, const char *data, size_t length) {
+  while (length > 0) {
+    ssize_t n = ::write(fd, data, length);
+    if (n < 0) return false;
+    data += n;
+    length -= (size_t)n;
+  }
+  return true;
+}
+
+// Blocks as a standby until this process holds the lock
+static void waitForLease(int lockFd) {
+  while (flock(lockFd, LOCK_EX | LOCK_NB) < 0) {
+    Lease lease;
+    if (readLease(lockFd, lease) && lease.pid > 0 && lease.pid != getpid() &&
+        monotonicUs() - lease.beatUs > staleLeaseUs) {
+      fprintf(stderr, "controller %d: primary %d stopped beating, fencing it\n", getpid(),
+              lease.pid);
+      kill(lease.pid, SIGKILL);
+    }
+    sleepMs(standbyPollMs);
+  }
+}
+
+// reportFd, if set, gets the monotonic time of the takeover (for --sim)
+static int runController(const char *port, const char *lockPath, int reportFd) {
+  int lockFd = ::open(lockPath, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (lockFd < 0) {
+    perror(lockPath);
+    return 1;
+  }
+  waitForLease(lockFd);
+  int64_t tookOverUs = monotonicUs();
+
+  int fd = openSerial(port);
+  if (fd < 0) {
+    perror(port);
+    return 1;
+  }
+
+  Lease lease = {};
+  bool resumed = readLease(lockFd, lease) && lease.mode;
+  lease.pid = getpid();
+  lease.beatUs = tookOverUs;
+  if (!resumed) {
+    lease.mode = 0;
+    lease.speed = 20; // the sketch's default, until stdin sets one
+  }
+  writeLease(lockFd, lease);
+
+  // Beat first so the orb's count restarts, then put back what it was showing
+  char text[32];
+  int length = resumed ? snprintf(text, sizeof(text), "%c%c%d\n", orbHeartbeat, lease.mode,
+                                  lease.speed)
+                       : snprintf(text, sizeof(text), "%c", orbHeartbeat);
+  writeAll(fd, text, (size_t)length);
+  if (reportFd >= 0 && ::write(reportFd, &tookOverUs, sizeof(tookOverUs)) < 0) perror("report");
+  if (resumed) {
+    fprintf(stderr, "controller %d: primary, resuming %c%d\n", getpid(), lease.mode, lease.speed);
+  } else {
+    fprintf(stderr, "controller %d: primary\n", getpid());
+  }
+
+  OrbCommandParser parser; // tracks what stdin sets, for the lease
+  int64_t nextBeatUs = tookOverUs + beatUs;
+  int64_t lastReplyUs = tookOverUs;
+  bool orbSilent = false;
+  bool readStdin = true;
+
+  for (;;) {
+    pollfd fds[2] = {{fd, POLLIN, 0}, {readStdin ? 0 : -1, POLLIN, 0}};
+    int64_t waitUs = nextBeatUs - monotonicUs();
+    poll(fds, 2, waitUs > 0 ? (int)((waitUs + 999) / 1000) : 0);
+    int64_t now = monotonicUs();
+
+    if (fds[0].revents & POLLIN) {
+      char buf[64];
+      ssize_t n = ::read(fd, buf, sizeof(buf));
+      if (n > 0 && memchr(buf, orbHeartbeatReply, (size_t)n)) {
+        // Quiet for more than orbMissedBeats - 1 beats and the orb may
+        // have given up on us; resending what it should show is harmless
+        // if it hadn't
+        bool lapsed = orbSilent || now - lastReplyUs > (orbMissedBeats - 1) * beatUs;
+        lastReplyUs = now;
+        if (lapsed && lease.mode) {
+          int resend = snprintf(text, sizeof(text), "%c%d\n", lease.mode, lease.speed);
+          writeAll(fd, text, (size_t)resend);
+          fprintf(stderr, "controller %d: orb answering again, resending %c%d\n", getpid(),
+                  lease.mode, lease.speed);
+        } else if (orbSilent) {
+          fprintf(stderr, "controller %d: orb answering again\n", getpid());
+        }
+        orbSilent = false;
+      }
+    }
+
+    if (fds[1].revents & (POLLIN | POLLHUP)) {
+      char line[256];
+      ssize_t n = ::read(0, line, sizeof(line) - 1);
+      if (n <= 0) {
+        readStdin = false;
+      } else {
+        writeAll(fd, line, (size_t)n);
+        for (ssize_t i = 0; i < n; i++) {
+          OrbCommand out[2];
+          int count = parser.feed(line[i], out);
+          for (int j = 0; j < count; j++) {
+            if (out[j].kind == 'M') lease.mode = (char)out[j].value;
+            if (out[j].kind == 'S') lease.speed = (int16_t)out[j].value;
+          }
+        }
+        writeLease(lockFd, lease);
+      }
+    }
+
+    if (now >= nextBeatUs) {
+      char beat = orbHeartbeat;
+      writeAll(fd, &beat, 1);
+      lease.beatUs = now;
+      writeLease(lockFd, lease);
+      nextBeatUs += beatUs;
+      if (nextBeatUs < now) nextBeatUs = now + beatUs; // don't burst after a stall
+      if (!orbSilent && now - lastReplyUs > orbMissedBeats * beatUs) {
+        fprintf(stderr, "controller %d: orb not answering heartbeats\n", getpid());
+        orbSilent = true;
+      }
+    }
+  }
+}
+
+// ---- Simulation ----
+
+// The AVR sketch's side of the link on a pty master: firmware parser and
+// OrbLiveness, polled every ms like the loop() would
+struct SimOrb {
+  std::atomic<bool> running{true};
+  std::atomic<int64_t> lastBeatUs{-1};
+  std::atomic<int64_t> maxGapUs{0}; // longest time between beats; reset by the test
+  std::atomic<int64_t> safeUs{-1};  // when the orb fell back to the safe effect
+  std::atomic<char> mode{'W'};
+  std::atomic<int> speed{20};
+  std::atomic<int64_t> deafUntilUs{-1}; // the link drops everything until then
+
+  void run(int master) {
+    OrbCommandParser parser;
+    OrbLiveness liveness;
+    while (running) {
+      pollfd pfd = {master, POLLIN, 0};
+      if (poll(&pfd, 1, 1) > 0) {
+        char buf[256];
+        ssize_t n = ::read(master, buf, sizeof(buf));
+        if (monotonicUs() < deafUntilUs) n = 0;
+        for (ssize_t i = 0; i < n; i++) {
+          OrbCommand out[2];
+          int count = parser.feed(buf[i], out);
+          for (int j = 0; j < count; j++) apply(out[j], master, liveness);
+        }
+      }
+      if (liveness.lapsed((unsigned long)(monotonicUs() / 1000))) {
+        safeUs = monotonicUs();
+        mode = orbSafeMode;
+        speed = orbSafeSpeed;
+      }
+    }
+  }
+
+  void apply(const OrbCommand &cmd, int master, OrbLiveness &liveness) {
+    if (cmd.kind == orbHeartbeat) {
+      int64_t now = monotonicUs();
+      int64_t last = lastBeatUs.exchange(now);
+      if (last >= 0 && now - last > maxGapUs) maxGapUs = now - last;
+      liveness.beat((unsigned long)(now / 1000));
+      char reply = orbHeartbeatReply;
+      if (::write(master, &reply, 1) < 0) perror("orb");
+    } else if (cmd.kind == 'M') {
+      mode = (char)cmd.value;
+    } else if (cmd.kind == 'S') {
+      speed = cmd.value;
+    }
+  }
+};
+
+struct Controller {
+  pid_t pid;
+  int stdinFd;
+};
+
+// Runs this binary again as a controller, stdin on a pipe and takeover
+// reports on fd 3
+static Controller spawnController(const char *port, const char *lockPath, int reportFd) {
+  int in[2];
+  if (pipe2(in, O_CLOEXEC) < 0) {
+    perror("pipe");
+    exit(1);
+  }
+  pid_t pid = fork();
+  if (pid == 0) {
+    dup2(in[0], 0);
+    dup2(reportFd, 3);
+    execl("/proc/self/exe", "orb_controller", "--port", port, "--lock", lockPath, "--report",
+          "3", (char *)nullptr);
+    _exit(127);
+  }
+  close(in[0]);
+  return Controller{pid, in[1]};
+}
+
+static bool readReport(int reportFd, int64_t &us, int timeoutMs) {
+  pollfd pfd = {reportFd, POLLIN, 0};
+  return poll(&pfd, 1, timeoutMs) > 0 && ::read(reportFd, &us, sizeof(us)) == (ssize_t)sizeof(us);
+}
+
+static void stop(Controller &c) {
+  kill(c.pid, SIGKILL);
+  waitpid(c.pid, nullptr, 0);
+  close(c.stdinFd);
+}
+
+struct Failover {
+  double detectMs;  // primary gone -> standby holds the lock
+  double beatMs;    // primary gone -> orb hears the new primary
+  double gapMs;     // longest silence the orb saw
+  bool safe;        // orb fell back to the safe effect
+  bool carriedOver; // orb still showing what the old primary set
+};
+
+// Sets a random colour through the primary, then kills or freezes it
+static bool failover(SimOrb &orb, Controller &primary, int reportFd, int signal, std::mt19937 &rng,
+                     Failover &result) {
+  static const char modes[] = "OGR";
+  char mode = modes[rng() % 3];
+  int speed = 5 + (int)(rng() % 40);
+  char text[16];
+  int length = snprintf(text, sizeof(text), "%c%d\n", mode, speed);
+  writeAll(primary.stdinFd, text, (size_t)length);
+  sleepMs(100 + (int)(rng() % orbHeartbeatMs)); // land anywhere in the beat cycle
+
+  orb.maxGapUs = 0;
+  orb.safeUs = -1;
+  int64_t killedUs = monotonicUs();
+  kill(primary.pid, signal);
+
+  int64_t tookOverUs;
+  if (!readReport(reportFd, tookOverUs, 5000)) return false;
+  while (orb.lastBeatUs < tookOverUs) sleepMs(1);
+  int64_t heardUs = orb.lastBeatUs;
+  sleepMs(50); // let the resent mode land
+
+  stop(primary);
+  result.detectMs = (tookOverUs - killedUs) / 1000.0;
+  result.beatMs = (heardUs - killedUs) / 1000.0;
+  result.gapMs = orb.maxGapUs / 1000.0;
+  result.safe = orb.safeUs >= 0;
+  result.carriedOver = orb.mode == mode && orb.speed == speed;
+  return true;
+}
+
+static void printFailovers(const char *label, std::vector<Failover> &runs) {
+  auto summary = [&](const char *name, double Failover::*field) {
+    std::vector<double> v;
+    for (const Failover &f : runs) v.push_back(f.*field);
+    std::sort(v.begin(), v.end());
+    printf("  %-28s p50 %7.1f ms   max %7.1f ms\n", name, v[v.size() / 2], v.back());
+  };
+  size_t safe = 0, carried = 0;
+  for (const Failover &f : runs) {
+    safe += f.safe;
+    carried += f.carriedOver;
+  }
+  printf("%s (%zu runs)\n", label, runs.size());
+  summary("standby holds the lock", &Failover::detectMs);
+  summary("orb hears the new primary", &Failover::beatMs);
+  summary("longest gap between beats", &Failover::gapMs);
+  printf("  orb fell back to safe effect %zu/%zu, colour carried over %zu/%zu\n\n", safe,
+         runs.size(), carried, runs.size());
+}
+
+static int runSim(int kills) {
+  int master = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+  if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0) {
+    perror("pty");
+    return 1;
+  }
+  std::string port = ptsname(master);
+  // Held open so the master doesn't see a hangup between controllers
+  int slave = openSerial(port.c_str());
+  char lockPath[] = "/tmp/orb_controller_XXXXXX";
+  int lockFd = mkstemp(lockPath);
+  close(lockFd);
+
+  int report[2];
+  if (pipe2(report, O_CLOEXEC) < 0) {
+    perror("pipe");
+    return 1;
+  }
+
+  SimOrb orb;
+  std::thread orbThread([&] { orb.run(master); });
+  std::mt19937 rng(1);
+  printf("heartbeat every %lu ms, orb gives up after %d missed, standby fences after %lld ms\n\n",
+         orbHeartbeatMs, orbMissedBeats, (long long)(staleLeaseUs / 1000));
+
+  int64_t us;
+  Controller primary = spawnController(port.c_str(), lockPath, report[1]);
+  readReport(report[0], us, 5000);
+
+  std::vector<Failover> killed, hung;
+  for (int i = 0; i < 2 * kills; i++) {
+    Controller standby = spawnController(port.c_str(), lockPath, report[1]);
+    sleepMs(200);
+    Failover result;
+    bool hang = i % 2 == 1;
+    if (!failover(orb, primary, report[0], hang ? SIGSTOP : SIGKILL, rng, result)) {
+      fprintf(stderr, "standby never took over\n");
+      stop(standby);
+      break;
+    }
+    (hang ? hung : killed).push_back(result);
+    primary = standby;
+  }
+  if (!killed.empty()) printFailovers("primary killed (SIGKILL)", killed);
+  if (!hung.empty()) printFailovers("primary hung (SIGSTOP), standby fences it", hung);
+
+  // The primary stays up but the link drops out for longer than the orb
+  // waits: it falls back, and gets its colour back when the link returns
+  int lapses = 5, fellBack = 0, restored = 0;
+  for (int i = 0; i < lapses; i++) {
+    static const char modes[] = "OGR";
+    char mode = modes[rng() % 3];
+    int speed = 5 + (int)(rng() % 40);
+    char text[16];
+    int length = snprintf(text, sizeof(text), "%c%d\n", mode, speed);
+    writeAll(primary.stdinFd, text, (size_t)length);
+    sleepMs(100 + (int)(rng() % orbHeartbeatMs));
+    orb.safeUs = -1;
+    int64_t lapseMs = orbHeartbeatMs * (orbMissedBeats + 2);
+    orb.deafUntilUs = monotonicUs() + lapseMs * 1000;
+    sleepMs((int)lapseMs + 3 * (int)orbHeartbeatMs);
+    fellBack += orb.safeUs >= 0;
+    restored += orb.mode == mode && orb.speed == speed;
+  }
+  printf("link down %lu ms, primary up: orb fell back %d/%d, colour restored %d/%d\n\n",
+         orbHeartbeatMs * (orbMissedBeats + 2), fellBack, lapses, restored, lapses);
+
+  // No standby: the orb is on its own
+  std::vector<double> safeMs;
+  for (int i = 0; i < 5; i++) {
+    sleepMs(100 + (int)(rng() % orbHeartbeatMs));
+    orb.safeUs = -1;
+    int64_t killedUs = monotonicUs();
+    stop(primary);
+    while (orb.safeUs < 0) sleepMs(1);
+    safeMs.push_back((orb.safeUs - killedUs) / 1000.0);
+    if (orb.mode != orbSafeMode) fprintf(stderr, "orb not in the safe effect\n");
+    primary = spawnController(port.c_str(), lockPath, report[1]);
+    readReport(report[0], us, 5000);
+  }
+  std::sort(safeMs.begin(), safeMs.end());
+  printf("no standby: primary killed -> orb safe effect  min %.0f ms  max %.0f ms\n", safeMs[0],
+         safeMs.back());
+
+  stop(primary);
+  orb.running = false;
+  orbThread.join();
+  close(slave);
+  close(master);
+  unlink(lockPath);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  const char *port = nullptr;
+  const char *lockPath = "/tmp/orb_controller.lock";
+  int reportFd = -1;
+  bool sim = false;
+  int kills = 20;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--port") && i + 1 < argc) {
+      port = argv[++i];
+    } else if (!strcmp(argv[i], "--lock") && i + 1 < argc) {
+      lockPath = argv[++i];
+    } else if (!strcmp(argv[i], "--report") && i + 1 < argc) {
+      reportFd = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--sim")) {
+      sim = true;
+    } else if (!strcmp(argv[i], "--kills") && i + 1 < argc) {
+      kills = atoi(argv[++i]);
+    } else {
+      port = nullptr;
+      sim = false;
+      break;
+    }
+  }
+
+  if (sim) return runSim(kills);
+  if (port) return runController(port, lockPath, reportFd);
+  fprintf(stderr,
+          "usage: %s --port /dev/tty... [--lock FILE] < commands\n"
+          "       %s --sim [--kills N]\n",
+          argv[0], argv[0]);
+  return 1;
+}
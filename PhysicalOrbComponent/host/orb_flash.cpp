@@ -0,0 +1,444 @@
+// Host side of the Serial1 firmware update (src/OrbUpdate.h). Reads the
+// orb's block CRC table, sends only the blocks that differ from the new
+// image, then asks the orb to verify and switch over. Once it has rebooted
+// the table is read again, and the update only counts if every block of
+// the new image is what's running.
+//
+//   g++ -std=c++17 -O2 orb_flash.cpp -o orb_flash
+//   ./orb_flash --port /dev/ttyACM0 --new firmware.bin    real orb at 9600 baud
+//   ./orb_flash --sim [--old old.bin] [--new new.bin]     host build of the orb
+//
+// --sim runs the orb's receiver in-process against an in-memory flash and
+// prices the transfer at 9600 baud plus AVR page write time, next to what
+// sending the whole image would cost. Without images it makes up a 12 KB
+// one and tries an in-place patch and a small insertion. The simulated
+// orb reboots through orbApplyStaged(), once with the power cut part way
+// through the copy, once after an aborted update left blocks staged, and
+// once more as an orb whose bootloader has no copy step, which must refuse
+// with 'X'.
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/OrbUpdate.h"
+
+const double linkBaud = 9600;
+const double pageWriteMs = 4.5; // AVR page erase + write
+
+// ---- Links ----
+
+// In-process wire between the host tool and the simulated orb
+struct SimWire {
+  std::deque<uint8_t> toOrb, toHost;
+  uint64_t bytesToOrb = 0, bytesToHost = 0;
+};
+
+struct SimOrbLink {
+  SimWire &wire;
+  size_t readBytes(char *out, size_t length) {
+    size_t n = 0;
+    while (n < length && !wire.toOrb.empty()) {
+      out[n++] = (char)wire.toOrb.front();
+      wire.toOrb.pop_front();
+    }
+    return n;
+  }
+  size_t write(const uint8_t *data, size_t length) {
+    wire.toHost.insert(wire.toHost.end(), data, data + length);
+    wire.bytesToHost += length;
+    return length;
+  }
+  void flush() {}
+};
+
+// What the orb's flash and EEPROM look like, for both the sketch's and
+// the bootloader's side
+template <uint16_t BlockSize>
+struct MemoryStorage {
+  std::vector<uint8_t> running, staging;
+  std::vector<bool> staged;
+  uint64_t pageWrites = 0;
+  bool bootCopy = true;     // the bootloader has the copy step
+  bool marker = false;      // the EEPROM commit marker
+  int powerCutAfter = -1;   // running-image writes before the power goes
+
+  explicit MemoryStorage(uint16_t blocks)
+      : running(blocks * BlockSize, 0xFF), staging(blocks * BlockSize, 0xFF), staged(blocks) {}
+
+  uint16_t blockCount() const { return (uint16_t)staged.size(); }
+  void readRunning(uint16_t b, uint8_t *out) { memcpy(out, &running[b * BlockSize], BlockSize); }
+  void readStaged(uint16_t b, uint8_t *out) { memcpy(out, &staging[b * BlockSize], BlockSize); }
+  bool isStaged(uint16_t b) { return staged[b]; }
+  bool writeStaged(uint16_t b, const uint8_t *data) {
+    memcpy(&staging[b * BlockSize], data, BlockSize);
+    staged[b] = true;
+    pageWrites++;
+    return true;
+  }
+  void clearStaged() { staged.assign(staged.size(), false); }
+  bool canApply() { return bootCopy; }
+  void commit() { marker = true; }
+
+  bool commitPending() { return marker; }
+  bool writeRunning(uint16_t b, const uint8_t *data) {
+    if (powerCutAfter == 0) return false;
+    if (powerCutAfter > 0) powerCutAfter--;
+    memcpy(&running[b * BlockSize], data, BlockSize);
+    pageWrites++;
+    return true;
+  }
+  void clearCommit() { marker = false; }
+};
+
+const uint16_t simBlockSize = 128; // ATmega32U4 page
+const uint16_t simBlocks = 112;    // 14 KB staging half of a 32U4
+
+struct SimOrb {
+  SimWire wire;
+  SimOrbLink link{wire};
+  MemoryStorage<simBlockSize> storage{simBlocks};
+  OrbUpdateReceiver<SimOrbLink, MemoryStorage<simBlockSize>, simBlockSize> receiver{link, storage};
+
+  int boots = 0;
+
+  // Stands in for the sketch's loop(): hand each 'U' request to the receiver
+  void pump() {
+    while (!wire.toOrb.empty()) {
+      uint8_t c = wire.toOrb.front();
+      wire.toOrb.pop_front();
+      if (c == 'U') receiver.handle();
+      if (storage.marker) boot();
+    }
+  }
+
+  // commit() reset the orb; the bootloader copies until it finishes, however
+  // many resets that takes
+  void boot() {
+    do {
+      boots++;
+      orbApplyStaged<MemoryStorage<simBlockSize>, simBlockSize>(storage);
+      storage.powerCutAfter = -1;
+    } while (storage.marker);
+  }
+};
+
+// Host end of the in-process wire
+struct SimHostLink {
+  SimOrb &orb;
+  bool write(const uint8_t *data, size_t length) {
+    orb.wire.toOrb.insert(orb.wire.toOrb.end(), data, data + length);
+    orb.wire.bytesToOrb += length;
+    orb.pump();
+    return true;
+  }
+  void settle() {}
+  bool read(uint8_t *out, size_t length) {
+    if (orb.wire.toHost.size() < length) return false;
+    for (size_t i = 0; i < length; i++) {
+      out[i] = orb.wire.toHost.front();
+      orb.wire.toHost.pop_front();
+    }
+    return true;
+  }
+};
+
+// Real orb on a serial port
+struct SerialHostLink {
+  int fd = -1;
+
+  bool open(const char *path) {
+    fd = ::open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0) return false;
+    termios tio;
+    tcgetattr(fd, &tio);
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, B9600);
+    cfsetospeed(&tio, B9600);
+    tcsetattr(fd, TCSANOW, &tio);
+    return true;
+  }
+
+  bool write(const uint8_t *data, size_t length) {
+    while (length > 0) {
+      ssize_t n = ::write(fd, data, length);
+      if (n <= 0) return false;
+      data += n;
+      length -= n;
+    }
+    return true;
+  }
+
+  // The orb is resetting: let it boot, then drop whatever it said meanwhile
+  void settle() {
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    tcflush(fd, TCIOFLUSH);
+  }
+
+  // Same 1 s patience as the orb's Stream timeout, per chunk
+  bool read(uint8_t *out, size_t length) {
+    while (length > 0) {
+      pollfd p = {fd, POLLIN, 0};
+      if (poll(&p, 1, 1000) <= 0) return false;
+      ssize_t n = ::read(fd, out, length);
+      if (n <= 0) return false;
+      out += n;
+      length -= n;
+    }
+    return true;
+  }
+};
+
+// ---- Update client ----
+
+static void putU16(std::vector<uint8_t> &out, uint16_t v) {
+  out.push_back((uint8_t)(v & 0xff));
+  out.push_back((uint8_t)(v >> 8));
+}
+
+struct UpdateResult {
+  bool ok = false;
+  bool unsupported = false; // the orb answered 'X'
+  uint16_t blocksSent = 0;
+  uint16_t blockCount = 0;
+};
+
+template <typename Link>
+class FlashClient {
+public:
+  explicit FlashClient(Link &link) : link(link) {}
+
+  bool query(uint16_t &blockSize, std::vector<uint16_t> &crcs) {
+    const uint8_t request[2] = {'U', 'Q'};
+    uint8_t head[6];
+    if (!link.write(request, 2) || !link.read(head, 6) || head[0] != 'u' || head[1] != 'Q') {
+      return false;
+    }
+    blockSize = (uint16_t)(head[2] | (head[3] << 8));
+    uint16_t count = (uint16_t)(head[4] | (head[5] << 8));
+    std::vector<uint8_t> raw(count * 2);
+    if (!link.read(raw.data(), raw.size())) return false;
+    crcs.resize(count);
+    for (uint16_t b = 0; b < count; b++) crcs[b] = (uint16_t)(raw[2 * b] | (raw[2 * b + 1] << 8));
+    return true;
+  }
+
+  bool sendBlock(uint16_t block, const uint8_t *data, uint16_t blockSize) {
+    std::vector<uint8_t> packet = {'U', 'B'};
+    putU16(packet, block);
+    packet.insert(packet.end(), data, data + blockSize);
+    putU16(packet, orbCrc16(data, blockSize));
+    for (int attempt = 0; attempt < 3; attempt++) {
+      uint8_t ack[4];
+      if (link.write(packet.data(), packet.size()) && link.read(ack, 4) && ack[1] == 'K') {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // 'K', 'N' or 'X', or 0 if the orb didn't answer
+  uint8_t apply(uint16_t count, uint32_t crc) {
+    std::vector<uint8_t> packet = {'U', 'A'};
+    putU16(packet, count);
+    for (int i = 0; i < 4; i++) packet.push_back((uint8_t)(crc >> (8 * i)));
+    uint8_t ack[4];
+    if (!link.write(packet.data(), packet.size()) || !link.read(ack, 4)) return 0;
+    return ack[1];
+  }
+
+  // After 'K' the orb resets and its bootloader copies the image in; ask
+  // again until it answers, and check every block
+  bool confirm(const std::vector<uint8_t> &image, uint16_t blockSize) {
+    for (int attempt = 0; attempt < 5; attempt++) {
+      uint16_t size;
+      std::vector<uint16_t> crcs;
+      if (query(size, crcs) && size == blockSize && crcs.size() * blockSize >= image.size()) {
+        for (size_t b = 0; b * blockSize < image.size(); b++) {
+          if (crcs[b] != orbCrc16(&image[b * blockSize], blockSize)) return false;
+        }
+        return true;
+      }
+      link.settle();
+    }
+    return false;
+  }
+
+  // full = send every block regardless of what the orb already has
+  UpdateResult update(std::vector<uint8_t> image, bool full) {
+    UpdateResult result;
+    uint16_t blockSize;
+    std::vector<uint16_t> crcs;
+    if (!query(blockSize, crcs)) return result;
+
+    image.resize((image.size() + blockSize - 1) / blockSize * blockSize, 0xFF);
+    uint16_t count = (uint16_t)(image.size() / blockSize);
+    if (count > crcs.size()) {
+      fprintf(stderr, "image is %u blocks, orb has room for %zu\n", count, crcs.size());
+      return result;
+    }
+    result.blockCount = count;
+    uint32_t imageCrc = orbCrc32(image.data(), image.size(), 0xFFFFFFFFUL) ^ 0xFFFFFFFFUL;
+
+    std::vector<bool> sent(count);
+    for (uint16_t b = 0; b < count; b++) {
+      const uint8_t *data = &image[b * blockSize];
+      if (full || orbCrc16(data, blockSize) != crcs[b]) {
+        if (!sendBlock(b, data, blockSize)) return result;
+        sent[b] = true;
+        result.blocksSent++;
+      }
+    }
+
+    uint8_t status = apply(count, imageCrc);
+    if (status == 'N') {
+      // A CRC-16 collision hid a changed block; the orb dropped the staging,
+      // so fall back to the whole image
+      for (uint16_t b = 0; b < count; b++) {
+        if (!sendBlock(b, &image[b * blockSize], blockSize)) return result;
+        result.blocksSent++;
+      }
+      status = apply(count, imageCrc);
+    }
+    result.unsupported = status == 'X';
+    result.ok = status == 'K' && confirm(image, blockSize);
+    return result;
+  }
+
+private:
+  Link &link;
+};
+
+// ---- Simulation ----
+
+static std::vector<uint8_t> readFile(const char *path) {
+  std::vector<uint8_t> data;
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    fprintf(stderr, "cannot open %s\n", path);
+    exit(1);
+  }
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data.insert(data.end(), buf, buf + n);
+  fclose(f);
+  return data;
+}
+
+enum class SimBoot { copies, powerCut, leftovers, noCopy };
+
+static void simulate(const char *label, const std::vector<uint8_t> &oldImage,
+                     const std::vector<uint8_t> &newImage, SimBoot boot = SimBoot::copies) {
+  for (int full = 1; full >= 0; full--) {
+    SimOrb orb;
+    std::copy(oldImage.begin(), oldImage.end(), orb.storage.running.begin());
+    orb.storage.bootCopy = boot != SimBoot::noCopy;
+    if (boot == SimBoot::powerCut) orb.storage.powerCutAfter = 1;
+    // An earlier update that never reached 'A': one block inside the new
+    // image and one past it, neither of them what the host will send
+    std::vector<uint8_t> junk(simBlockSize, 0x00);
+    uint16_t pastImage = simBlocks - 1;
+    if (boot == SimBoot::leftovers) {
+      orb.storage.writeStaged(1, junk.data());
+      orb.storage.writeStaged(pastImage, junk.data());
+      orb.storage.pageWrites = 0;
+    }
+    SimHostLink link{orb};
+    FlashClient<SimHostLink> client(link);
+    UpdateResult r = client.update(newImage, full);
+
+    bool matches = std::equal(newImage.begin(), newImage.end(), orb.storage.running.begin());
+    bool untouched = std::equal(oldImage.begin(), oldImage.end(), orb.storage.running.begin());
+    const uint8_t *tail = &orb.storage.running[pastImage * simBlockSize];
+    matches = matches && std::none_of(tail, tail + simBlockSize, [](uint8_t b) { return b == 0; });
+    const char *outcome;
+    if (boot == SimBoot::noCopy) {
+      outcome = r.unsupported && !r.ok && untouched ? "refused, old image kept" : "FAILED";
+    } else {
+      outcome = r.ok && matches ? "confirmed" : "FAILED";
+    }
+    uint64_t bytes = orb.wire.bytesToOrb + orb.wire.bytesToHost;
+    double seconds = bytes * 10.0 / linkBaud + orb.storage.pageWrites * pageWriteMs / 1000.0;
+    printf("%-16s %-4s %3u/%3u blocks, %6llu link bytes, %3llu page writes, %d boots, %6.2f s %s\n",
+           label, full ? "full" : "diff", r.blocksSent, r.blockCount, (unsigned long long)bytes,
+           (unsigned long long)orb.storage.pageWrites, orb.boots, seconds, outcome);
+  }
+}
+
+int main(int argc, char **argv) {
+  const char *port = nullptr;
+  const char *oldPath = nullptr;
+  const char *newPath = nullptr;
+  bool sim = false;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--sim")) sim = true;
+    else if (!strcmp(argv[i], "--port") && i + 1 < argc) port = argv[++i];
+    else if (!strcmp(argv[i], "--old") && i + 1 < argc) oldPath = argv[++i];
+    else if (!strcmp(argv[i], "--new") && i + 1 < argc) newPath = argv[++i];
+    else {
+      fprintf(stderr, "usage: %s --port DEV --new IMG | --sim [--old IMG] [--new IMG]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  if (port) {
+    if (!newPath) {
+      fprintf(stderr, "--port needs --new\n");
+      return 1;
+    }
+    SerialHostLink link;
+    if (!link.open(port)) {
+      perror(port);
+      return 1;
+    }
+    FlashClient<SerialHostLink> client(link);
+    UpdateResult r = client.update(readFile(newPath), false);
+    if (r.unsupported) {
+      fprintf(stderr, "the orb's bootloader can't apply updates (see src/OrbUpdate.h)\n");
+      return 1;
+    }
+    printf("%s: sent %u of %u blocks\n", r.ok ? "updated and confirmed" : "update failed",
+           r.blocksSent, r.blockCount);
+    return r.ok ? 0 : 1;
+  }
+
+  if (!sim) {
+    fprintf(stderr, "nothing to do; pass --port or --sim\n");
+    return 1;
+  }
+
+  if (oldPath && newPath) {
+    simulate("given images", readFile(oldPath), readFile(newPath));
+    return 0;
+  }
+
+  std::mt19937 rng(3);
+  std::vector<uint8_t> base(12000);
+  for (auto &b : base) b = (uint8_t)rng();
+
+  std::vector<uint8_t> patched = base;
+  for (int i = 0; i < 64; i++) patched[6000 + i] ^= 0x5A;
+
+  std::vector<uint8_t> shifted = base;
+  shifted.insert(shifted.begin() + 6000, 16, 0x00);
+
+  simulate("in-place patch", base, patched);
+  simulate("16-byte insert", base, shifted);
+  simulate("power cut", base, shifted, SimBoot::powerCut);
+  simulate("stale staging", base, patched, SimBoot::leftovers);
+  simulate("no copy step", base, patched, SimBoot::noCopy);
+  return 0;
+}
@@ -0,0 +1,114 @@
+// Live pulse rendering against OrbPeriodCache (src/OrbCore.h) at each
+// SRAM budget: how far the cached frames are from live, what the cache
+// costs in RAM, and what a tick costs either way.
+//
+//   g++ -std=c++11 -O2 period_cache_sim.cpp -o period_cache_sim
+//   ./period_cache_sim [--ticks N]
+//
+// Tick cost is host time. On AVR the live path is three 8x8 multiplies and
+// orbDiv255s per tick (src/OrbFixed.h), which the cache replaces with one
+// table read.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "../src/OrbCore.h"
+
+using Clock = std::chrono::steady_clock;
+
+static const char modes[] = {'O', 'G', 'R', 'W'};
+
+// Largest difference on any pin over two full periods of every mode,
+// including a mode change halfway through the second
+template <unsigned Bytes>
+static int maxError() {
+  OrbPeriodCache<Bytes> cache;
+  int worst = 0;
+  for (char mode : modes) {
+    OrbRenderState live, cached;
+    live.apply({'M', mode});
+    cached.apply({'M', mode});
+    for (int i = 0; i < 2 * pulseSteps; i++) {
+      if (i == pulseSteps + pulseSteps / 2) {
+        live.apply({'M', 'O'});
+        cached.apply({'M', 'O'});
+      }
+      OrbFrame a = live.step();
+      OrbFrame b = cached.step(cache);
+      if (a.brightness != b.brightness || a.tick != b.tick) return 255;
+      worst = std::max(worst, std::abs(a.red - b.red));
+      worst = std::max(worst, std::abs(a.green - b.green));
+      worst = std::max(worst, std::abs(a.blue - b.blue));
+    }
+  }
+  return worst;
+}
+
+// ns per tick, with a mode change every 64 periods (about 20 s at the
+// default speed) so rebuilds are in the average
+template <typename Step>
+static double tickNs(long ticks, Step step) {
+  OrbRenderState state;
+  unsigned sum = 0;
+  const long periodsPerMode = 64;
+  Clock::time_point start = Clock::now();
+  for (long i = 0; i < ticks; i++) {
+    long period = i / pulseSteps;
+    if (i % pulseSteps == 0 && period % periodsPerMode == 0) {
+      state.apply({'M', modes[(period / periodsPerMode) % 4]});
+    }
+    OrbFrame frame = step(state);
+    sum += frame.red + frame.green + frame.blue;
+  }
+  double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ticks;
+  if (sum == 1) printf(" "); // keep the frames alive
+  return ns;
+}
+
+template <unsigned Bytes>
+static double buildNs() {
+  OrbPeriodCache<Bytes> cache;
+  if (!cache.enabled()) return 0;
+  const int builds = 100000;
+  unsigned sum = 0;
+  Clock::time_point start = Clock::now();
+  for (int i = 0; i < builds; i++) {
+    cache.build(modes[i % 4]);
+    sum += cache.at(i & 255).green;
+  }
+  double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / builds;
+  if (sum == 1) printf(" ");
+  return ns;
+}
+
+template <unsigned Bytes>
+static void report(long ticks, double liveNs) {
+  OrbPeriodCache<Bytes> cache;
+  double ns = tickNs(ticks, [&](OrbRenderState &s) { return s.step(cache); });
+  printf("%6u  %6d  %7zu  %7d  %7.1f  %5.2fx  %8.0f\n", Bytes, cache.levels, sizeof(cache),
+         maxError<Bytes>(), ns, liveNs / ns, buildNs<Bytes>());
+}
+
+int main(int argc, char **argv) {
+  long ticks = 50000000;
+  if (argc == 3 && !strcmp(argv[1], "--ticks")) {
+    ticks = atol(argv[2]);
+  } else if (argc != 1) {
+    fprintf(stderr, "usage: %s [--ticks N]\n", argv[0]);
+    return 1;
+  }
+
+  double liveNs = tickNs(ticks, [](OrbRenderState &s) { return s.step(); });
+  printf("live: %.1f ns/tick, no table (OrbRenderState is %zu bytes either way)\n\n", liveNs,
+         sizeof(OrbRenderState));
+  printf("budget  levels  RAM (B)  max err  ns/tick  speedup  build ns\n");
+  report<768>(ticks, liveNs);
+  report<384>(ticks, liveNs);
+  report<192>(ticks, liveNs);
+  report<96>(ticks, liveNs);
+  report<64>(ticks, liveNs);
+  return 0;
+}
@@ -0,0 +1,302 @@
+// Polygon event boundaries (LoyaltyLand/modules/geofence/cpp/
+// PolygonFences.h): the per-polygon grid against the plain ray cast, on a
+// made-up town of polygon fences and a day's worth of location fixes.
+//
+//   g++ -std=c++17 -O2 polygon_fence_bench.cpp -o polygon_fence_bench
+//   ./polygon_fence_bench [--polygons 10000] [--points 1000000] [--cells N] [--seed N]
+//
+// The town is about 16 km across:
+//   storefronts   60%  rotated rectangles and L shapes, 8-30 m, 4-6 vertices
+//   sections      30%  stadium and arena sections, annular sectors 20-120 m
+//                      with 8-32 vertices per arc
+//   venues        10%  parks and festival grounds, ragged concave outlines
+//                      100-800 m across with 64-1024 vertices
+// Half the points fall near a fence, 45% anywhere in town, and 5% exactly
+// on a vertex or the midpoint of an edge, where the two are most likely
+// to disagree.
+//
+// Both sides share FenceIndex's grid of bounding boxes, so they ray-cast
+// the same candidates; the plain one runs rayCastContains over the whole
+// ring. Every answer is compared. "every fence" is the ray cast over all
+// polygons with no index at all, timed on a sample of points and scaled.
+// --cells fixes the grid per polygon (0, the default, sizes it from the
+// vertex count). Before the town, degenerate rings (too few corners, no
+// area, NaN) are checked to be rejected and kept out of the index.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "../../LoyaltyLand/modules/geofence/cpp/PolygonFences.h"
+
+using Clock = std::chrono::steady_clock;
+
+static const double originLon = -73.69, originLat = 42.73;
+static const double degPerM = 1 / 111195.0;
+static const double lonScale = 1 / std::cos(originLat * M_PI / 180);
+static const double townM = 16000;
+
+static volatile size_t sink;
+
+struct Town {
+  std::vector<std::vector<FencePoint>> rings;
+  std::vector<int> kind; // 0 storefront, 1 section, 2 venue
+};
+
+static FencePoint at(double eastM, double northM) {
+  return {originLon + eastM * degPerM * lonScale, originLat + northM * degPerM};
+}
+
+static Town buildTown(int count, std::mt19937_64 &rng) {
+  std::uniform_real_distribution<double> unit(0, 1);
+  auto between = [&](double a, double b) { return a + (b - a) * unit(rng); };
+  Town town;
+  for (int i = 0; i < count; i++) {
+    double cx = between(0, townM), cy = between(0, townM);
+    double turn = between(0, 2 * M_PI);
+    double roll = unit(rng);
+    std::vector<std::pair<double, double>> local; // metres around (cx, cy)
+    int kind;
+    if (roll < 0.6) {
+      kind = 0;
+      double w = between(8, 30), h = between(8, 30);
+      if (unit(rng) < 0.7) {
+        local = {{0, 0}, {w, 0}, {w, h}, {0, h}};
+      } else {
+        double nw = w * between(0.3, 0.7), nh = h * between(0.3, 0.7);
+        local = {{0, 0}, {w, 0}, {w, nh}, {nw, nh}, {nw, h}, {0, h}};
+      }
+    } else if (roll < 0.9) {
+      kind = 1;
+      double inner = between(20, 80), outer = inner + between(15, 40);
+      double from = between(0, 2 * M_PI), span = between(0.2, 0.9);
+      int steps = (int)between(8, 33);
+      for (int s = 0; s < steps; s++) {
+        double a = from + span * s / (steps - 1);
+        local.push_back({outer * std::cos(a), outer * std::sin(a)});
+      }
+      for (int s = steps - 1; s >= 0; s--) {
+        double a = from + span * s / (steps - 1);
+        local.push_back({inner * std::cos(a), inner * std::sin(a)});
+      }
+    } else {
+      kind = 2;
+      int n = 64 << (int)between(0, 5);
+      double radius = between(50, 400);
+      // A few slow lobes plus jitter: concave, never self-crossing
+      double lobes[3] = {between(0, 0.3), between(0, 0.2), between(0, 0.1)};
+      for (int s = 0; s < n; s++) {
+        double a = 2 * M_PI * s / n;
+        double r = radius * (1 + lobes[0] * std::sin(3 * a) + lobes[1] * std::sin(7 * a + 1) +
+                             lobes[2] * std::sin(19 * a + 2)) *
+                   between(0.85, 1.0);
+        local.push_back({r * std::cos(a), r * std::sin(a)});
+      }
+    }
+    std::vector<FencePoint> ring;
+    for (auto [x, y] : local) {
+      double ex = x * std::cos(turn) - y * std::sin(turn);
+      double ny = x * std::sin(turn) + y * std::cos(turn);
+      ring.push_back(at(cx + ex, cy + ny));
+    }
+    town.rings.push_back(std::move(ring));
+    town.kind.push_back(kind);
+  }
+  return town;
+}
+
+static std::vector<FencePoint> buildPoints(const Town &town, int count, std::mt19937_64 &rng) {
+  std::uniform_real_distribution<double> unit(0, 1);
+  std::vector<FencePoint> points;
+  points.reserve(count);
+  for (int i = 0; i < count; i++) {
+    double roll = unit(rng);
+    const std::vector<FencePoint> &ring = town.rings[rng() % town.rings.size()];
+    if (roll < 0.5) {
+      double x0 = ring[0].x, x1 = x0, y0 = ring[0].y, y1 = y0;
+      for (const FencePoint &p : ring) {
+        x0 = std::min(x0, p.x), x1 = std::max(x1, p.x);
+        y0 = std::min(y0, p.y), y1 = std::max(y1, p.y);
+      }
+      double mx = (x1 - x0) * 0.2, my = (y1 - y0) * 0.2;
+      points.push_back({x0 - mx + (x1 - x0 + 2 * mx) * unit(rng),
+                        y0 - my + (y1 - y0 + 2 * my) * unit(rng)});
+    } else if (roll < 0.95) {
+      points.push_back(at(unit(rng) * townM, unit(rng) * townM));
+    } else {
+      size_t v = rng() % ring.size();
+      const FencePoint &a = ring[v], &b = ring[(v + 1) % ring.size()];
+      points.push_back(unit(rng) < 0.5 ? a : FencePoint{(a.x + b.x) / 2, (a.y + b.y) / 2});
+    }
+  }
+  return points;
+}
+
+static double msSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Rejected rings keep their index but contain nothing, and the index's
+// bounds are the real fence's alone, not stretched to a zeroed box at 0,0
+static bool degenerateCheck() {
+  const double x = originLon, y = originLat, d = 100 * degPerM;
+  FenceIndex index;
+  bool ok = index.add({{x, y}, {x + d, y}, {x + d, y + d}, {x, y + d}});
+  ok = ok && !index.add({{x, y}, {x + d, y}});                        // two corners
+  ok = ok && !index.add({{x, y}, {x + d, y + d}, {x + 2 * d, y + 2 * d}}); // a line
+  ok = ok && !index.add({{x, y}, {x + d, y}, {x + d, y}});               // a repeat
+  ok = ok && !index.add({{x, y}, {NAN, y}, {x, y + d}});
+  ok = ok && !index.add({});
+  index.build();
+  std::vector<uint32_t> hits;
+  index.at(x + d / 2, y + d / 2, hits);
+  ok = ok && hits == std::vector<uint32_t>{0};
+  index.candidates(x + d / 2, y, [&](uint32_t i) { ok = ok && i == 0; });
+  ok = ok && index.left() == x && index.right() == x + d;
+  ok = ok && index.bottom() == y && index.top() == y + d;
+  return ok && index.size() == 6;
+}
+
+int main(int argc, char **argv) {
+  int polygons = 10000, pointCount = 1000000, cells = 0;
+  unsigned long long seed = 1;
+  for (int i = 1; i < argc; i++) {
+    if (!std::strcmp(argv[i], "--polygons") && i + 1 < argc) {
+      polygons = std::max(1, std::atoi(argv[++i]));
+    } else if (!std::strcmp(argv[i], "--points") && i + 1 < argc) {
+      pointCount = std::max(1, std::atoi(argv[++i]));
+    } else if (!std::strcmp(argv[i], "--cells") && i + 1 < argc) {
+      cells = std::max(0, std::atoi(argv[++i]));
+    } else if (!std::strcmp(argv[i], "--seed") && i + 1 < argc) {
+      seed = std::strtoull(argv[++i], nullptr, 10);
+    } else {
+      std::fprintf(stderr,
+                   "usage: %s [--polygons N] [--points N] [--cells N] [--seed N]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  if (!degenerateCheck()) {
+    std::fprintf(stderr, "degenerate ring check failed\n");
+    return 1;
+  }
+
+  std::mt19937_64 rng(seed);
+  Town town = buildTown(polygons, rng);
+  std::vector<FencePoint> points = buildPoints(town, pointCount, rng);
+
+  size_t vertices = 0, maxVertices = 0;
+  for (const auto &ring : town.rings) {
+    vertices += ring.size();
+    maxVertices = std::max(maxVertices, ring.size());
+  }
+  std::printf("%d polygons (%zu vertices, up to %zu in one), %d points\n", polygons, vertices,
+              maxVertices, pointCount);
+
+  Clock::time_point start = Clock::now();
+  FenceIndex index;
+  for (const auto &ring : town.rings) index.add(ring, cells);
+  index.build();
+  double buildMs = msSince(start);
+
+  size_t bytes = 0;
+  double boundary[3] = {0, 0, 0};
+  int perKind[3] = {0, 0, 0};
+  for (size_t i = 0; i < index.size(); i++) {
+    bytes += index.fence(i).bytes();
+    boundary[town.kind[i]] += index.fence(i).boundaryShare();
+    perKind[town.kind[i]]++;
+  }
+  std::printf("grids built in %.0f ms, %.1f MB; cells an edge touches: storefronts %.0f%%,"
+              " sections %.0f%%, venues %.0f%%\n\n",
+              buildMs, bytes / 1e6, 100 * boundary[0] / std::max(1, perKind[0]),
+              100 * boundary[1] / std::max(1, perKind[1]),
+              100 * boundary[2] / std::max(1, perKind[2]));
+
+  // Candidates once, so both sides time only their own tests
+  std::vector<uint32_t> candStart{0}, cand;
+  for (const FencePoint &p : points) {
+    index.candidates(p.x, p.y, [&](uint32_t i) { cand.push_back(i); });
+    candStart.push_back((uint32_t)cand.size());
+  }
+
+  std::vector<uint8_t> plain(cand.size()), grid(cand.size());
+  double plainMs = 1e300, gridMs = 1e300;
+  for (int round = 0; round < 3; round++) {
+    start = Clock::now();
+    for (size_t c = 0; c < cand.size(); c++) {
+      const std::vector<FencePoint> &ring = town.rings[cand[c]];
+      const FencePoint &p = points[std::upper_bound(candStart.begin(), candStart.end(), c) -
+                                   candStart.begin() - 1];
+      plain[c] = rayCastContains(ring.data(), ring.size(), p.x, p.y);
+    }
+    plainMs = std::min(plainMs, msSince(start));
+
+    start = Clock::now();
+    for (size_t c = 0; c < cand.size(); c++) {
+      const FencePoint &p = points[std::upper_bound(candStart.begin(), candStart.end(), c) -
+                                   candStart.begin() - 1];
+      grid[c] = index.fence(cand[c]).contains(p.x, p.y);
+    }
+    gridMs = std::min(gridMs, msSince(start));
+  }
+
+  // The point lookup is the same on both sides; time it alone to take out
+  double lookupMs = 1e300;
+  for (int round = 0; round < 3; round++) {
+    start = Clock::now();
+    size_t acc = 0;
+    for (size_t c = 0; c < cand.size(); c++) {
+      acc += std::upper_bound(candStart.begin(), candStart.end(), c) - candStart.begin();
+    }
+    sink = acc;
+    lookupMs = std::min(lookupMs, msSince(start));
+  }
+  plainMs = std::max(0.0, plainMs - lookupMs);
+  gridMs = std::max(0.0, gridMs - lookupMs);
+
+  size_t differ = 0, hits = 0, oneRead = 0, plainEdges = 0;
+  for (size_t p = 0; p < points.size(); p++) {
+    for (uint32_t c = candStart[p]; c < candStart[p + 1]; c++) {
+      differ += plain[c] != grid[c];
+      hits += grid[c];
+      const PolygonFence &f = index.fence(cand[c]);
+      oneRead += f.cellAt(points[p].x, points[p].y) != PolygonFence::boundary;
+      plainEdges += f.vertices();
+    }
+  }
+
+  // No index at all, on a sample
+  size_t sample = std::min<size_t>(points.size(), 2000);
+  start = Clock::now();
+  size_t everyHits = 0;
+  for (size_t p = 0; p < sample; p++) {
+    for (const auto &ring : town.rings) {
+      everyHits += rayCastContains(ring.data(), ring.size(), points[p].x, points[p].y);
+    }
+  }
+  sink = everyHits;
+  double everyMs = msSince(start) * points.size() / sample;
+
+  double tests = (double)cand.size();
+  std::printf("%.2f candidate fences per point, %zu hits\n", tests / points.size(), hits);
+  std::printf("%.1f%% of tests answered by one cell read; the rest ray-cast part of a row\n",
+              100 * oneRead / std::max(1.0, tests));
+  std::printf("                  total ms   ns/point   ns/test\n");
+  std::printf("every fence      %9.0f %10.0f %9s   (%zu points, scaled)\n", everyMs,
+              everyMs * 1e6 / points.size(), "-", sample);
+  std::printf("plain ray cast   %9.1f %10.1f %9.1f   (%.0f edges per test)\n", plainMs,
+              plainMs * 1e6 / points.size(), plainMs * 1e6 / std::max(1.0, tests),
+              plainEdges / std::max(1.0, tests));
+  std::printf("grid             %9.1f %10.1f %9.1f   (%.1fx the plain ray cast)\n", gridMs,
+              gridMs * 1e6 / points.size(), gridMs * 1e6 / std::max(1.0, tests),
+              plainMs / std::max(1e-9, gridMs));
+  std::printf("\n%zu of %.0f answers differ from the plain ray cast\n", differ, tests);
+  return differ ? 1 : 0;
+}
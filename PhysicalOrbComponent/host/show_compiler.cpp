@@ -0,0 +1,701 @@
+// Compiles a venue light show, written once as a timeline across every orb,
+// into the smallest Serial1 stream per orb, timed so that no link goes over
+// 9600 baud.
+//
+//   g++ -std=c++17 -O2 show_compiler.cpp -o show_compiler
+//   ./show_compiler --show FILE [--out FILE] [--budget PCT]
+//   ./show_compiler                          built-in sample shows
+//
+// A timeline line is "<ms> <orbs> <action>", orbs being *, 3, 1-8 or
+// 1,4,7 (from 0), and # starting a comment. "orbs N" sets how many.
+//   mode X               go back to the orb's own pulse in colour X
+//   speed N              pulse speed
+//   colour R,G,B         hold a colour (streamed, 0-255 = off-full)
+//   fade R,G,B MS        from what it shows now
+//   flash R,G,B MS       then back to what it was
+//
+// For each orb the timeline is played a millisecond at a time to get what
+// the orb should be showing, and commands are only made where that
+// changes and differs from what the orb already has: a repeated mode or
+// colour costs nothing. A speed set while the orb is streaming waits for
+// the mode letter that ends the stream, and goes out ahead of it in the
+// same burst ("25G"). A fade is a frame ('F' 1 + pin levels) at most every
+// frameGapMs, plus its last one.
+//
+// Commands are then laid out backwards from the end of the show: each is
+// sent to finish by the time it should show, or earlier if the one after
+// it needs the line. Only --budget of the line is used, leaving the rest
+// for heartbeats and status queries. A fade frame that would have to go
+// out more than maxEarlyMs early is dropped instead, which is how a fade
+// too fine for the link is thinned; every other command is kept and sent
+// early if it must. Anything the show wants before 0 ms goes out before 0.
+//
+// The report plays each stream back through the sketch's handling (a
+// letter ends streaming, 'F' shows a frame) and compares it with the
+// timeline. "naive" is one command per timeline action per orb, and a
+// frame each time a fade's colour changes, sent when due.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "../src/OrbCore.h"
+
+const int linkBaud = 9600;
+const double byteMs = 10000.0 / linkBaud; // start, 8 data, stop
+const int64_t frameGapMs = 20;
+const double maxEarlyMs = 10;
+
+struct Rgb {
+  uint8_t r, g, b;
+  bool operator==(const Rgb &o) const { return r == o.r && g == o.g && b == o.b; }
+  bool operator!=(const Rgb &o) const { return !(*this == o); }
+};
+
+enum class Act { Mode, Speed, Colour, Fade, Flash };
+
+struct Step {
+  int64_t atMs;
+  std::vector<int> orbs;
+  Act act;
+  char mode;
+  int speed;
+  Rgb colour;
+  int64_t lengthMs;
+};
+
+struct Show {
+  std::string name;
+  int orbs = 1;
+  std::vector<Step> steps;
+};
+
+// What an orb should be showing at a given ms
+struct Look {
+  bool local = true; // its own pulse, rather than a streamed colour
+  char mode = 'W';
+  int speed = 20;
+  Rgb colour = {0, 0, 0};
+  bool ramping = false; // colour is part way through a fade
+};
+
+// ---- Timeline ----
+
+// Brightest point of a mode's pulse, for a fade that starts from one
+static Rgb modeColour(char mode) {
+  int r, g, b;
+  orbTargets(mode, r, g, b);
+  return {(uint8_t)(255 - r), (uint8_t)(255 - g), (uint8_t)(255 - b)};
+}
+
+static int64_t showLength(const Show &show) {
+  int64_t end = 0;
+  for (const Step &s : show.steps) {
+    int64_t last = s.atMs + (s.act == Act::Fade || s.act == Act::Flash ? s.lengthMs : 0);
+    end = std::max(end, last);
+  }
+  return end + 1000;
+}
+
+// Plays the timeline for one orb, one entry per ms
+static std::vector<Look> playOrb(const Show &show, int orb, int64_t lengthMs) {
+  struct Pending {
+    int64_t atMs;
+    size_t order;
+    Step step;
+    bool restore;
+    Look back;
+    bool operator>(const Pending &o) const {
+      return atMs != o.atMs ? atMs > o.atMs : order > o.order;
+    }
+  };
+  std::priority_queue<Pending, std::vector<Pending>, std::greater<Pending>> due;
+  size_t order = 0;
+  for (const Step &s : show.steps) {
+    if (std::find(s.orbs.begin(), s.orbs.end(), orb) != s.orbs.end()) {
+      due.push({s.atMs, order++, s, false, Look()});
+    }
+  }
+
+  std::vector<Look> out(lengthMs);
+  Look now;
+  int64_t rampStart = 0, rampEnd = 0;
+  Rgb rampFrom = {0, 0, 0}, rampTo = {0, 0, 0};
+  for (int64_t t = 0; t < lengthMs; t++) {
+    while (!due.empty() && due.top().atMs <= t) {
+      Pending p = due.top();
+      due.pop();
+      if (p.restore) {
+        now = p.back;
+        continue;
+      }
+      const Step &s = p.step;
+      Rgb shown = now.local ? modeColour(now.mode) : now.colour;
+      switch (s.act) {
+        case Act::Mode:
+          now.local = true;
+          now.mode = s.mode;
+          now.ramping = false;
+          break;
+        case Act::Speed:
+          now.speed = s.speed;
+          break;
+        case Act::Colour:
+          now.local = false;
+          now.colour = s.colour;
+          now.ramping = false;
+          break;
+        case Act::Fade:
+          rampStart = t;
+          rampEnd = t + std::max<int64_t>(1, s.lengthMs);
+          rampFrom = shown;
+          rampTo = s.colour;
+          now.local = false;
+          now.colour = shown;
+          now.ramping = true;
+          break;
+        case Act::Flash: {
+          Look back = now;
+          back.ramping = false;
+          if (now.ramping) back.colour = rampTo; // a flash cuts a fade short
+          due.push({t + s.lengthMs, order++, s, true, back});
+          now.local = false;
+          now.colour = s.colour;
+          now.ramping = false;
+          break;
+        }
+      }
+    }
+    if (now.ramping) {
+      double f = double(t - rampStart) / (rampEnd - rampStart);
+      if (f >= 1) {
+        f = 1;
+        now.ramping = false;
+      }
+      now.colour = {(uint8_t)(rampFrom.r + (rampTo.r - rampFrom.r) * f + 0.5),
+                    (uint8_t)(rampFrom.g + (rampTo.g - rampFrom.g) * f + 0.5),
+                    (uint8_t)(rampFrom.b + (rampTo.b - rampFrom.b) * f + 0.5)};
+    }
+    out[t] = now;
+  }
+  return out;
+}
+
+// ---- Commands ----
+
+struct Cmd {
+  int64_t dueMs;   // when the orb should show it
+  std::string bytes;
+  bool droppable;  // an in-between fade frame
+  double sendMs;   // filled in by schedule()
+};
+
+// 'F', one pixel, r g b
+const int frameLength = 5;
+
+static std::string frameBytes(const Rgb &c) {
+  // Pin levels, common anode: 0 is full
+  std::string s = "F";
+  s += (char)1; // pixels
+  s += (char)(255 - c.r);
+  s += (char)(255 - c.g);
+  s += (char)(255 - c.b);
+  return s;
+}
+
+static std::string speedBytes(int speed) {
+  return std::to_string(speed);
+}
+
+// Smallest commands that take the orb from what it has to what it should
+// show, ms by ms
+static std::vector<Cmd> compileOrb(const std::vector<Look> &want) {
+  std::vector<Cmd> out;
+  Look has;              // what the orb is showing, as far as it's been told
+  has.mode = 0;          // unknown until the first mode letter
+  has.speed = -1;
+  bool hasColour = false;
+  int pendingSpeed = -1; // set while streaming; goes out with the next mode
+  int64_t lastFrameMs = -frameGapMs;
+
+  for (int64_t t = 0; t < (int64_t)want.size(); t++) {
+    const Look &w = want[t];
+    pendingSpeed = w.speed != has.speed ? w.speed : -1;
+    if (w.local) {
+      std::string bytes;
+      if (pendingSpeed >= 0) {
+        bytes += speedBytes(pendingSpeed);
+        has.speed = pendingSpeed;
+      }
+      if (!has.local || w.mode != has.mode) {
+        bytes += w.mode; // also ends the number
+        has.local = true;
+        has.mode = w.mode;
+        hasColour = false;
+      } else if (!bytes.empty()) {
+        bytes += ' ';
+      }
+      if (!bytes.empty()) out.push_back({t, bytes, false, 0});
+      continue;
+    }
+    if (hasColour && !has.local && w.colour == has.colour) continue;
+    bool last = !w.ramping;
+    if (!last && t - lastFrameMs < frameGapMs) continue;
+    out.push_back({t, frameBytes(w.colour), !last, 0});
+    has.local = false;
+    has.colour = w.colour;
+    hasColour = true;
+    lastFrameMs = t;
+  }
+  return out;
+}
+
+// One command per action, each fade level change a frame, all sent when due
+static size_t naiveBytes(const Show &show, int orb, const std::vector<Look> &want,
+                         std::vector<int64_t> &dueMs, std::vector<int> &sizes) {
+  size_t total = 0;
+  auto add = [&](int64_t at, int bytes) {
+    dueMs.push_back(at);
+    sizes.push_back(bytes);
+    total += bytes;
+  };
+  for (const Step &s : show.steps) {
+    if (std::find(s.orbs.begin(), s.orbs.end(), orb) == s.orbs.end()) continue;
+    switch (s.act) {
+      case Act::Mode: add(s.atMs, 1); break;
+      case Act::Speed: add(s.atMs, (int)speedBytes(s.speed).size() + 1); break;
+      case Act::Colour: add(s.atMs, frameLength); break;
+      case Act::Flash: {
+        add(s.atMs, frameLength);
+        bool wasLocal = s.atMs == 0 || want[std::min<size_t>(s.atMs, want.size()) - 1].local;
+        add(s.atMs + s.lengthMs, wasLocal ? 1 : frameLength); // back to the pulse, or the colour
+        break;
+      }
+      case Act::Fade: break;
+    }
+  }
+  for (size_t t = 1; t < want.size(); t++) {
+    if (want[t].ramping && want[t].colour != want[t - 1].colour) add((int64_t)t, frameLength);
+  }
+  return total;
+}
+
+// Backwards from the end: each command finishes by its due time or by the
+// next one's start, whichever is first. Returns how many frames it dropped.
+static int schedule(std::vector<Cmd> &cmds, double budget) {
+  const double slotMs = byteMs / budget;
+  double nextStart = 1e18;
+  int dropped = 0;
+  std::vector<Cmd> kept;
+  for (size_t i = cmds.size(); i-- > 0;) {
+    Cmd &c = cmds[i];
+    double end = std::min((double)c.dueMs, nextStart);
+    if (c.droppable && c.dueMs - end > maxEarlyMs) {
+      dropped++;
+      continue;
+    }
+    c.sendMs = end - c.bytes.size() * slotMs;
+    nextStart = c.sendMs;
+    kept.push_back(c);
+  }
+  std::reverse(kept.begin(), kept.end());
+  cmds.swap(kept);
+  return dropped;
+}
+
+// ---- Checking ----
+
+struct Playback {
+  int64_t wrongMs = 0;     // local/streaming or mode differs from the timeline
+  double colourError = 0;  // mean |channel difference| while both stream
+  int maxColourError = 0;
+  double earliestMs = 0;   // most ahead of its due time a command lands
+  double latestMs = 0;
+};
+
+// Lands each command when its last byte arrives, the way the sketch
+// handles it, and compares what the orb shows with the timeline
+static Playback play(const std::vector<Cmd> &cmds, const std::vector<Look> &want) {
+  Playback p;
+  Look shows;
+  shows.mode = 0;
+  size_t next = 0;
+  int64_t streamedMs = 0;
+  double errorSum = 0;
+  for (const Cmd &c : cmds) {
+    double lands = c.sendMs + c.bytes.size() * byteMs;
+    p.earliestMs = std::max(p.earliestMs, c.dueMs - lands);
+    p.latestMs = std::max(p.latestMs, lands - c.dueMs);
+  }
+  for (int64_t t = 0; t < (int64_t)want.size(); t++) {
+    while (next < cmds.size() && cmds[next].sendMs + cmds[next].bytes.size() * byteMs <= t + 1e-9) {
+      const std::string &b = cmds[next++].bytes;
+      if (b[0] == 'F') {
+        shows.local = false;
+        shows.colour = {(uint8_t)(255 - (uint8_t)b[2]), (uint8_t)(255 - (uint8_t)b[3]),
+                        (uint8_t)(255 - (uint8_t)b[4])};
+      } else {
+        char last = b[b.size() - 1];
+        if (last != ' ') {
+          shows.local = true;
+          shows.mode = last;
+        }
+      }
+    }
+    const Look &w = want[t];
+    if (w.local != shows.local || (w.local && w.mode != shows.mode)) {
+      p.wrongMs++;
+    } else if (!w.local) {
+      int e = std::max({std::abs(w.colour.r - shows.colour.r),
+                        std::abs(w.colour.g - shows.colour.g),
+                        std::abs(w.colour.b - shows.colour.b)});
+      errorSum += e;
+      p.maxColourError = std::max(p.maxColourError, e);
+      streamedMs++;
+    }
+  }
+  p.colourError = streamedMs ? errorSum / streamedMs : 0;
+  return p;
+}
+
+// Most bytes on the line in any window of windowMs, as a share of what it carries
+static double peakUse(const std::vector<double> &startMs, const std::vector<int> &sizes,
+                      int64_t lengthMs, int64_t windowMs) {
+  int64_t origin = 0;
+  for (double s : startMs) origin = std::min(origin, (int64_t)s - 1);
+  std::vector<double> perMs(lengthMs - origin + windowMs, 0.0);
+  for (size_t i = 0; i < startMs.size(); i++) perMs[(int64_t)startMs[i] - origin] += sizes[i];
+  double window = 0, peak = 0;
+  for (size_t t = 0; t < perMs.size(); t++) {
+    window += perMs[t];
+    if (t >= (size_t)windowMs) window -= perMs[t - windowMs];
+    peak = std::max(peak, window);
+  }
+  return peak * byteMs / windowMs;
+}
+
+// ---- Shows ----
+
+static std::vector<int> allOrbs(int n) {
+  std::vector<int> v(n);
+  for (int i = 0; i < n; i++) v[i] = i;
+  return v;
+}
+
+static Step at(int64_t ms, std::vector<int> orbs, Act act) {
+  Step s;
+  s.atMs = ms;
+  s.orbs = std::move(orbs);
+  s.act = act;
+  s.mode = 'W';
+  s.speed = 20;
+  s.colour = {0, 0, 0};
+  s.lengthMs = 0;
+  return s;
+}
+
+static Step mode(int64_t ms, std::vector<int> orbs, char m) {
+  Step s = at(ms, std::move(orbs), Act::Mode);
+  s.mode = m;
+  return s;
+}
+
+static Step speed(int64_t ms, std::vector<int> orbs, int v) {
+  Step s = at(ms, std::move(orbs), Act::Speed);
+  s.speed = v;
+  return s;
+}
+
+static Step colour(int64_t ms, std::vector<int> orbs, Act act, Rgb c, int64_t lengthMs = 0) {
+  Step s = at(ms, std::move(orbs), act);
+  s.colour = c;
+  s.lengthMs = lengthMs;
+  return s;
+}
+
+// Opening: a white chase down the line, a fade into orange, back to the
+// pulse, and the usual cue-sheet repeats
+static Show openingShow() {
+  Show show;
+  show.name = "opening";
+  show.orbs = 24;
+  std::vector<int> all = allOrbs(show.orbs);
+  show.steps.push_back(mode(0, all, 'W'));
+  show.steps.push_back(speed(0, all, 20));
+  for (int pass = 0; pass < 5; pass++) {
+    for (int o = 0; o < show.orbs; o++) {
+      int64_t at = 2000 + pass * 1500 + o * 60;
+      show.steps.push_back(colour(at, {o}, Act::Flash, {255, 255, 255}, 150));
+    }
+  }
+  show.steps.push_back(colour(10000, all, Act::Fade, {255, 80, 0}, 3000));
+  show.steps.push_back(mode(15000, all, 'O'));
+  show.steps.push_back(speed(15000, all, 10));
+  for (int64_t t = 20000; t < 40000; t += 5000) {
+    show.steps.push_back(mode(t, all, 'O')); // re-sent on every cue, already set
+    show.steps.push_back(speed(t, all, 10));
+  }
+  show.steps.push_back(colour(40000, all, Act::Fade, {0, 40, 255}, 1000));
+  show.steps.push_back(colour(45000, all, Act::Colour, {0, 40, 255}));
+  show.steps.push_back(speed(46000, all, 30));
+  show.steps.push_back(mode(50000, all, 'G'));
+  return show;
+}
+
+// Strobe: 12 Hz flashes, alternating colours, half the orbs at a time
+static Show strobeShow() {
+  Show show;
+  show.name = "strobe";
+  show.orbs = 12;
+  std::vector<int> all = allOrbs(show.orbs), even, odd;
+  for (int o = 0; o < show.orbs; o++) (o % 2 ? odd : even).push_back(o);
+  show.steps.push_back(mode(0, all, 'R'));
+  for (int64_t t = 1000; t < 25000; t += 83) {
+    bool flip = (t / 83) % 2;
+    show.steps.push_back(colour(t, flip ? odd : even, Act::Flash,
+                                flip ? Rgb{255, 255, 255} : Rgb{0, 120, 255}, 30));
+  }
+  show.steps.push_back(mode(26000, all, 'G'));
+  return show;
+}
+
+// Sunset: slow fades rolling down 40 orbs, a minute each
+static Show sunsetShow() {
+  Show show;
+  show.name = "sunset";
+  show.orbs = 40;
+  std::vector<int> all = allOrbs(show.orbs);
+  show.steps.push_back(mode(0, all, 'W'));
+  const Rgb palette[] = {{255, 180, 60}, {255, 90, 20}, {200, 30, 60}, {60, 0, 90}, {5, 0, 30}};
+  for (int o = 0; o < show.orbs; o++) {
+    for (int k = 0; k < 5; k++) {
+      show.steps.push_back(colour(5000 + k * 60000 + o * 500, {o}, Act::Fade, palette[k], 55000));
+    }
+  }
+  show.steps.push_back(mode(310000, all, 'C'));
+  return show;
+}
+
+// Pulse-to-beat: quarter-second fades across the full range, too fine to
+// send every level
+static Show beatShow() {
+  Show show;
+  show.name = "beat fades";
+  show.orbs = 16;
+  std::vector<int> all = allOrbs(show.orbs);
+  show.steps.push_back(mode(0, all, 'W'));
+  for (int64_t t = 1000; t < 61000; t += 500) {
+    bool up = (t / 500) % 2;
+    show.steps.push_back(colour(t, all, Act::Fade, up ? Rgb{255, 0, 255} : Rgb{0, 255, 40}, 250));
+  }
+  show.steps.push_back(mode(62000, all, 'W'));
+  return show;
+}
+
+// ---- Files ----
+
+static bool parseOrbs(const char *text, int count, std::vector<int> &out) {
+  if (!std::strcmp(text, "*")) {
+    out = allOrbs(count);
+    return true;
+  }
+  const char *p = text;
+  while (*p) {
+    char *end;
+    long a = std::strtol(p, &end, 10);
+    if (end == p) return false;
+    long b = a;
+    if (*end == '-') {
+      p = end + 1;
+      b = std::strtol(p, &end, 10);
+      if (end == p) return false;
+    }
+    for (long o = a; o <= b; o++) {
+      if (o >= 0 && o < count) out.push_back((int)o);
+    }
+    p = *end == ',' ? end + 1 : end;
+    if (*end && *end != ',') return false;
+  }
+  return !out.empty();
+}
+
+static bool parseRgb(const char *text, Rgb &c) {
+  int r, g, b;
+  if (std::sscanf(text, "%d,%d,%d", &r, &g, &b) != 3) return false;
+  c = {(uint8_t)std::clamp(r, 0, 255), (uint8_t)std::clamp(g, 0, 255),
+       (uint8_t)std::clamp(b, 0, 255)};
+  return true;
+}
+
+static bool readShow(const char *path, Show &show) {
+  FILE *f = std::fopen(path, "r");
+  if (!f) return false;
+  show.name = path;
+  char line[256];
+  int lineNo = 0;
+  bool ok = true;
+  while (ok && std::fgets(line, sizeof(line), f)) {
+    lineNo++;
+    char *hash = std::strchr(line, '#');
+    if (hash) *hash = 0;
+    char a[32] = "", b[32] = "", c[32] = "", d[32] = "", e[32] = "";
+    int n = std::sscanf(line, "%31s %31s %31s %31s %31s", a, b, c, d, e);
+    if (n <= 0) continue;
+    if (!std::strcmp(a, "orbs") && n == 2) {
+      show.orbs = std::max(1, std::atoi(b));
+      continue;
+    }
+    Step s = at(std::atoll(a), {}, Act::Mode);
+    ok = n >= 4 && parseOrbs(b, show.orbs, s.orbs);
+    if (!ok) break;
+    if (!std::strcmp(c, "mode")) {
+      s.mode = d[0];
+    } else if (!std::strcmp(c, "speed")) {
+      s.act = Act::Speed;
+      s.speed = std::max(0, std::atoi(d));
+    } else if (!std::strcmp(c, "colour")) {
+      s.act = Act::Colour;
+      ok = parseRgb(d, s.colour);
+    } else if (!std::strcmp(c, "fade") || !std::strcmp(c, "flash")) {
+      s.act = c[1] == 'a' ? Act::Fade : Act::Flash;
+      ok = n == 5 && parseRgb(d, s.colour);
+      s.lengthMs = std::atoll(e);
+    } else {
+      ok = false;
+    }
+    if (ok) show.steps.push_back(s);
+  }
+  std::fclose(f);
+  if (!ok) std::fprintf(stderr, "%s:%d: can't read this line\n", path, lineNo);
+  return ok;
+}
+
+// ---- Compiling a show ----
+
+struct ShowReport {
+  size_t naive = 0, compiled = 0;
+  double naivePeak1s = 0, naivePeak100 = 0, peak1s = 0, peak100 = 0;
+  int dropped = 0;
+  int64_t wrongMs = 0, lengthMs = 0;
+  double colourError = 0;
+  int maxColourError = 0;
+  double earliestMs = 0, latestMs = 0;
+};
+
+static void writeStream(FILE *out, int orb, const std::vector<Cmd> &cmds) {
+  for (const Cmd &c : cmds) {
+    std::fprintf(out, "%.2f %d ", c.sendMs, orb);
+    for (unsigned char ch : c.bytes) {
+      if (ch >= 0x21 && ch < 0x7f && ch != '\\') {
+        std::fputc(ch, out);
+      } else {
+        std::fprintf(out, "\\x%02x", ch);
+      }
+    }
+    std::fputc('\n', out);
+  }
+}
+
+static ShowReport compileShow(const Show &show, double budget, FILE *out) {
+  ShowReport r;
+  r.lengthMs = showLength(show);
+  double colourSum = 0;
+  for (int orb = 0; orb < show.orbs; orb++) {
+    std::vector<Look> want = playOrb(show, orb, r.lengthMs);
+
+    std::vector<int64_t> naiveDue;
+    std::vector<int> naiveSizes;
+    r.naive += naiveBytes(show, orb, want, naiveDue, naiveSizes);
+    std::vector<double> naiveStart(naiveDue.begin(), naiveDue.end());
+    r.naivePeak1s = std::max(r.naivePeak1s, peakUse(naiveStart, naiveSizes, r.lengthMs, 1000));
+    r.naivePeak100 = std::max(r.naivePeak100, peakUse(naiveStart, naiveSizes, r.lengthMs, 100));
+
+    std::vector<Cmd> cmds = compileOrb(want);
+    r.dropped += schedule(cmds, budget);
+    std::vector<double> starts;
+    std::vector<int> sizes;
+    for (const Cmd &c : cmds) {
+      r.compiled += c.bytes.size();
+      starts.push_back(c.sendMs);
+      sizes.push_back((int)c.bytes.size());
+    }
+    r.peak1s = std::max(r.peak1s, peakUse(starts, sizes, r.lengthMs, 1000));
+    r.peak100 = std::max(r.peak100, peakUse(starts, sizes, r.lengthMs, 100));
+
+    Playback p = play(cmds, want);
+    r.wrongMs += p.wrongMs;
+    colourSum += p.colourError;
+    r.maxColourError = std::max(r.maxColourError, p.maxColourError);
+    r.earliestMs = std::max(r.earliestMs, p.earliestMs);
+    r.latestMs = std::max(r.latestMs, p.latestMs);
+    if (out) writeStream(out, orb, cmds);
+  }
+  r.colourError = colourSum / show.orbs;
+  return r;
+}
+
+static void printHeader() {
+  std::printf("%-12s %5s | %9s %9s %6s | %-13s %-13s | %5s %8s %9s %8s\n", "show", "orbs",
+              "naive B", "sent B", "saved", "naive peak", "sent peak", "thin", "wrong ms",
+              "colour err", "early ms");
+  std::printf("%-12s %5s | %9s %9s %6s | %-13s %-13s |\n", "", "", "", "", "", "  1 s / 100ms",
+              "  1 s / 100ms");
+}
+
+static void printReport(const Show &show, const ShowReport &r) {
+  std::printf("%-12s %5d | %9zu %9zu %5.1f%% | %4.0f%% / %4.0f%% | %4.0f%% / %4.0f%% | %5d %8lld "
+              "%4.1f/%-4d %8.1f\n",
+              show.name.c_str(), show.orbs, r.naive, r.compiled,
+              100.0 * (1 - (double)r.compiled / r.naive), 100 * r.naivePeak1s,
+              100 * r.naivePeak100, 100 * r.peak1s, 100 * r.peak100, r.dropped,
+              (long long)r.wrongMs, r.colourError, r.maxColourError, r.earliestMs);
+}
+
+int main(int argc, char **argv) {
+  const char *showPath = nullptr;
+  const char *outPath = nullptr;
+  double budget = 0.9;
+  for (int i = 1; i < argc; i++) {
+    if (!std::strcmp(argv[i], "--show") && i + 1 < argc) {
+      showPath = argv[++i];
+    } else if (!std::strcmp(argv[i], "--out") && i + 1 < argc) {
+      outPath = argv[++i];
+    } else if (!std::strcmp(argv[i], "--budget") && i + 1 < argc) {
+      budget = std::clamp(std::atof(argv[++i]) / 100, 0.05, 1.0);
+    } else {
+      std::fprintf(stderr, "usage: %s [--show FILE [--out FILE]] [--budget PCT]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  std::vector<Show> shows;
+  if (showPath) {
+    Show show;
+    if (!readShow(showPath, show)) return 1;
+    shows.push_back(show);
+  } else {
+    shows = {openingShow(), strobeShow(), sunsetShow(), beatShow()};
+  }
+
+  FILE *out = nullptr;
+  if (outPath) {
+    out = std::fopen(outPath, "w");
+    if (!out) {
+      std::perror(outPath);
+      return 1;
+    }
+    std::fprintf(out, "# send ms, orb, bytes (\\xNN for anything unprintable)\n");
+  }
+
+  std::printf("%d baud per orb, %.0f%% of it for the show, fade frames at most every %lld ms\n",
+              linkBaud, budget * 100, (long long)frameGapMs);
+  printHeader();
+  for (const Show &show : shows) printReport(show, compileShow(show, budget, out));
+  if (out) std::fclose(out);
+  return 0;
+}
@@ -0,0 +1,440 @@
+// Orb telemetry in a TelemetryStore (TelemetryStore.h): ingest, range
+// queries, and a benchmark on simulated fleet telemetry.
+//
+//   g++ -std=c++17 -O2 telemetry_store.cpp -o telemetry_store
+//   ./telemetry_store --dir DIR --ingest < samples   lines of "ts orbId metric value"
+//   ./telemetry_store --dir DIR --query ORB METRIC FROM TO
+//   ./telemetry_store --bench [--orbs N] [--days D] [--interval S] [--dir DIR]
+//   ./telemetry_store --check
+//
+// Metrics are named as in metricNames below; timestamps are ms since the
+// epoch. --bench writes into a temporary directory unless --dir is given
+// and reports ingest rate, bytes per sample (against JSON rows and raw
+// 16-byte samples) and query speed. --ingest skips (and counts) samples
+// older than the newest one already stored for their series. --check runs
+// the encoding round trip and the ordering checks the bench starts with.
+
+#include <ftw.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "TelemetryStore.h"
+
+using Clock = std::chrono::steady_clock;
+
+enum Metric : uint8_t {
+  Mode,
+  PulseSpeed,
+  LoopUs,
+  Commands,
+  ParseErrors,
+  LinkLatencyMs,
+  metricCount
+};
+
+static const char *metricNames[metricCount] = {"mode",     "pulse_speed",  "loop_us",
+                                               "commands", "parse_errors", "link_latency_ms"};
+
+static int metricByName(const char *name) {
+  for (int m = 0; m < metricCount; m++) {
+    if (!strcmp(name, metricNames[m])) return m;
+  }
+  return -1;
+}
+
+static double secondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// ---- Simulated fleet ----
+
+// Cheap enough that generating the data doesn't drown out the store
+struct XorShift {
+  uint64_t state;
+  uint64_t next() {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+  }
+  bool chance(unsigned oneIn) { return next() % oneIn == 0; }
+};
+
+// What an orb reports: its colour mode and speed (rarely change), the
+// sketch's loop time in whole us (noisy), the link monitor's command and
+// parse error totals (climbing counters) and status latency in ms with us
+// resolution (the hardest case for XOR)
+struct SimOrb {
+  int64_t phaseMs;
+  double values[metricCount];
+
+  void init(uint32_t id, XorShift &rng) {
+    phaseMs = (int64_t)(rng.next() % 30000);
+    values[Mode] = (double)(rng.next() % 4);
+    values[PulseSpeed] = 20;
+    values[LoopUs] = 140;
+    values[Commands] = (double)(id * 10);
+    values[ParseErrors] = 0;
+    values[LinkLatencyMs] = 4;
+  }
+
+  void step(uint32_t id, XorShift &rng) {
+    if (rng.chance(500)) values[Mode] = (double)(rng.next() % 4);
+    if (rng.chance(2000)) values[PulseSpeed] = (double)(5 + rng.next() % 40);
+    values[LoopUs] = (double)(130 + rng.next() % 25);
+    values[Commands] += (double)(rng.next() % 3);
+    if (rng.chance(id % 100 == 7 ? 3 : 200)) values[ParseErrors] += 1;
+    values[LinkLatencyMs] = (double)(3500 + rng.next() % 2000) / 1000;
+  }
+};
+
+struct SimFleet {
+  std::vector<SimOrb> orbs;
+  XorShift rng{88172645463325252ull};
+  int64_t startMs = 1760000000000; // Oct 2025
+  int64_t intervalMs;
+
+  SimFleet(size_t count, int64_t intervalMs) : orbs(count), intervalMs(intervalMs) {
+    for (size_t i = 0; i < count; i++) orbs[i].init((uint32_t)i + 1, rng);
+  }
+
+  // Report n from every orb: a steady interval, a few ms of jitter
+  template <typename Fn>
+  void report(int64_t n, Fn fn) {
+    for (size_t i = 0; i < orbs.size(); i++) {
+      SimOrb &orb = orbs[i];
+      orb.step((uint32_t)i + 1, rng);
+      int64_t ts = startMs + orb.phaseMs + n * intervalMs + (int64_t)(rng.next() % 8);
+      fn(i, ts, orb.values);
+    }
+  }
+};
+
+// ---- Benchmark ----
+
+static size_t jsonRowBytes(uint32_t orbId, int metric, int64_t ts, double value) {
+  char row[160];
+  return (size_t)snprintf(row, sizeof(row), "{\"orbId\":%u,\"metric\":\"%s\",\"ts\":%lld,"
+                                            "\"value\":%.17g}\n",
+                          orbId, metricNames[metric], (long long)ts, value);
+}
+
+// Round trip through one chunk, including the values and gaps that take
+// the rarely used encodings
+static bool selfCheck() {
+  std::vector<std::pair<int64_t, double>> samples;
+  std::mt19937_64 rng(3);
+  int64_t ts = -5;
+  const double odd[] = {0.0, -0.0, NAN, INFINITY, -INFINITY, 1e-310, 1.0, -1.0, 1e300};
+  for (int i = 0; i < 5000; i++) {
+    static const int64_t gaps[] = {0, 1, 60, 65, 250, 2048, 5000, 1ll << 33};
+    ts += gaps[rng() % 8] + (int64_t)(rng() % 3);
+    double value;
+    switch (rng() % 4) {
+    case 0: value = odd[rng() % 9]; break;
+    case 1: value = telemetry::bitsValue(rng()); break;
+    case 2: value = (double)(rng() % 100); break;
+    default: value = samples.empty() ? 0 : samples.back().second; break;
+    }
+    samples.push_back({ts, value});
+  }
+  telemetry::ChunkEncoder chunk;
+  chunk.clear();
+  for (auto &s : samples) chunk.append(s.first, s.second);
+  size_t i = 0;
+  bool ok = true;
+  telemetry::decodeChunk(chunk.data().data().data(), chunk.size(), INT64_MIN, INT64_MAX,
+                         [&](int64_t t, double v) {
+                           ok = ok && i < samples.size() && t == samples[i].first &&
+                                telemetry::valueBits(v) == telemetry::valueBits(samples[i].second);
+                           i++;
+                         });
+  return ok && i == samples.size();
+}
+
+static int removeEntry(const char *path, const struct stat *, int, FTW *) { return remove(path); }
+
+// Late samples are refused, in the open chunk and against sealed ones
+// after a reopen, so range queries stay complete and in order
+static bool orderCheck() {
+  char path[] = "/tmp/orb_telemetry_XXXXXX";
+  std::string dir = mkdtemp(path);
+  std::vector<int64_t> seen;
+  bool ok;
+  {
+    TelemetryStore store(dir);
+    ok = store.ok() && store.append(7, LoopUs, 1000, 1) && store.append(7, LoopUs, 2000, 2) &&
+         !store.append(7, LoopUs, 1500, 3) && store.append(7, LoopUs, 3000, 4) &&
+         store.append(7, LoopUs, 3000, 5);
+    store.query(7, LoopUs, INT64_MIN, INT64_MAX, [&](int64_t ts, double) { seen.push_back(ts); });
+    ok = ok && seen == std::vector<int64_t>{1000, 2000, 3000, 3000};
+  }
+  {
+    TelemetryStore store(dir);
+    ok = ok && !store.append(7, LoopUs, 2500, 6) && store.append(7, LoopUs, 4000, 7) &&
+         store.append(8, LoopUs, 1500, 8);
+    seen.clear();
+    store.query(7, LoopUs, 1400, 3500, [&](int64_t ts, double) { seen.push_back(ts); });
+    ok = ok && seen == std::vector<int64_t>{2000, 3000, 3000};
+  }
+  nftw(dir.c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+  return ok;
+}
+
+static bool runChecks() {
+  if (!selfCheck()) {
+    fprintf(stderr, "round trip check failed\n");
+    return false;
+  }
+  if (!orderCheck()) {
+    fprintf(stderr, "ordering check failed\n");
+    return false;
+  }
+  return true;
+}
+
+static int runBench(size_t orbCount, int days, int intervalS, std::string dir) {
+  if (!runChecks()) return 1;
+  bool temporary = dir.empty();
+  if (temporary) {
+    char path[] = "/tmp/orb_telemetry_XXXXXX";
+    dir = mkdtemp(path);
+  } else {
+    mkdir(dir.c_str(), 0755);
+  }
+
+  const int64_t intervalMs = (int64_t)intervalS * 1000;
+  const int64_t reports = (int64_t)days * 86400 / intervalS;
+  const uint64_t samples = (uint64_t)reports * orbCount * metricCount;
+  printf("%zu orbs x %d metrics, every %d s for %d days: %llu samples\n\n", orbCount, metricCount,
+         intervalS, days, (unsigned long long)samples);
+
+  // The simulator on its own, to take out of the ingest time
+  double genSeconds;
+  {
+    SimFleet fleet(orbCount, intervalMs);
+    double sum = 0;
+    Clock::time_point start = Clock::now();
+    for (int64_t n = 0; n < reports; n++) {
+      fleet.report(n, [&](size_t, int64_t ts, const double *values) { sum += values[2] + ts; });
+    }
+    genSeconds = secondsSince(start);
+    if (sum == 1) printf(" ");
+  }
+
+  double jsonBytes = 0;
+  uint64_t jsonRows = 0;
+  int64_t endMs;
+  {
+    TelemetryStore store(dir);
+    if (!store.ok()) return 1;
+    std::vector<TelemetryStore::SeriesId> ids(orbCount * metricCount);
+    for (size_t i = 0; i < ids.size(); i++) {
+      ids[i] = store.series((uint32_t)(i / metricCount) + 1, (uint8_t)(i % metricCount));
+    }
+
+    SimFleet fleet(orbCount, intervalMs);
+    Clock::time_point start = Clock::now();
+    for (int64_t n = 0; n < reports; n++) {
+      fleet.report(n, [&](size_t orb, int64_t ts, const double *values) {
+        for (int m = 0; m < metricCount; m++) {
+          store.append(ids[orb * metricCount + m], ts, values[m]);
+        }
+      });
+    }
+    store.flush();
+    double seconds = secondsSince(start) - genSeconds;
+    endMs = fleet.startMs + reports * intervalMs + 30000;
+    printf("ingest: %.1f M samples/s (%.1f ns/sample, simulator excluded)\n",
+           samples / seconds / 1e6, seconds * 1e9 / samples);
+
+    // JSON rows for comparison, sized from one report in 1000
+    SimFleet again(orbCount, intervalMs);
+    for (int64_t n = 0; n < reports; n++) {
+      again.report(n, [&](size_t orb, int64_t ts, const double *values) {
+        if (n % 1000 != 0) return;
+        for (int m = 0; m < metricCount; m++) {
+          jsonBytes += jsonRowBytes((uint32_t)orb + 1, m, ts, values[m]);
+          jsonRows++;
+        }
+      });
+    }
+
+    uint64_t disk = store.diskBytes();
+    double json = jsonBytes / jsonRows;
+    printf("stored: %.1f MB, %.2f bytes/sample (raw 16, JSON rows %.1f: %.0fx smaller)\n",
+           disk / 1e6, (double)disk / samples, json, json * samples / disk);
+    printf("        (%.1f GB as JSON rows)\n", json * samples / 1e9);
+    for (int m = 0; m < metricCount; m++) {
+      uint64_t bytes = 0, count = 0;
+      for (size_t orb = 0; orb < orbCount; orb++) {
+        uint64_t b, c;
+        store.usage(ids[orb * metricCount + m], b, c);
+        bytes += b;
+        count += c;
+      }
+      printf("  %-16s %5.2f bytes/sample\n", metricNames[m], (double)bytes / count);
+    }
+  }
+
+  // Reopened from disk, so every query below reads the mappings
+  Clock::time_point start = Clock::now();
+  TelemetryStore store(dir);
+  printf("\nreopen: %zu series indexed in %.1f ms\n", store.seriesCount(),
+         secondsSince(start) * 1e3);
+
+  std::mt19937 rng(5);
+  const int64_t day = 86400 * 1000ll, hour = 3600 * 1000ll;
+  const int queries = 2000;
+  uint64_t decoded = 0;
+  double sum = 0;
+  start = Clock::now();
+  for (int q = 0; q < queries; q++) {
+    int64_t to = endMs - (int64_t)(rng() % days) * day;
+    store.query((uint32_t)(rng() % orbCount) + 1, LoopUs, to - day, to, [&](int64_t, double v) {
+      sum += v;
+      decoded++;
+    });
+  }
+  double seconds = secondsSince(start);
+  printf("one orb, one metric, 24 h: %.1f us/query (%llu samples each)\n", seconds * 1e6 / queries,
+         (unsigned long long)(decoded / queries));
+
+  // A dashboard panel: mean loop time over the fleet for the last hour
+  start = Clock::now();
+  decoded = 0;
+  const int fleetQueries = 20;
+  for (int q = 0; q < fleetQueries; q++) {
+    int64_t to = endMs - (int64_t)q * hour;
+    for (TelemetryStore::SeriesId id = 0; id < store.seriesCount(); id++) {
+      if (store.metricOf(id) != LoopUs) continue;
+      store.query(id, to - hour, to, [&](int64_t, double v) {
+        sum += v;
+        decoded++;
+      });
+    }
+  }
+  seconds = secondsSince(start);
+  printf("fleet mean loop_us, 1 h:   %.1f ms/query (%llu samples each)\n",
+         seconds * 1e3 / fleetQueries, (unsigned long long)(decoded / fleetQueries));
+
+  start = Clock::now();
+  decoded = 0;
+  for (TelemetryStore::SeriesId id = 0; id < store.seriesCount(); id++) {
+    store.query(id, INT64_MIN, INT64_MAX, [&](int64_t ts, double v) {
+      sum += v + ts;
+      decoded++;
+    });
+  }
+  seconds = secondsSince(start);
+  printf("full scan: %llu samples in %.1f s, %.0f M samples/s\n", (unsigned long long)decoded,
+         seconds, decoded / seconds / 1e6);
+  if (decoded != samples) fprintf(stderr, "expected %llu samples\n", (unsigned long long)samples);
+  if (sum == 1) printf(" ");
+
+  if (temporary) nftw(dir.c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+  return decoded == samples ? 0 : 1;
+}
+
+// ---- Command line ----
+
+static int runIngest(const std::string &dir) {
+  mkdir(dir.c_str(), 0755);
+  TelemetryStore store(dir);
+  if (!store.ok()) return 1;
+  char line[256], name[64];
+  long long ts;
+  unsigned orbId;
+  double value;
+  size_t count = 0, late = 0;
+  while (fgets(line, sizeof(line), stdin)) {
+    int metric;
+    if (sscanf(line, "%lld %u %63s %lf", &ts, &orbId, name, &value) != 4 ||
+        (metric = metricByName(name)) < 0) {
+      fprintf(stderr, "skipping %s", line);
+      continue;
+    }
+    if (store.append(orbId, (uint8_t)metric, ts, value)) {
+      count++;
+    } else {
+      late++;
+    }
+  }
+  fprintf(stderr, "%zu samples", count);
+  if (late > 0) fprintf(stderr, ", %zu older than their series' newest skipped", late);
+  fprintf(stderr, "\n");
+  return 0;
+}
+
+static int runQuery(const std::string &dir, char **args) {
+  int metric = metricByName(args[1]);
+  if (metric < 0) {
+    fprintf(stderr, "unknown metric %s\n", args[1]);
+    return 1;
+  }
+  TelemetryStore store(dir);
+  bool found = store.query((uint32_t)strtoul(args[0], nullptr, 10), (uint8_t)metric,
+                           atoll(args[2]), atoll(args[3]), [](int64_t ts, double v) {
+                             printf("%lld %.17g\n", (long long)ts, v);
+                           });
+  return found ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+  std::string dir;
+  size_t orbs = 1000;
+  int days = 30, intervalS = 30;
+  bool bench = false, ingest = false, check = false;
+  char **queryArgs = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--dir") && i + 1 < argc) {
+      dir = argv[++i];
+    } else if (!strcmp(argv[i], "--bench")) {
+      bench = true;
+    } else if (!strcmp(argv[i], "--orbs") && i + 1 < argc) {
+      orbs = (size_t)atol(argv[++i]);
+    } else if (!strcmp(argv[i], "--days") && i + 1 < argc) {
+      days = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--interval") && i + 1 < argc) {
+      intervalS = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--check")) {
+      check = true;
+    } else if (!strcmp(argv[i], "--ingest")) {
+      ingest = true;
+    } else if (!strcmp(argv[i], "--query") && i + 4 < argc) {
+      queryArgs = argv + i + 1;
+      i += 4;
+    } else {
+      bench = ingest = check = false;
+      queryArgs = nullptr;
+      dir.clear();
+      break;
+    }
+  }
+
+  if (check) {
+    if (!runChecks()) return 1;
+    printf("checks passed\n");
+    return 0;
+  }
+  if (bench && orbs > 0 && days > 0 && intervalS > 0) return runBench(orbs, days, intervalS, dir);
+  if (!dir.empty() && ingest) return runIngest(dir);
+  if (!dir.empty() && queryArgs) return runQuery(dir, queryArgs);
+  fprintf(stderr,
+          "usage: %s --dir DIR --ingest < samples\n"
+          "       %s --dir DIR --query ORB METRIC FROM TO\n"
+          "       %s --bench [--orbs N] [--days D] [--interval S] [--dir DIR]\n"
+          "       %s --check\n",
+          argv[0], argv[0], argv[0], argv[0]);
+  return 1;
+}
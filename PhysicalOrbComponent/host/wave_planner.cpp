@@ -0,0 +1,407 @@
+// Plans a wave across a group of orbs from where they stand. Each orb gets
+// a phase once, the whole group gets one 'Z', and from then on every orb
+// runs the wave from its own clock (OrbRenderState::sync, src/OrbCore.h):
+// nothing more goes over the link until the next wave.
+//
+//   g++ -std=c++17 -O2 wave_planner.cpp -o wave_planner
+//   ./wave_planner --ripple LAT,LON [options] < orbs    rings out from a point
+//   ./wave_planner --sweep DEG [options] < orbs         a front heading DEG
+//   options: [--wave M/S] [--period MS] [--mode X] [--resync S]
+//   ./wave_planner --sim [--orbs N] [--minutes N] [--seed N]
+//
+// orbs is lines of orbId|latitude|longitude, the events' GeoPoints. Each
+// orb's delay is how long the wave takes to reach it at --wave metres a
+// second; its phase is minus that delay, in pulse steps. The pulse speed
+// is --period over pulseSteps, so the period comes out a multiple of 510
+// ms and a phase is off by at most half a step.
+//
+// Output is "<orbId> <mode>P<phase> <speed>" per orb, the payload for its
+// retained state topic or its Serial1 link, then "group Z" once they have
+// all been sent. Orb clocks drift apart, so --resync says how often to
+// send 'Z' again; it is rounded to whole periods, where a resync doesn't
+// make an orb that is on time jump.
+//
+// --sim lays orbs along a street and runs them in virtual time, each with
+// its own clock error, boot time, loop() lateness and 'Z' latency, and
+// measures how far each one is from the step the plan puts it on (an orb
+// with a perfect clock and link is 0 ms off). "nbr" is how far two orbs
+// next to each other are off from each other, which is what makes a wave
+// front look ragged; "in step" is within one step of the plan.
+// "free-running" is the same orbs counting their own ticks after the 'Z'
+// instead of following their clock.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/OrbCore.h"
+
+struct GeoOrb {
+  std::string id;
+  double latitude, longitude;
+};
+
+struct WaveShape {
+  bool ripple = true;
+  double latitude = 0, longitude = 0; // ripple centre
+  double headingDeg = 0;              // sweep direction, 0 = north, 90 = east
+  double metresPerSecond = 10;
+  double periodMs = 10200;            // the sketch's default 20 ms speed
+};
+
+struct OrbWave {
+  double delayMs; // when the wave reaches the orb
+  int phase;      // pulse steps
+};
+
+struct WavePlan {
+  int speed; // pulse speed, ms per step
+  std::vector<OrbWave> orbs;
+};
+
+const double earthRadiusM = 6371000;
+const double degToRad = M_PI / 180;
+
+// Equirectangular about the group's middle; a street is small enough
+static void toMetres(const std::vector<GeoOrb> &orbs, double lat0, double lon0, size_t i,
+                     double &x, double &y) {
+  x = (orbs[i].longitude - lon0) * degToRad * earthRadiusM * std::cos(lat0 * degToRad);
+  y = (orbs[i].latitude - lat0) * degToRad * earthRadiusM;
+}
+
+static WavePlan planWave(const std::vector<GeoOrb> &orbs, const WaveShape &shape) {
+  WavePlan plan;
+  plan.speed = std::max(1, (int)std::lround(shape.periodMs / pulseSteps));
+
+  double lat0 = shape.latitude, lon0 = shape.longitude;
+  if (!shape.ripple) {
+    lat0 = lon0 = 0;
+    for (const GeoOrb &o : orbs) {
+      lat0 += o.latitude / orbs.size();
+      lon0 += o.longitude / orbs.size();
+    }
+  }
+  double dx = std::sin(shape.headingDeg * degToRad), dy = std::cos(shape.headingDeg * degToRad);
+
+  std::vector<double> along(orbs.size());
+  for (size_t i = 0; i < orbs.size(); i++) {
+    double x, y;
+    toMetres(orbs, lat0, lon0, i, x, y);
+    along[i] = shape.ripple ? std::hypot(x, y) : x * dx + y * dy;
+  }
+  // A sweep starts at whichever orb it meets first
+  double first = shape.ripple ? 0 : *std::min_element(along.begin(), along.end());
+
+  for (double a : along) {
+    OrbWave w;
+    w.delayMs = (a - first) / shape.metresPerSecond * 1000;
+    long steps = std::lround(w.delayMs / plan.speed) % pulseSteps;
+    w.phase = (int)((pulseSteps - steps) % pulseSteps);
+    plan.orbs.push_back(w);
+  }
+  return plan;
+}
+
+// Orbs closer together than half a wavelength in delay terms are fine;
+// past that the eye sees the wave run backwards
+static double worstNeighbourGapMs(const std::vector<GeoOrb> &orbs, const WavePlan &plan) {
+  double worst = 0;
+  for (size_t i = 0; i < orbs.size(); i++) {
+    double nearest = 1e18, gap = 0;
+    for (size_t j = 0; j < orbs.size(); j++) {
+      if (i == j) continue;
+      double x, y;
+      toMetres(orbs, orbs[i].latitude, orbs[i].longitude, j, x, y);
+      double d = std::hypot(x, y);
+      if (d < nearest) {
+        nearest = d;
+        gap = std::fabs(plan.orbs[i].delayMs - plan.orbs[j].delayMs);
+      }
+    }
+    worst = std::max(worst, gap);
+  }
+  return worst;
+}
+
+static bool readOrbs(std::vector<GeoOrb> &out) {
+  char line[512];
+  while (std::fgets(line, sizeof(line), stdin)) {
+    line[std::strcspn(line, "\r\n")] = 0;
+    char *lat = std::strchr(line, '|');
+    char *lon = lat ? std::strchr(lat + 1, '|') : nullptr;
+    if (!lon) {
+      if (line[0]) std::fprintf(stderr, "skipping \"%s\"\n", line);
+      continue;
+    }
+    *lat = 0;
+    out.push_back({line, std::atof(lat + 1), std::atof(lon + 1)});
+  }
+  return !out.empty();
+}
+
+static int runPlan(const WaveShape &shape, char mode, double resyncS) {
+  std::vector<GeoOrb> orbs;
+  if (!readOrbs(orbs)) {
+    std::fprintf(stderr, "no orbs on stdin\n");
+    return 1;
+  }
+  WavePlan plan = planWave(orbs, shape);
+  for (size_t i = 0; i < orbs.size(); i++) {
+    std::printf("%s %cP%d %d\n", orbs[i].id.c_str(), mode, plan.orbs[i].phase, plan.speed);
+  }
+  std::printf("group Z\n");
+
+  int periodMs = plan.speed * pulseSteps;
+  std::fprintf(stderr, "%zu orbs, period %d ms (speed %d)\n", orbs.size(), periodMs, plan.speed);
+  if (orbs.size() > 1 && worstNeighbourGapMs(orbs, plan) > periodMs / 2.0) {
+    std::fprintf(stderr, "wave is shorter than two orb gaps; it will look like it runs "
+                         "backwards, slow it or lengthen --period\n");
+  }
+  if (resyncS > 0) {
+    long periods = std::max(1L, std::lround(resyncS * 1000 / periodMs));
+    std::fprintf(stderr, "resend 'Z' every %ld ms (%ld periods)\n", periods * periodMs, periods);
+  }
+  return 0;
+}
+
+// ---- Simulation ----
+
+struct SimProfile {
+  const char *name;
+  double skewPpm;     // each orb's clock is off by up to this much
+  int latencyMs;      // 'Z' arrives this late ...
+  int jitterMs;       // ... plus up to this much more, per orb
+  int loopLateMs;     // loop() gets round to the pulse up to this late
+  double resyncS;     // 0 = one 'Z' only
+  bool freeRunning;
+};
+
+struct SimOrb {
+  OrbRenderState state;
+  double rate;         // local ms per true ms
+  uint32_t bootMs;     // millis() at true time 0
+  int64_t syncAtMs;    // true time the pending 'Z' lands, -1 = none
+  int64_t nextPollMs;  // true time loop() next looks at the pulse
+  uint32_t lastUpdate;
+  int freePos;         // free-running: steps counted since the 'Z'
+};
+
+struct SimResult {
+  std::vector<double> errorMs;     // |orb - wave|, every orb, every sample
+  std::vector<double> neighbourMs; // |error difference| of orbs next to each other
+  double inStep = 0;
+  size_t linkBytes = 0;
+};
+
+static double percentile(std::vector<double> &v, double p) {
+  if (v.empty()) return 0;
+  size_t k = std::min(v.size() - 1, (size_t)(p * v.size()));
+  std::nth_element(v.begin(), v.begin() + k, v.end());
+  return v[k];
+}
+
+// Shortest way round the period, in steps
+static double wrapSteps(double d) {
+  d = std::fmod(d, pulseSteps);
+  if (d > pulseSteps / 2.0) d -= pulseSteps;
+  if (d < -pulseSteps / 2.0) d += pulseSteps;
+  return d;
+}
+
+static SimResult simulate(const std::vector<GeoOrb> &orbs, const WavePlan &plan,
+                          const SimProfile &p, int minutes, uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  std::uniform_real_distribution<double> unit(-1.0, 1.0);
+  SimResult r;
+
+  const int64_t firstSyncMs = 5000;
+  const int64_t endMs = firstSyncMs + (int64_t)minutes * 60000;
+  const int periodMs = plan.speed * pulseSteps;
+  int64_t resyncMs = 0;
+  if (p.resyncS > 0) resyncMs = std::max(1L, std::lround(p.resyncS * 1000 / periodMs)) * periodMs;
+
+  std::vector<SimOrb> sim(orbs.size());
+  for (size_t i = 0; i < sim.size(); i++) {
+    SimOrb &o = sim[i];
+    o.rate = 1 + unit(rng) * p.skewPpm * 1e-6;
+    o.bootMs = (uint32_t)(rng() % 3600000);
+    o.syncAtMs = -1;
+    o.nextPollMs = 0;
+    o.lastUpdate = 0;
+    o.freePos = 0;
+    o.state.apply({'S', plan.speed});
+    o.state.apply({orbPhase, plan.orbs[i].phase});
+    char payload[32];
+    r.linkBytes += std::snprintf(payload, sizeof(payload), "GP%d %d\n", plan.orbs[i].phase,
+                                 plan.speed);
+  }
+
+  auto localMs = [](const SimOrb &o, int64_t t) {
+    return (uint32_t)(o.bootMs + (uint32_t)(int64_t)(t * o.rate));
+  };
+
+  size_t inStep = 0, samples = 0;
+  int64_t nextSyncMs = firstSyncMs;
+  for (int64_t t = 0; t < endMs; t++) {
+    if (t == nextSyncMs) {
+      for (SimOrb &o : sim) {
+        o.syncAtMs = t + p.latencyMs + (int64_t)(rng() % (uint64_t)(p.jitterMs + 1));
+      }
+      r.linkBytes += 1;
+      nextSyncMs = resyncMs > 0 ? t + resyncMs : -1;
+    }
+
+    for (SimOrb &o : sim) {
+      if (o.syncAtMs == t) {
+        o.state.sync(localMs(o, t));
+        o.freePos = o.state.wavePosition();
+        o.syncAtMs = -1;
+      }
+      if (t < o.nextPollMs) continue;
+      // loop(): the sketch's pulse check, reached a little late each time
+      o.nextPollMs = t + 1 + (int64_t)(rng() % (uint64_t)(p.loopLateMs + 1));
+      uint32_t now = localMs(o, t);
+      if (now - o.lastUpdate >= (uint32_t)o.state.periodMs()) {
+        o.lastUpdate = now;
+        o.state.setClock(now);
+        o.state.step();
+        if (++o.freePos == pulseSteps) o.freePos = 0;
+      }
+    }
+
+    // Sample every 10 ms once every orb has had the first 'Z'
+    if (t < firstSyncMs + p.latencyMs + p.jitterMs + 1 || t % 10) continue;
+    std::vector<double> errors(sim.size());
+    for (size_t i = 0; i < sim.size(); i++) {
+      double wave = plan.orbs[i].phase + (double)((t - firstSyncMs) / plan.speed);
+      int pos = p.freeRunning ? sim[i].freePos : sim[i].state.wavePosition();
+      errors[i] = wrapSteps(pos - wave) * plan.speed;
+      r.errorMs.push_back(std::fabs(errors[i]));
+      if (std::fabs(errors[i]) <= plan.speed) inStep++;
+      samples++;
+    }
+    for (size_t i = 1; i < sim.size(); i++) {
+      r.neighbourMs.push_back(std::fabs(errors[i] - errors[i - 1]));
+    }
+  }
+  r.inStep = samples ? (double)inStep / samples : 0;
+  return r;
+}
+
+// A street of orbs: about 12 m apart along it, either side of the road
+static std::vector<GeoOrb> streetOrbs(int count, uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  std::uniform_real_distribution<double> unit(-1.0, 1.0);
+  const double lat0 = 42.7314, lon0 = -73.6908;
+  std::vector<GeoOrb> out;
+  for (int i = 0; i < count; i++) {
+    double along = i * 12 + unit(rng) * 3;
+    double across = (i % 2 ? 6 : -6) + unit(rng);
+    double lat = lat0 + along / earthRadiusM / degToRad;
+    double lon = lon0 + across / (earthRadiusM * std::cos(lat0 * degToRad)) / degToRad;
+    out.push_back({"orb" + std::to_string(i), lat, lon});
+  }
+  return out;
+}
+
+static int runSim(int count, int minutes, uint64_t seed) {
+  std::vector<GeoOrb> orbs = streetOrbs(count, seed);
+  WaveShape shape;
+  shape.latitude = orbs[0].latitude;
+  shape.longitude = orbs[0].longitude;
+  WavePlan plan = planWave(orbs, shape);
+
+  // Crystal: about 50 ppm. A ceramic resonator, as on many AVR boards:
+  // a few thousand. Serial1 lands a 'Z' within a byte; a group topic over
+  // Wi-Fi takes tens of ms and varies orb to orb.
+  const SimProfile profiles[] = {
+      {"serial, crystal", 50, 1, 1, 2, 0, false},
+      {"serial, resonator", 3000, 1, 1, 2, 0, false},
+      {"serial, resonator, resync", 3000, 1, 1, 2, 60, false},
+      {"mqtt, crystal", 50, 20, 60, 2, 0, false},
+      {"mqtt, crystal, resync", 50, 20, 60, 2, 60, false},
+      {"free-running, crystal", 50, 1, 1, 2, 0, true},
+  };
+
+  double rounding = 0;
+  for (const OrbWave &w : plan.orbs) {
+    double exact = std::fmod(pulseSteps - std::fmod(w.delayMs / plan.speed, pulseSteps),
+                             pulseSteps);
+    rounding = std::max(rounding, std::fabs(wrapSteps(w.phase - exact)) * plan.speed);
+  }
+  std::printf("%d orbs over %.0f m, ripple at %.0f m/s, period %d ms (speed %d), %d min\n", count,
+              (count - 1) * 12.0, shape.metresPerSecond, plan.speed * pulseSteps, plan.speed,
+              minutes);
+  std::printf("phases are within %.0f ms of the exact delay\n", rounding);
+  std::printf("%-28s %8s %8s %8s %9s %8s %10s\n", "profile", "p50 ms", "p99 ms", "max ms",
+              "nbr p99", "in step", "link bytes");
+  for (const SimProfile &p : profiles) {
+    SimResult r = simulate(orbs, plan, p, minutes, seed);
+    double maxErr = r.errorMs.empty() ? 0 : *std::max_element(r.errorMs.begin(), r.errorMs.end());
+    std::printf("%-28s %8.0f %8.0f %8.0f %9.0f %7.1f%% %10zu\n", p.name,
+                percentile(r.errorMs, 0.5), percentile(r.errorMs, 0.99), maxErr,
+                percentile(r.neighbourMs, 0.99), 100 * r.inStep, r.linkBytes);
+  }
+  // What streaming the same wave would cost: a 5-byte 'F' frame per orb
+  // per step (host/frame_renderer.cpp)
+  double streamed = 5.0 * count * (minutes * 60000.0 / plan.speed);
+  std::printf("streaming every step instead: %.0f bytes\n", streamed);
+  return 0;
+}
+
+static bool parsePair(const char *text, double &a, double &b) {
+  return std::sscanf(text, "%lf,%lf", &a, &b) == 2;
+}
+
+int main(int argc, char **argv) {
+  WaveShape shape;
+  bool haveShape = false, sim = false;
+  char mode = 'W';
+  double resyncS = 0;
+  int simOrbs = 40, minutes = 10;
+  uint64_t seed = 1;
+  for (int i = 1; i < argc; i++) {
+    if (!std::strcmp(argv[i], "--ripple") && i + 1 < argc) {
+      shape.ripple = true;
+      haveShape = parsePair(argv[++i], shape.latitude, shape.longitude);
+    } else if (!std::strcmp(argv[i], "--sweep") && i + 1 < argc) {
+      shape.ripple = false;
+      shape.headingDeg = std::atof(argv[++i]);
+      haveShape = true;
+    } else if (!std::strcmp(argv[i], "--wave") && i + 1 < argc) {
+      shape.metresPerSecond = std::atof(argv[++i]);
+    } else if (!std::strcmp(argv[i], "--period") && i + 1 < argc) {
+      shape.periodMs = std::atof(argv[++i]);
+    } else if (!std::strcmp(argv[i], "--mode") && i + 1 < argc) {
+      mode = argv[++i][0];
+    } else if (!std::strcmp(argv[i], "--resync") && i + 1 < argc) {
+      resyncS = std::atof(argv[++i]);
+    } else if (!std::strcmp(argv[i], "--sim")) {
+      sim = true;
+    } else if (!std::strcmp(argv[i], "--orbs") && i + 1 < argc) {
+      simOrbs = std::max(2, std::atoi(argv[++i]));
+    } else if (!std::strcmp(argv[i], "--minutes") && i + 1 < argc) {
+      minutes = std::max(1, std::atoi(argv[++i]));
+    } else if (!std::strcmp(argv[i], "--seed") && i + 1 < argc) {
+      seed = std::strtoull(argv[++i], nullptr, 10);
+    } else {
+      haveShape = sim = false;
+      break;
+    }
+  }
+  if (sim) return runSim(simOrbs, minutes, seed);
+  if (!haveShape || shape.metresPerSecond <= 0) {
+    std::fprintf(stderr,
+                 "usage: %s (--ripple LAT,LON | --sweep DEG) [--wave M/S] [--period MS] "
+                 "[--mode X] [--resync S] < orbs\n       %s --sim [--orbs N] [--minutes N] "
+                 "[--seed N]\n",
+                 argv[0], argv[0]);
+    return 1;
+  }
+  return runPlan(shape, mode, resyncS);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+// Lock-free hand-off between the comms core and the render core.
+// Only used on boards with std::atomic (ESP32) and in the host build.
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+// Single-producer / single-consumer ring. Capacity must be a power of two.
+// push() is only called from one thread and pop() from one other thread.
+template <typename T, size_t Capacity>
+class SpscQueue {
+  static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+  bool push(const T &item) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) == Capacity) {
+      return false; // full, caller decides whether to drop
+    }
+    slots_[head & (Capacity - 1)] = item;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(T &item) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    item = slots_[tail & (Capacity - 1)];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  T slots_[Capacity];
+  // Kept on separate cache lines so the two cores don't fight over them
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+};
+
+// Double-buffered value with one writer and any number of readers.
+// The writer never waits; a reader that races a publish just retries.
+//
+// Each slot is a seqlock: its sequence is odd while the writer is filling
+// it. The value itself is held in relaxed atomic words, so a reader racing
+// the writer copies garbage it then throws away rather than a data race,
+// and the fences order those words against the sequence either side.
+template <typename T>
+class DoubleBuffer {
+  static_assert(std::is_trivially_copyable<T>::value, "T is copied word by word");
+
+public:
+  void publish(const T &value) {
+    uint32_t version = version_.load(std::memory_order_relaxed);
+    Slot &slot = slots_[(version + 1) & 1];
+    uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+
+    uint32_t words[Words] = {};
+    memcpy(words, &value, sizeof(T));
+    slot.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < Words; i++) slot.words[i].store(words[i], std::memory_order_relaxed);
+    slot.seq.store(seq + 2, std::memory_order_release);
+
+    version_.store(version + 1, std::memory_order_release);
+  }
+
+  // Cheap "anything new?" check before paying for a copy
+  uint32_t version() const { return version_.load(std::memory_order_acquire); }
+
+  // Returns the publish count the copy belongs to (0 = nothing published
+  // yet). If the writer laps a slow reader the copy can be newer than that.
+  uint32_t read(T &out) const {
+    for (;;) {
+      uint32_t version = version_.load(std::memory_order_acquire);
+      const Slot &slot = slots_[version & 1];
+      uint32_t before = slot.seq.load(std::memory_order_acquire);
+      if (before & 1) continue; // being written
+
+      uint32_t words[Words];
+      for (size_t i = 0; i < Words; i++) words[i] = slot.words[i].load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.seq.load(std::memory_order_relaxed) == before) {
+        memcpy(&out, words, sizeof(T));
+        return version;
+      }
+    }
+  }
+
+private:
+  static const size_t Words = (sizeof(T) + 3) / 4;
+
+  struct Slot {
+    std::atomic<uint32_t> seq{0};
+    std::atomic<uint32_t> words[Words] = {};
+  };
+
+  Slot slots_[2];
+  std::atomic<uint32_t> version_{0};
+};
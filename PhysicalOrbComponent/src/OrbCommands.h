@@ -0,0 +1,163 @@
+#pragma once
+
+// Compile-time command table for the Serial1 link. Every command byte is
+// declared once, next to its handler:
+//
+//   void onMode(char c);
+//   void onSpeed(char c);
+//   typedef OrbCommandTable<
+//       OrbOn<'O', onMode>, OrbOn<'G', onMode>,
+//       OrbOnRange<'0', '9', onSpeed>> Commands;
+//   ...
+//   if (!Commands::dispatch(c)) errors++;
+//
+// The table is indexed by the command byte itself (minus the lowest one
+// declared), so finding a handler costs one subtraction, one bounds check
+// and one read, however many commands there are. The slots are
+// const and, on AVR, PROGMEM, so they take flash and no SRAM: one pointer
+// per byte between the lowest and highest command (see
+// host/command_dispatch_bench.cpp for sizes and cycle counts).
+//
+// Handlers get the byte that picked them and read any payload themselves.
+// Two entries for the same byte is a compile error.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__AVR__)
+#include <avr/pgmspace.h>
+#define ORB_TABLE_ATTR PROGMEM
+#define orbReadHandler(slot) ((OrbCommandHandler)pgm_read_ptr(slot))
+#else
+#define ORB_TABLE_ATTR
+#define orbReadHandler(slot) (*(slot))
+#endif
+
+typedef void (*OrbCommandHandler)(char);
+
+template <char Key, OrbCommandHandler Handler>
+struct OrbOn {
+  static constexpr uint8_t first = (uint8_t)Key;
+  static constexpr uint8_t last = (uint8_t)Key;
+  static constexpr OrbCommandHandler handler = Handler;
+};
+
+// Every byte from First to Last, e.g. the digits of a number
+template <char First, char Last, OrbCommandHandler Handler>
+struct OrbOnRange {
+  static_assert((uint8_t)First <= (uint8_t)Last, "range is backwards");
+  static constexpr uint8_t first = (uint8_t)First;
+  static constexpr uint8_t last = (uint8_t)Last;
+  static constexpr OrbCommandHandler handler = Handler;
+};
+
+namespace orb_detail {
+
+// Plain C++11 stand-ins for what <utility> and fold expressions give later
+template <unsigned... I>
+struct Indices {};
+
+template <unsigned N, unsigned... I>
+struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+
+template <unsigned... I>
+struct MakeIndices<0, I...> {
+  typedef Indices<I...> type;
+};
+
+template <typename... Commands>
+struct Bounds;
+
+template <>
+struct Bounds<> {
+  static constexpr uint8_t low = 255;
+  static constexpr uint8_t high = 0;
+};
+
+template <typename Command, typename... Rest>
+struct Bounds<Command, Rest...> {
+  static constexpr uint8_t low =
+      Command::first < Bounds<Rest...>::low ? Command::first : Bounds<Rest...>::low;
+  static constexpr uint8_t high =
+      Command::last > Bounds<Rest...>::high ? Command::last : Bounds<Rest...>::high;
+};
+
+// How many of the commands claim byte c
+template <typename... Commands>
+struct Claims;
+
+template <>
+struct Claims<> {
+  static constexpr unsigned count(uint8_t) { return 0; }
+};
+
+template <typename Command, typename... Rest>
+struct Claims<Command, Rest...> {
+  static constexpr unsigned count(uint8_t c) {
+    return (c >= Command::first && c <= Command::last ? 1 : 0) + Claims<Rest...>::count(c);
+  }
+};
+
+template <typename... Commands>
+struct Lookup;
+
+template <>
+struct Lookup<> {
+  static constexpr OrbCommandHandler at(uint8_t) { return nullptr; }
+};
+
+template <typename Command, typename... Rest>
+struct Lookup<Command, Rest...> {
+  static constexpr OrbCommandHandler at(uint8_t c) {
+    return c >= Command::first && c <= Command::last ? Command::handler
+                                                     : Lookup<Rest...>::at(c);
+  }
+};
+
+inline constexpr bool allOf() { return true; }
+
+template <typename... B>
+constexpr bool allOf(bool first, B... rest) {
+  return first && allOf(rest...);
+}
+
+template <uint8_t Low, typename Seq, typename... Commands>
+struct Slots;
+
+template <uint8_t Low, unsigned... I, typename... Commands>
+struct Slots<Low, Indices<I...>, Commands...> {
+  static constexpr bool distinct =
+      allOf(Claims<Commands...>::count((uint8_t)(Low + I)) <= 1 ...);
+  static const OrbCommandHandler table[sizeof...(I)];
+};
+
+template <uint8_t Low, unsigned... I, typename... Commands>
+const OrbCommandHandler Slots<Low, Indices<I...>, Commands...>::table[sizeof...(I)]
+    ORB_TABLE_ATTR = {Lookup<Commands...>::at((uint8_t)(Low + I))...};
+
+} // namespace orb_detail
+
+template <typename... Commands>
+class OrbCommandTable {
+  static_assert(sizeof...(Commands) > 0, "empty command table");
+
+  static constexpr uint8_t low = orb_detail::Bounds<Commands...>::low;
+  static constexpr unsigned span = orb_detail::Bounds<Commands...>::high - low + 1;
+  typedef orb_detail::Slots<low, typename orb_detail::MakeIndices<span>::type, Commands...>
+      Slots;
+  static_assert(Slots::distinct, "two commands claim the same byte");
+
+public:
+  // Slots the table takes, each one OrbCommandHandler
+  static constexpr unsigned size = span;
+
+  // Runs the handler for c; false if no command uses it
+  static bool dispatch(char c) {
+    uint8_t slot = (uint8_t)((uint8_t)c - low);
+    if (slot >= span) return false;
+    OrbCommandHandler handler = orbReadHandler(&Slots::table[slot]);
+    if (!handler) return false;
+    handler(c);
+    return true;
+  }
+};
@@ -0,0 +1,13 @@
+#pragma once
+
+// Per-orb settings for networked (ESP32) orbs, read by OrbMqtt.h. Copy
+// this file to OrbConfig.h next to it; that copy is git-ignored, so each
+// orb's credentials and id stay on the machine that flashes it.
+
+const char *const wifiSsid = "your-network";
+const char *const wifiPassword = "your-password";
+const char *const mqttBroker = "192.168.1.10";
+const int mqttPort = 1883;
+// Unique per orb: its retained state lives at orbs/<orbId>/state
+const char *const orbId = "orb-1";
+const char *const orbGroup = "default";
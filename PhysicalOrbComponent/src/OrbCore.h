@@ -0,0 +1,211 @@
+#pragma once
+
+// Colour and pulse logic of the orb, shared by every build of it: the AVR
+// sketch, the ESP32 variant, the host tools and the app's live preview
+// (modules/orb-preview). Plain C++11 with no Arduino calls, so it also
+// compiles with avr-gcc.
+
+#include <stdint.h>
+#include "OrbFixed.h"
+#include "OrbNoise.h"
+#include "OrbProtocol.h"
+
+// One full pulse is 0 -> 255 -> 0, one brightness step per tick
+const int pulseSteps = 510;
+
+struct OrbFrame {
+  uint8_t red, green, blue; // values written to the pins (common anode)
+  int brightness;
+  char mode;
+  uint32_t tick;
+};
+
+// Pin level targets at full brightness for a colour mode
+inline void orbTargets(char mode, int &rT, int &gT, int &bT) {
+  // Colour targets (Based on Common Anode: 0 is full, 255 is off)
+  switch (mode) {
+    case 'O': rT = 0;   gT = 150; bT = 255; break; // Orange
+    case 'G': rT = 255; gT = 0;   bT = 255; break; // Green
+    case 'R': rT = 0;   gT = 255; bT = 255; break; // Red
+    case 'C': rT = 0;   gT = 110; bT = 230; break; // Candle
+    case 'W':                                      // White
+    default:  rT = 0;   gT = 0;   bT = 0;   break;
+  }
+}
+
+// map(brightness, 0, 255, 255, target), bit for bit, without its long
+// division: the pin drops from 255 by brightness/255 of the way to target
+inline uint8_t orbMapLevel(int brightness, int target) {
+  return (uint8_t)(255 - orbScale8((uint8_t)(255 - target), (uint8_t)brightness));
+}
+
+struct OrbLevels {
+  uint8_t red, green, blue;
+};
+
+// One pulse period rendered ahead of time. The pulse only ever shows the
+// 256 brightness levels (up, then back down) and pulseSpeed only changes
+// how often a tick comes, so a table per mode covers every tick: rebuilt
+// when the mode changes, then each tick is one indexed read instead of
+// three scale8s.
+//
+// Bytes is the SRAM budget. 768 holds every level exactly; smaller budgets
+// keep every 2nd, 4th or 8th level (see host/period_cache_sim.cpp for how
+// far each is off). Below 96 bytes the cache is off and step() computes
+// every tick live.
+template <unsigned Bytes>
+class OrbPeriodCache {
+public:
+  static const int levels = Bytes >= 768 ? 256 : Bytes >= 384 ? 128 : Bytes >= 192 ? 64
+                          : Bytes >= 96 ? 32 : 0;
+  static const int shift = levels == 256 ? 0 : levels == 128 ? 1 : levels == 64 ? 2 : 3;
+
+  bool enabled() const { return levels > 0; }
+  bool holds(char mode) const { return builtMode == mode; }
+
+  const OrbLevels &at(int brightness) const { return table[brightness >> shift]; }
+
+  // Keeps the level in the middle of each slot. orbMapLevel has no
+  // division any more, so only the kept levels are computed.
+  void build(char mode) {
+    if (!enabled()) return;
+    int rT, gT, bT;
+    orbTargets(mode, rT, gT, bT);
+
+    const int keep = (1 << shift) >> 1;
+    for (int i = 0; i < levels; i++) {
+      int brightness = (i << shift) | keep;
+      OrbLevels &entry = table[i];
+      entry.red = orbMapLevel(brightness, rT);
+      entry.green = orbMapLevel(brightness, gT);
+      entry.blue = orbMapLevel(brightness, bT);
+    }
+    builtMode = mode;
+  }
+
+private:
+  OrbLevels table[levels > 0 ? levels : 1];
+  char builtMode = 0;
+};
+
+class OrbRenderState {
+public:
+  void apply(const OrbCommand &cmd) {
+    if (cmd.kind == 'M') {
+      currentMode = (char)cmd.value;
+    } else if (cmd.kind == 'S') {
+      pulseSpeed = cmd.value;
+    } else if (cmd.kind == orbPhase) {
+      setPhase(cmd.value);
+    } else if (cmd.kind == orbSync) {
+      sync((uint32_t)cmd.value);
+    }
+  }
+
+  // Locks the pulse to the clock from atMs, phase steps into the period.
+  // The ESP32 passes atMs through OrbCommand::value, which needs its
+  // 32-bit int; the AVR sketch calls this directly.
+  void sync(uint32_t atMs) {
+    locked = true;
+    wavePos = phase;
+    waveDueMs = atMs + (uint32_t)periodMs();
+  }
+
+  // Where in the pulse a locked orb starts, in steps. Moving it after the
+  // sync moves the orb by the difference.
+  void setPhase(int steps) {
+    uint16_t next = (uint16_t)(steps % pulseSteps);
+    if (locked) wavePos = (uint16_t)((wavePos + pulseSteps - phase + next) % pulseSteps);
+    phase = next;
+  }
+
+  // The orb's millis(), before each step. Only a synced orb uses it.
+  void setClock(uint32_t nowMs) { clockMs = nowMs; }
+
+  // Steps into the period a synced orb is, 0..pulseSteps-1
+  int wavePosition() const { return wavePos; }
+
+  // Per orb, so candles side by side don't flicker together
+  void seed(uint16_t seed) { candle.reseed(seed); }
+
+  // Pulse period per step in ms. A speed of 0 still has to yield on a task.
+  int periodMs() const { return pulseSpeed > 0 ? pulseSpeed : 1; }
+
+  OrbFrame step() {
+    int rT, gT, bT;
+    orbTargets(currentMode, rT, gT, bT);
+    advance();
+    return frame(orbMapLevel(brightness, rT), orbMapLevel(brightness, gT),
+                 orbMapLevel(brightness, bT));
+  }
+
+  // Same frames, read from cache; builds it on the first tick of a new mode
+  template <unsigned Bytes>
+  OrbFrame step(OrbPeriodCache<Bytes> &cache) {
+    if (!cache.enabled()) return step();
+    if (!cache.holds(currentMode)) cache.build(currentMode);
+    advance();
+    const OrbLevels &levels = cache.at(brightness);
+    return frame(levels.red, levels.green, levels.blue);
+  }
+
+private:
+  // Saturates at either end, so whatever the step the level never leaves
+  // 0..255 before the direction flips. A candle takes its level from the
+  // noise instead, and a pulse picks up from wherever it left off.
+  //
+  // A synced orb steps once for every periodMs() its clock has moved on,
+  // however late the tick is, so a slow loop() doesn't put it behind the
+  // others. Only sync() and setPhase() divide.
+  void advance() {
+    if (currentMode == orbCandleMode) {
+      brightness = candle.next();
+      return;
+    }
+    if (locked) {
+      while ((int32_t)(clockMs - waveDueMs) >= 0) {
+        waveDueMs += (uint32_t)periodMs();
+        if (++wavePos == pulseSteps) wavePos = 0;
+      }
+      brightness = (uint8_t)(wavePos <= 255 ? wavePos : pulseSteps - wavePos);
+      return;
+    }
+    brightness = orbAddSat(brightness, fadeDirection);
+    if (brightness == 255 || brightness == 0) {
+      fadeDirection = (int8_t)-fadeDirection;
+    }
+  }
+
+  OrbFrame frame(uint8_t red, uint8_t green, uint8_t blue) {
+    OrbFrame out;
+    out.red = red;
+    out.green = green;
+    out.blue = blue;
+    out.brightness = brightness;
+    out.mode = currentMode;
+    out.tick = ++ticks;
+    return out;
+  }
+
+  char currentMode = 'W';
+  uint8_t brightness = 0;
+  int8_t fadeDirection = 1;
+  int pulseSpeed = 20;
+  uint32_t ticks = 0;
+  OrbCandle candle;
+  bool locked = false;
+  uint16_t phase = 0;
+  uint16_t wavePos = 0;
+  uint32_t waveDueMs = 0;
+  uint32_t clockMs = 0;
+};
+
+// Renders one full pulse period for mode into out[pulseSteps], starting
+// from a dark orb. Entry i is the frame after i + 1 ticks.
+inline void renderOrbPeriod(char mode, OrbFrame *out) {
+  OrbRenderState state;
+  state.apply({'M', mode});
+  for (int i = 0; i < pulseSteps; i++) {
+    out[i] = state.step();
+  }
+}
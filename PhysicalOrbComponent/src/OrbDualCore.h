@@ -0,0 +1,154 @@
+#pragma once
+
+// ESP32 board variant: rendering is pinned to one core and Serial1 / radio
+// handling runs on the other, so a stalled radio can't hitch the pulse.
+// Commands go comms -> render through an SPSC queue (Serial1) or a coalescing
+// double buffer (MQTT, see OrbMqtt.h). Nothing on the render path locks.
+//
+// One pass of each task is below, outside the ESP32 block, so
+// host/dual_core_sim.cpp runs these same loop bodies on two threads.
+
+#include <stdint.h>
+#include "OrbChannels.h"
+#include "OrbCore.h"
+#include "OrbMqtt.h"
+#include "OrbProtocol.h"
+
+typedef SpscQueue<OrbCommand, 32> OrbCommandQueue;
+
+// The render core's state between ticks
+struct OrbRenderCore {
+  OrbRenderState state;
+  OrbPeriodCache<768> pulseCache; // every level, exact
+  uint32_t targetSeen = 0;
+  uint16_t syncsSeen = 0;
+
+  OrbFrame tick(OrbCommandQueue &commands, const DoubleBuffer<OrbTarget> &target,
+                unsigned long nowMs) {
+    OrbCommand cmd;
+    while (commands.pop(cmd)) {
+      state.apply(cmd);
+    }
+
+    // Only the newest MQTT state matters, however many arrived since last tick
+    if (target.version() != targetSeen) {
+      OrbTarget newest;
+      targetSeen = target.read(newest);
+      if (newest.mode) state.apply({'M', newest.mode});
+      if (newest.pulseSpeed >= 0) state.apply({'S', newest.pulseSpeed});
+      if (newest.phase >= 0) state.apply({orbPhase, newest.phase});
+      if (newest.syncs != syncsSeen) {
+        syncsSeen = newest.syncs;
+        state.sync(newest.syncedAtMs);
+      }
+    }
+
+    state.setClock(nowMs);
+    return state.step(pulseCache);
+  }
+};
+
+const unsigned long parseTimeoutMs = 1000; // same as Stream::setTimeout default
+
+// The comms core's state between polls. Link is Serial1 on the orb: it
+// needs available(), read() and write().
+struct OrbCommsCore {
+  OrbCommandParser parser;
+  OrbLiveness liveness;
+  unsigned long lastByte = 0;
+
+  template <typename Link>
+  void poll(Link &link, OrbCommandQueue &commands, unsigned long nowMs) {
+    OrbCommand out[2];
+    while (link.available() > 0) {
+      int n = parser.feed((char)link.read(), out);
+      for (int i = 0; i < n; i++) {
+        if (out[i].kind == orbStatusQuery) {
+          uint8_t reply[orbStatusLength];
+          parser.status(reply);
+          link.write(reply, sizeof(reply));
+        } else if (out[i].kind == orbHeartbeat) {
+          liveness.beat(nowMs);
+          link.write(orbHeartbeatReply);
+        } else if (out[i].kind == orbSync) {
+          // Stamped here: the render core may not pop it until its next tick
+          commands.push({orbSync, (int)nowMs});
+        } else {
+          commands.push(out[i]); // full queue means a flood; drop it
+        }
+      }
+      lastByte = nowMs;
+    }
+    if (parser.pending() && nowMs - lastByte >= parseTimeoutMs) {
+      if (parser.flush(out[0])) commands.push(out[0]);
+    }
+    if (liveness.lapsed(nowMs)) {
+      commands.push({'M', orbSafeMode});
+      commands.push({'S', orbSafeSpeed});
+    }
+  }
+};
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <Arduino.h>
+
+// GPIO 9-11 are wired to the flash chip on ESP32 modules, so this board
+// uses different LED and Serial1 pins from the AVR orb.
+const int redPin = 25;
+const int greenPin = 26;
+const int bluePin = 27;
+const int linkRxPin = 16;
+const int linkTxPin = 17;
+
+const int renderCore = 1;
+const int commsCore = 0; // Wi-Fi stack also lives on core 0
+
+static OrbCommandQueue orbCommands;
+
+static void renderTask(void *) {
+  static OrbRenderCore render;
+  render.state.seed((uint16_t)esp_random());
+  TickType_t lastWake = xTaskGetTickCount();
+
+  for (;;) {
+    OrbFrame frame = render.tick(orbCommands, mqttTarget, millis());
+    analogWrite(redPin, frame.red);
+    analogWrite(greenPin, frame.green);
+    analogWrite(bluePin, frame.blue);
+
+    // pdMS_TO_TICKS rounds down, to 0 for a period under one tick (10 ms at
+    // a 100 Hz tick), and vTaskDelayUntil asserts on a zero increment.
+    // Faster speeds step once a tick.
+    TickType_t period = pdMS_TO_TICKS(render.state.periodMs());
+    vTaskDelayUntil(&lastWake, period > 0 ? period : 1);
+  }
+}
+
+static void commsTask(void *) {
+  OrbCommsCore comms;
+
+  for (;;) {
+    comms.poll(Serial1, orbCommands, millis());
+    mqttPoll();
+    vTaskDelay(1);
+  }
+}
+
+void setup() {
+  Serial.begin(115200);
+  Serial1.begin(9600, SERIAL_8N1, linkRxPin, linkTxPin);
+  pinMode(redPin, OUTPUT);
+  pinMode(greenPin, OUTPUT);
+  pinMode(bluePin, OUTPUT);
+  mqttSetup();
+
+  xTaskCreatePinnedToCore(renderTask, "orbRender", 4096, NULL, 3, NULL, renderCore);
+  xTaskCreatePinnedToCore(commsTask, "orbComms", 4096, NULL, 1, NULL, commsCore);
+}
+
+// Everything runs in the pinned tasks
+void loop() {
+  vTaskDelete(NULL);
+}
+
+#endif
@@ -0,0 +1,146 @@
+#pragma once
+
+// Saturating fixed-point maths for the orb's colour and timing code. Plain
+// C++11 with no Arduino calls and no divisions, so on AVR nothing here
+// reaches __divmodsi4 and an 8-bit value can't wrap past 255 or 0.
+//
+//   orbAddSat(a, delta)    a + delta, clamped to a's type
+//   orbScale8(x, scale)    x * scale / 255, exactly (scale 255 leaves x alone)
+//   orbLerp8(a, b, t)      a -> b as t goes 0 -> 255, both ends exact
+//   OrbQ<T, Frac>          signed or unsigned Q-format number in T with Frac
+//                          fraction bits; + - * saturate, * rounds
+//
+// The one divisor the colour maths has is 255, and orbDiv255() replaces
+// it with a multiply-free reciprocal (see host/fixed_point_bench.cpp for
+// the exhaustive check and what each costs against map()).
+
+#include <stdint.h>
+
+template <typename T>
+struct OrbFixedTraits;
+
+// Sum holds any T + T and T - T; Product holds any T * T
+template <>
+struct OrbFixedTraits<uint8_t> {
+  typedef int16_t Sum;
+  typedef uint16_t Product;
+  static constexpr int32_t min = 0, max = 255;
+};
+
+template <>
+struct OrbFixedTraits<int8_t> {
+  typedef int16_t Sum;
+  typedef int16_t Product;
+  static constexpr int32_t min = -128, max = 127;
+};
+
+template <>
+struct OrbFixedTraits<uint16_t> {
+  typedef int32_t Sum;
+  typedef uint32_t Product;
+  static constexpr int32_t min = 0, max = 65535;
+};
+
+template <>
+struct OrbFixedTraits<int16_t> {
+  typedef int32_t Sum;
+  typedef int32_t Product;
+  static constexpr int32_t min = -32768, max = 32767;
+};
+
+template <typename T, typename Wide>
+inline T orbSaturate(Wide v) {
+  typedef OrbFixedTraits<T> Traits;
+  if (v < (Wide)Traits::min) return (T)Traits::min;
+  if (v > (Wide)Traits::max) return (T)Traits::max;
+  return (T)v;
+}
+
+template <typename T>
+inline T orbAddSat(T a, typename OrbFixedTraits<T>::Sum delta) {
+  typedef typename OrbFixedTraits<T>::Sum Sum;
+  return orbSaturate<T>((Sum)((Sum)a + delta));
+}
+
+// x / 255 for x up to 255 * 255, as 257/65536 plus a correction. Exact
+// over the whole range and stays inside 16 bits, so it's a handful of
+// 8-bit instructions on AVR.
+inline uint8_t orbDiv255(uint16_t x) {
+  return (uint8_t)((uint16_t)(x + 1 + (x >> 8)) >> 8);
+}
+
+inline uint8_t orbScale8(uint8_t x, uint8_t scale) {
+  return orbDiv255((uint16_t)((uint16_t)x * scale));
+}
+
+inline uint8_t orbLerp8(uint8_t a, uint8_t b, uint8_t t) {
+  return b >= a ? (uint8_t)(a + orbScale8((uint8_t)(b - a), t))
+                : (uint8_t)(a - orbScale8((uint8_t)(a - b), t));
+}
+
+template <typename T, int Frac>
+class OrbQ {
+  typedef OrbFixedTraits<T> Traits;
+  typedef typename Traits::Sum Sum;
+  typedef typename Traits::Product Product;
+  static_assert(Frac > 0 && Frac <= (int)sizeof(T) * 8, "bad fraction width");
+
+public:
+  static const int fracBits = Frac;
+
+  constexpr OrbQ() : value(0) {}
+
+  static constexpr OrbQ fromRaw(T raw) { return OrbQ(raw, 0); }
+
+  static OrbQ fromInt(int v) {
+    return fromRaw(orbSaturate<T>((int32_t)v * ((int32_t)1 << Frac)));
+  }
+
+  static OrbQ max() { return fromRaw((T)Traits::max); }
+  static OrbQ min() { return fromRaw((T)Traits::min); }
+
+  constexpr T raw() const { return value; }
+
+  // Rounds towards minus infinity, like a shift
+  int toInt() const { return (int)(value >> Frac); }
+
+  OrbQ operator+(OrbQ o) const { return fromRaw(orbSaturate<T>((Sum)((Sum)value + o.value))); }
+  OrbQ operator-(OrbQ o) const { return fromRaw(orbSaturate<T>((Sum)((Sum)value - o.value))); }
+
+  OrbQ operator*(OrbQ o) const {
+    Product p = (Product)value * o.value;
+    // Round to nearest before dropping the extra fraction bits
+    p = (Product)(p + ((Product)1 << (Frac - 1)));
+    return fromRaw(orbSaturate<T>((Product)(p >> Frac)));
+  }
+
+  OrbQ &operator+=(OrbQ o) { return *this = *this + o; }
+  OrbQ &operator-=(OrbQ o) { return *this = *this - o; }
+  OrbQ &operator*=(OrbQ o) { return *this = *this * o; }
+
+  bool operator==(OrbQ o) const { return value == o.value; }
+  bool operator!=(OrbQ o) const { return value != o.value; }
+  bool operator<(OrbQ o) const { return value < o.value; }
+  bool operator>(OrbQ o) const { return value > o.value; }
+  bool operator<=(OrbQ o) const { return value <= o.value; }
+  bool operator>=(OrbQ o) const { return value >= o.value; }
+
+private:
+  constexpr OrbQ(T raw, int) : value(raw) {}
+
+  T value;
+};
+
+// a + (b - a) * t, t in [0, 1) as UQ0.8. t = 0 gives a exactly; use
+// orbLerp8 where t = 255 has to land on b.
+template <typename T, int Frac>
+inline OrbQ<T, Frac> orbLerp(OrbQ<T, Frac> a, OrbQ<T, Frac> b, OrbQ<uint8_t, 8> t) {
+  typedef int32_t Wide;
+  Wide step = ((Wide)b.raw() - a.raw()) * t.raw();
+  // Arithmetic shift rounds down for a falling lerp as well as a rising one
+  return OrbQ<T, Frac>::fromRaw(orbSaturate<T>((Wide)a.raw() + (step >> 8)));
+}
+
+// Common formats: unit brightness and a signed per-tick step
+typedef OrbQ<uint8_t, 8> OrbUQ0_8;
+typedef OrbQ<int16_t, 8> OrbQ8_8;
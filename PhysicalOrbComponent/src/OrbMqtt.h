@@ -0,0 +1,121 @@
+#pragma once
+
+// MQTT transport for networked (ESP32) orbs. Payloads use the same command
+// bytes as Serial1, e.g. "G20" = green, 20 ms pulse step.
+//
+//   orbs/<orbId>/state   retained, so a reconnecting orb gets its state at once
+//   groups/<group>/state broadcasts to every orb in the group
+//
+// A burst of messages is merged into one OrbTarget and handed to the render
+// core through a DoubleBuffer, so the renderer only ever sees the newest state.
+//
+// A wave's phase goes on the retained orb topic with the mode and speed
+// ("GP137 20"); its 'Z' goes on the group topic and must not be retained,
+// or a reconnecting orb would sync to the wrong moment.
+
+#include <stddef.h>
+#include <stdio.h>
+#include "OrbChannels.h"
+#include "OrbProtocol.h"
+
+struct OrbTarget {
+  char mode;           // 0 = not set yet
+  int pulseSpeed;      // -1 = not set yet
+  int phase;           // -1 = not set yet
+  uint16_t syncs;      // 'Z's seen; the renderer syncs when it changes
+  uint32_t syncedAtMs; // millis() when the last one arrived
+};
+
+// Folds one payload into target. Returns true if anything was set.
+inline bool applyOrbPayload(const char *payload, size_t length, OrbTarget &target) {
+  OrbCommandParser parser;
+  OrbCommand out[2];
+  bool changed = false;
+
+  for (size_t i = 0; i <= length; i++) {
+    int n;
+    if (i < length) {
+      n = parser.feed(payload[i], out);
+    } else {
+      n = parser.flush(out[0]) ? 1 : 0; // end of payload ends the number
+    }
+    for (int j = 0; j < n; j++) {
+      if (out[j].kind == 'M') {
+        target.mode = (char)out[j].value;
+      } else if (out[j].kind == 'S') {
+        target.pulseSpeed = out[j].value;
+      } else if (out[j].kind == orbPhase) {
+        target.phase = out[j].value;
+      } else if (out[j].kind == orbSync) {
+        target.syncs++;
+      } else {
+        continue; // a status query means nothing on a retained topic
+      }
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+inline void orbStateTopic(char *buf, size_t size, const char *orbId) {
+  snprintf(buf, size, "orbs/%s/state", orbId);
+}
+
+inline void groupStateTopic(char *buf, size_t size, const char *group) {
+  snprintf(buf, size, "groups/%s/state", group);
+}
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <Arduino.h>
+#include <PubSubClient.h>
+#include <WiFi.h>
+
+// Wi-Fi credentials, broker and this orb's id and group. They differ per
+// orb and must not be committed: copy OrbConfig.example.h to OrbConfig.h
+// (git-ignored) and fill it in before flashing.
+#if __has_include("OrbConfig.h")
+#include "OrbConfig.h"
+#else
+#error "src/OrbConfig.h is missing: copy src/OrbConfig.example.h and fill it in"
+#endif
+
+static WiFiClient mqttSocket;
+static PubSubClient mqtt(mqttSocket);
+static OrbTarget mqttState = {0, -1, -1, 0, 0};
+static DoubleBuffer<OrbTarget> mqttTarget;
+static unsigned long lastMqttAttempt = 0;
+
+static void onMqttMessage(char *, byte *payload, unsigned int length) {
+  uint16_t syncs = mqttState.syncs;
+  if (applyOrbPayload((const char *)payload, length, mqttState)) {
+    if (mqttState.syncs != syncs) mqttState.syncedAtMs = millis();
+    mqttTarget.publish(mqttState);
+  }
+}
+
+static void mqttSetup() {
+  WiFi.mode(WIFI_STA);
+  WiFi.begin(wifiSsid, wifiPassword);
+  mqtt.setServer(mqttBroker, mqttPort);
+  mqtt.setCallback(onMqttMessage);
+}
+
+// Called from the comms task; never blocks for more than one connect attempt
+static void mqttPoll() {
+  if (WiFi.status() != WL_CONNECTED) return;
+
+  if (!mqtt.connected()) {
+    if (millis() - lastMqttAttempt < 2000) return;
+    lastMqttAttempt = millis();
+    if (!mqtt.connect(orbId)) return;
+
+    char topic[64];
+    orbStateTopic(topic, sizeof(topic), orbId);
+    mqtt.subscribe(topic);
+    groupStateTopic(topic, sizeof(topic), orbGroup);
+    mqtt.subscribe(topic);
+  }
+  mqtt.loop();
+}
+
+#endif
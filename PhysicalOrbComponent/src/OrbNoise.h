@@ -0,0 +1,154 @@
+#pragma once
+
+// Integer value noise for the candle effect ('C', see OrbCore.h), cheap
+// enough for every tick on AVR. Coordinates are UQ8.8 lattice units:
+// the high byte picks the lattice cell, the low byte is how far across
+// it, and the lattice wraps every 256 cells without a seam. Each lattice
+// point gets a hashed byte, eased between by a smoothstep table, and
+// fractal() layers octaves at double the frequency and half the weight.
+// No divisions and nothing wider than 16 bits.
+//
+// Each orb seeds its own noise, so orbs next to each other don't flicker
+// in step. host/candle_noise_sim.cpp has cycles per sample and compares
+// the flicker with recorded flame traces.
+
+#include <stdint.h>
+#include "OrbFixed.h"
+
+#if defined(__AVR__)
+#include <avr/pgmspace.h>
+#define orbReadByte(p) pgm_read_byte(p)
+#define orbReadWord(p) pgm_read_word(p)
+#define ORB_NOISE_TABLE_ATTR PROGMEM
+#else
+#define orbReadByte(p) (*(p))
+#define orbReadWord(p) (*(p))
+#define ORB_NOISE_TABLE_ATTR
+#endif
+
+// 256 * (3t^2 - 2t^3) for t = i / 256, capped at 255 so orbLerp8 lands on
+// the next lattice value as the cell ends
+static const uint8_t orbSmoothstep[256] ORB_NOISE_TABLE_ATTR = {
+    0,   0,   0,   0,   0,   0,   0,   1,   1,   1,   1,   1,   2,   2,   2,   3,
+    3,   3,   4,   4,   4,   5,   5,   6,   6,   7,   7,   8,   9,   9,   10,  10,
+    11,  12,  12,  13,  14,  14,  15,  16,  17,  18,  18,  19,  20,  21,  22,  23,
+    24,  25,  25,  26,  27,  28,  29,  30,  31,  32,  33,  35,  36,  37,  38,  39,
+    40,  41,  42,  43,  45,  46,  47,  48,  49,  51,  52,  53,  54,  56,  57,  58,
+    59,  61,  62,  63,  65,  66,  67,  69,  70,  71,  73,  74,  75,  77,  78,  80,
+    81,  82,  84,  85,  87,  88,  90,  91,  92,  94,  95,  97,  98,  100, 101, 103,
+    104, 106, 107, 109, 110, 112, 113, 115, 116, 118, 119, 121, 122, 124, 125, 127,
+    128, 129, 131, 132, 134, 135, 137, 138, 140, 141, 143, 144, 146, 147, 149, 150,
+    152, 153, 155, 156, 158, 159, 161, 162, 164, 165, 166, 168, 169, 171, 172, 174,
+    175, 176, 178, 179, 181, 182, 183, 185, 186, 187, 189, 190, 191, 193, 194, 195,
+    197, 198, 199, 200, 202, 203, 204, 205, 207, 208, 209, 210, 211, 213, 214, 215,
+    216, 217, 218, 219, 220, 221, 223, 224, 225, 226, 227, 228, 229, 230, 231, 231,
+    232, 233, 234, 235, 236, 237, 238, 238, 239, 240, 241, 242, 242, 243, 244, 244,
+    245, 246, 246, 247, 247, 248, 249, 249, 250, 250, 251, 251, 252, 252, 252, 253,
+    253, 253, 254, 254, 254, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+};
+
+// Octave weights for 1..4 octaves; each row sums to 256, so layering is
+// a shift rather than a divide
+static const uint16_t orbOctaveWeights[4][4] ORB_NOISE_TABLE_ATTR = {
+    {256, 0, 0, 0},
+    {171, 85, 0, 0},
+    {146, 73, 37, 0},
+    {137, 68, 34, 17},
+};
+
+class OrbNoise {
+public:
+  explicit OrbNoise(uint16_t seed = 0) { reseed(seed); }
+
+  void reseed(uint16_t seed) { mixedSeed = (uint16_t)(seed * 0x9E37u + 0x79B9u); }
+
+  // 1D: one value per lattice point, smoothly eased between them
+  uint8_t at(uint16_t x) const {
+    uint8_t cell = (uint8_t)(x >> 8);
+    uint8_t t = orbReadByte(&orbSmoothstep[x & 0xff]);
+    return orbLerp8(lattice(cell, 0), lattice((uint8_t)(cell + 1), 0), t);
+  }
+
+  // 2D: bilinear between the four corners, eased on both axes
+  uint8_t at(uint16_t x, uint16_t y) const {
+    uint8_t cx = (uint8_t)(x >> 8), cy = (uint8_t)(y >> 8);
+    uint8_t nx = (uint8_t)(cx + 1), ny = (uint8_t)(cy + 1);
+    uint8_t tx = orbReadByte(&orbSmoothstep[x & 0xff]);
+    uint8_t ty = orbReadByte(&orbSmoothstep[y & 0xff]);
+    uint8_t top = orbLerp8(lattice(cx, cy), lattice(nx, cy), tx);
+    uint8_t bottom = orbLerp8(lattice(cx, ny), lattice(nx, ny), tx);
+    return orbLerp8(top, bottom, ty);
+  }
+
+  // 1..4 octaves; each one is offset so they don't share lattice points
+  uint8_t fractal(uint16_t x, uint8_t octaves) const {
+    octaves = clampOctaves(octaves);
+    const uint16_t *weights = orbOctaveWeights[octaves - 1];
+    uint16_t sum = 0;
+    for (uint8_t o = 0; o < octaves; o++) {
+      uint16_t level = at((uint16_t)((x << o) + o * 0x3A7Fu));
+      sum = (uint16_t)(sum + level * orbReadWord(&weights[o]));
+    }
+    return (uint8_t)(sum >> 8);
+  }
+
+  uint8_t fractal(uint16_t x, uint16_t y, uint8_t octaves) const {
+    octaves = clampOctaves(octaves);
+    const uint16_t *weights = orbOctaveWeights[octaves - 1];
+    uint16_t sum = 0;
+    for (uint8_t o = 0; o < octaves; o++) {
+      uint16_t offset = (uint16_t)(o * 0x3A7Fu);
+      uint16_t level = at((uint16_t)((x << o) + offset), (uint16_t)((y << o) + offset));
+      sum = (uint16_t)(sum + level * orbReadWord(&weights[o]));
+    }
+    return (uint8_t)(sum >> 8);
+  }
+
+private:
+  static uint8_t clampOctaves(uint8_t octaves) {
+    return octaves < 1 ? 1 : octaves > 4 ? 4 : octaves;
+  }
+
+  // 16-bit multiply-xorshift; the high byte is the best mixed
+  uint8_t lattice(uint8_t x, uint8_t y) const {
+    uint16_t h = (uint16_t)(x * 0xA3B5u + y * 0x6C8Du + mixedSeed);
+    h ^= h >> 7;
+    h = (uint16_t)(h * 0x2C1Bu);
+    h ^= h >> 9;
+    return (uint8_t)(h >> 8);
+  }
+
+  uint16_t mixedSeed;
+};
+
+// A candle flame: bright, never dark, with slow drift from the first
+// octave and quick flicker from the others. One call per pulse tick.
+//
+// It walks a line through 2D noise rather than along 1D noise: x alone
+// would replay the same flicker every 256 cells (under half a minute),
+// while y drifting at a different rate keeps the path on new cells for
+// about 20 minutes.
+class OrbCandle {
+public:
+  // Lowest level a dip reaches, out of 255
+  static const uint8_t lowest = 96;
+  // Lattice cells per tick in UQ8.8. At the default 20 ms tick x crosses
+  // about nine cells a second, which puts most of the flicker between 2
+  // and 8 Hz (host/candle_noise_sim.cpp).
+  static const uint16_t rateX = 48;
+  static const uint16_t rateY = 7;
+  static const uint8_t octaves = 3;
+
+  void reseed(uint16_t seed) { noise.reseed(seed); }
+
+  uint8_t next() {
+    x = (uint16_t)(x + rateX);
+    y = (uint16_t)(y + rateY);
+    return (uint8_t)(lowest + orbScale8(noise.fractal(x, y, octaves), 255 - lowest));
+  }
+
+private:
+  OrbNoise noise;
+  uint16_t x = 0;
+  uint16_t y = 0;
+};
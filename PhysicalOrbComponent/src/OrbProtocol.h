@@ -0,0 +1,153 @@
+#pragma once
+
+// The Serial1 command language shared by every orb transport:
+// a bare number sets the pulse speed, O/G/R/W set the colour mode and C
+// is a flickering candle (OrbNoise.h) instead of a pulse.
+//
+// '?' asks for a status reply: 's', then how many commands the orb has
+// read and how many bytes it couldn't make sense of, both uint16_t
+// little-endian and wrapping. host/link_monitor.cpp compares them with
+// what it sent to spot dropped commands.
+//
+// 'H' is the controller's heartbeat and the orb answers 'h'. Once an orb
+// has seen one it expects another every orbHeartbeatMs; after
+// orbMissedBeats without one it drops to the safe effect, so a dead
+// controller shows up on the orb itself. Controllers that never send 'H'
+// never trip it.
+//
+// 'P' then a number sets the orb's phase in pulse steps, and 'Z' syncs:
+// from then on the pulse is worked out from the orb's clock since the 'Z'
+// arrived instead of from its own tick count, so orbs synced together
+// stay together. A wave across a street is a phase per orb, sent once,
+// then one 'Z' to the whole group (host/wave_planner.cpp). Send the speed
+// and phase first; a speed change after the 'Z' bends the wave.
+
+#include <stdint.h>
+
+struct OrbCommand {
+  char kind; // 'M' = colour mode, 'S' = pulse speed, 'P' = phase, 'Z' = sync,
+             // '?' = status query, 'H' = heartbeat
+  int value;
+};
+
+const char orbCandleMode = 'C';
+
+const char orbPhase = 'P';
+const char orbSync = 'Z';
+
+const char orbStatusQuery = '?';
+const int orbStatusLength = 5;
+
+inline void orbStatusReply(uint16_t commands, uint16_t errors, uint8_t *out) {
+  out[0] = 's';
+  out[1] = (uint8_t)(commands & 0xff);
+  out[2] = (uint8_t)(commands >> 8);
+  out[3] = (uint8_t)(errors & 0xff);
+  out[4] = (uint8_t)(errors >> 8);
+}
+
+const char orbHeartbeat = 'H';
+const char orbHeartbeatReply = 'h';
+const unsigned long orbHeartbeatMs = 250;
+const int orbMissedBeats = 4;
+
+// What an orb shows once its controller has gone quiet: a slow white pulse
+const char orbSafeMode = 'W';
+const int orbSafeSpeed = 40;
+
+// Heartbeat bookkeeping on the orb. Only arms on the first beat.
+class OrbLiveness {
+public:
+  void beat(unsigned long nowMs) {
+    lastBeatMs = nowMs;
+    armed = true;
+    safe = false;
+  }
+
+  // True once, on the first call after the beats stopped
+  bool lapsed(unsigned long nowMs) {
+    if (!armed || safe || nowMs - lastBeatMs < orbHeartbeatMs * orbMissedBeats) return false;
+    safe = true;
+    return true;
+  }
+
+  bool inSafeEffect() const { return safe; }
+
+private:
+  unsigned long lastBeatMs = 0;
+  bool armed = false;
+  bool safe = false;
+};
+
+// Separators the host may put between commands; not parse errors
+inline bool isOrbSeparator(char c) {
+  return c == ' ' || c == '\n' || c == '\r';
+}
+
+// Byte-at-a-time version of the loop() parser. Digits build up a speed the
+// way Serial1.parseInt() does; any other byte ends the number and may be a
+// mode letter. Returns how many commands were written to out (0..2).
+// A '?' or 'H' comes back as is for the caller to answer, and so does a
+// 'Z', which the caller stamps with the time it arrived.
+class OrbCommandParser {
+public:
+  int feed(char c, OrbCommand *out) {
+    int count = 0;
+    if (c >= '0' && c <= '9') {
+      number = number * 10 + (c - '0');
+      hasNumber = true;
+      return 0;
+    }
+    if (hasNumber) {
+      flush(out[count++]);
+    }
+    phaseNext = false;
+    if (c == 'O' || c == 'G' || c == 'R' || c == 'W' || c == orbCandleMode) {
+      out[count].kind = 'M';
+      out[count].value = c;
+      count++;
+      commands++;
+    } else if (c == orbPhase) {
+      phaseNext = true;
+    } else if (c == orbSync) {
+      out[count].kind = orbSync;
+      out[count].value = 0;
+      count++;
+      commands++;
+    } else if (c == orbStatusQuery || c == orbHeartbeat) {
+      out[count].kind = c;
+      out[count].value = 0;
+      count++;
+    } else if (!isOrbSeparator(c)) {
+      errors++;
+    }
+    return count;
+  }
+
+  // parseInt() gives up after its timeout; the comms task calls this then
+  bool flush(OrbCommand &out) {
+    if (!hasNumber) return false;
+    out.kind = phaseNext ? orbPhase : 'S';
+    out.value = number;
+    number = 0;
+    hasNumber = false;
+    phaseNext = false;
+    commands++;
+    return true;
+  }
+
+  bool pending() const { return hasNumber; }
+
+  // What the status reply counts, wrapping at 16 bits
+  uint16_t commandsRead() const { return commands; }
+
+  // Status reply for a '?'
+  void status(uint8_t *out) const { orbStatusReply(commands, errors, out); }
+
+private:
+  uint16_t commands = 0;
+  uint16_t errors = 0;
+  int number = 0;
+  bool hasNumber = false;
+  bool phaseNext = false; // the number being read follows a 'P'
+};
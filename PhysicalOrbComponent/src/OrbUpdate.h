@@ -0,0 +1,286 @@
+#pragma once
+
+// Firmware updates over the Serial1 link. The host asks for a CRC of every
+// flash block of the running image, sends only the blocks that differ, then
+// asks the orb to verify the whole new image before it switches over.
+//
+//   'U' 'Q'                                  -> 'u' 'Q' blockSize blockCount crc16[blockCount]
+//   'U' 'B' block data[blockSize] crc16      -> 'u' 'K' block  |  'u' 'N' block (resend)
+//   'U' 'A' blockCount crc32                 -> 'u' 'K' then reboot into it  |  'u' 'N'
+//                                               |  'u' 'X' (this orb can't apply updates)
+//
+// Multi-byte fields are little-endian. Changed blocks are written to a
+// staging area; nothing touches the running image until 'A' verifies.
+// Each 'Q' starts a new update, so it drops whatever an earlier one left
+// staged, and 'A' refuses a staged block past the count it was given:
+// the CRC wouldn't cover it.
+// The receiver is plain C++ over a Stream-like link and a Storage type,
+// so host/orb_flash.cpp runs the same code against an in-memory flash.
+//
+// Switching over takes two halves. The sketch's commit() only records
+// that a verified image is staged and resets. On the way back up the
+// bootloader has to copy the staged blocks over the running image, as
+// orbApplyStaged() below does: the app can't rewrite the flash it is
+// running from. So 'K' is only sent by an orb whose bootloader has that
+// step (Storage::canApply()); any other orb answers 'X' and keeps running.
+// 'K' means "verified, rebooting"; the host then reads the block table
+// again to confirm the new image is the one running.
+//
+// That bootloader isn't part of this tree. orbApplyStaged() is what it
+// must do, and orb_flash --sim runs it, but a boot section is written
+// against the bare chip, not against this header. Until an orb has one,
+// the AVR storage below answers 'X'. Off by default in the sketch
+// (ORB_SERIAL_UPDATES in hackathon_LEDS.ino).
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC-16/CCITT-FALSE, per block
+inline uint16_t orbCrc16(const uint8_t *data, size_t length, uint16_t crc = 0xFFFF) {
+  for (size_t i = 0; i < length; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+// CRC-32 (IEEE), over the whole image. Start at 0xFFFFFFFF, invert at the end.
+inline uint32_t orbCrc32(const uint8_t *data, size_t length, uint32_t crc) {
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320UL : crc >> 1;
+    }
+  }
+  return crc;
+}
+
+// Storage needs:
+//   uint16_t blockCount()
+//   void readRunning(uint16_t block, uint8_t *out)
+//   void readStaged(uint16_t block, uint8_t *out)
+//   bool isStaged(uint16_t block)
+//   bool writeStaged(uint16_t block, const uint8_t *data)  (also marks it staged)
+//   void clearStaged()
+//   bool canApply()  the bootloader will run orbApplyStaged()
+//   void commit()  mark the staged image for the bootloader and reset;
+//                  doesn't return on the orb
+template <typename Link, typename Storage, uint16_t BlockSize>
+class OrbUpdateReceiver {
+public:
+  OrbUpdateReceiver(Link &link, Storage &storage) : link(link), storage(storage) {}
+
+  // Call after the 'U' byte has been read
+  void handle() {
+    uint8_t op = 0;
+    if (!readExact(&op, 1)) return;
+    if (op == 'Q') {
+      storage.clearStaged();
+      sendBlockTable();
+    } else if (op == 'B') {
+      receiveBlock();
+    } else if (op == 'A') {
+      applyImage();
+    }
+  }
+
+private:
+  bool readExact(uint8_t *out, size_t length) {
+    return link.readBytes((char *)out, length) == length;
+  }
+
+  uint16_t readU16(bool &ok) {
+    uint8_t raw[2];
+    ok = ok && readExact(raw, 2);
+    return (uint16_t)(raw[0] | (raw[1] << 8));
+  }
+
+  void writeU16(uint16_t value) {
+    uint8_t raw[2] = {(uint8_t)(value & 0xff), (uint8_t)(value >> 8)};
+    link.write(raw, 2);
+  }
+
+  void reply(uint8_t status, uint16_t block) {
+    uint8_t head[2] = {'u', status};
+    link.write(head, 2);
+    writeU16(block);
+  }
+
+  void sendBlockTable() {
+    uint16_t count = storage.blockCount();
+    uint8_t head[2] = {'u', 'Q'};
+    link.write(head, 2);
+    writeU16(BlockSize);
+    writeU16(count);
+    for (uint16_t b = 0; b < count; b++) {
+      storage.readRunning(b, buffer);
+      writeU16(orbCrc16(buffer, BlockSize));
+    }
+  }
+
+  void receiveBlock() {
+    bool ok = true;
+    uint16_t block = readU16(ok);
+    ok = ok && readExact(buffer, BlockSize);
+    uint16_t crc = readU16(ok);
+
+    if (ok && block < storage.blockCount() && crc == orbCrc16(buffer, BlockSize) &&
+        storage.writeStaged(block, buffer)) {
+      reply('K', block);
+    } else {
+      reply('N', block);
+    }
+  }
+
+  bool stagedFrom(uint16_t first) {
+    for (uint16_t b = first; b < storage.blockCount(); b++) {
+      if (storage.isStaged(b)) return true;
+    }
+    return false;
+  }
+
+  // Unchanged blocks come from the running image, changed ones from staging
+  void applyImage() {
+    bool ok = true;
+    uint16_t count = readU16(ok);
+    uint8_t raw[4];
+    ok = ok && readExact(raw, 4);
+    uint32_t expected = (uint32_t)raw[0] | ((uint32_t)raw[1] << 8) | ((uint32_t)raw[2] << 16) |
+                        ((uint32_t)raw[3] << 24);
+
+    if (ok && !storage.canApply()) {
+      reply('X', count);
+      return;
+    }
+    if (ok && count <= storage.blockCount() && !stagedFrom(count)) {
+      uint32_t crc = 0xFFFFFFFFUL;
+      for (uint16_t b = 0; b < count; b++) {
+        if (storage.isStaged(b)) {
+          storage.readStaged(b, buffer);
+        } else {
+          storage.readRunning(b, buffer);
+        }
+        crc = orbCrc32(buffer, BlockSize, crc);
+      }
+      if ((crc ^ 0xFFFFFFFFUL) == expected) {
+        reply('K', count);
+        link.flush();
+        storage.commit();
+        return;
+      }
+    }
+    storage.clearStaged();
+    reply('N', count);
+  }
+
+  Link &link;
+  Storage &storage;
+  uint8_t buffer[BlockSize];
+};
+
+// What the bootloader does with commit(), at every reset before the app
+// starts. BootStorage needs blockCount(), isStaged(), readStaged() and
+// clearStaged() as above, plus:
+//   bool commitPending()
+//   bool writeRunning(uint16_t block, const uint8_t *data)  false: power is going
+//   void clearCommit()
+// A reset part way through leaves the staging and the marker as they were,
+// so the next boot copies again from the start; copying a block twice
+// writes the same bytes. The marker goes last. Returns true if it applied
+// an image.
+template <typename BootStorage, uint16_t BlockSize>
+bool orbApplyStaged(BootStorage &storage) {
+  if (!storage.commitPending()) return false;
+  uint8_t buffer[BlockSize];
+  for (uint16_t b = 0; b < storage.blockCount(); b++) {
+    if (!storage.isStaged(b)) continue;
+    storage.readStaged(b, buffer);
+    if (!storage.writeRunning(b, buffer)) return false;
+  }
+  storage.clearStaged();
+  storage.clearCommit();
+  return true;
+}
+
+#if defined(__AVR__)
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <avr/pgmspace.h>
+#include <avr/wdt.h>
+#include <optiboot.h> // Optiboot 8+: lets the app write flash through the bootloader
+
+// Size of the boot section the orb's bootloader is fused for (BOOTSZ).
+// The staging half starts halfway up what's left, so this has to match
+// the bootloader on the chip, or the two sides disagree on where the
+// staged blocks are.
+#ifndef ORB_BOOT_BYTES
+#define ORB_BOOT_BYTES 4096
+#endif
+
+// Sketch side: stages blocks through Optiboot and hands over at reset.
+// Application flash is split in two: the running image in the lower half
+// and the staging area in the upper half. Which blocks are staged is kept
+// as a bitmap in EEPROM, and the commit marker is the last EEPROM byte.
+// A bootloader with the copy step leaves orbBootSignature in the last
+// flash word but one, below Optiboot's version word; canApply() looks for
+// it there.
+class AvrOrbStorage {
+public:
+  static const uint32_t appBytes = (uint32_t)FLASHEND + 1 - ORB_BOOT_BYTES;
+  static const uint32_t stagingBase = appBytes / 2;
+  static const int bitmapBase = 0;       // EEPROM
+  static const int commitMarker = E2END; // EEPROM
+  static const uint8_t commitValue = 0xA5;
+  static const uint32_t signatureAddress = (uint32_t)FLASHEND - 3;
+  static const uint16_t orbBootSignature = 0x4F42; // "BO"
+
+  uint16_t blockCount() { return (uint16_t)(stagingBase / SPM_PAGESIZE); }
+
+  void readRunning(uint16_t block, uint8_t *out) {
+    readFlash((uint32_t)block * SPM_PAGESIZE, out);
+  }
+
+  void readStaged(uint16_t block, uint8_t *out) {
+    readFlash(stagingBase + (uint32_t)block * SPM_PAGESIZE, out);
+  }
+
+  bool isStaged(uint16_t block) {
+    return EEPROM.read(bitmapBase + block / 8) & (1 << (block % 8));
+  }
+
+  bool writeStaged(uint16_t block, const uint8_t *data) {
+    uint32_t address = stagingBase + (uint32_t)block * SPM_PAGESIZE;
+    optiboot_page_erase(address);
+    for (uint16_t i = 0; i < SPM_PAGESIZE; i += 2) {
+      optiboot_page_fill(address + i, (uint16_t)(data[i] | (data[i + 1] << 8)));
+    }
+    optiboot_page_write(address);
+    EEPROM.update(bitmapBase + block / 8, EEPROM.read(bitmapBase + block / 8) | (1 << (block % 8)));
+    return true;
+  }
+
+  void clearStaged() {
+    for (uint16_t i = 0; i < (blockCount() + 7) / 8; i++) {
+      EEPROM.update(bitmapBase + i, 0);
+    }
+  }
+
+  bool canApply() { return pgm_read_word_far(signatureAddress) == orbBootSignature; }
+
+  void commit() {
+    EEPROM.update(commitMarker, commitValue);
+    wdt_enable(WDTO_15MS);
+    for (;;) {
+    }
+  }
+
+private:
+  static void readFlash(uint32_t address, uint8_t *out) {
+    for (uint16_t i = 0; i < SPM_PAGESIZE; i++) {
+      out[i] = pgm_read_byte_far(address + i);
+    }
+  }
+};
+#endif